@@ -0,0 +1,99 @@
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
+
+// Bus policies for LIS2DW12T<Bus>. Each provides:
+//   bool begin(int a, int b, uint32_t clockHz);
+//   bool write(uint8_t reg, const uint8_t* buf, size_t len);
+//   bool read(uint8_t reg, uint8_t* buf, size_t len);
+//   static constexpr size_t MAX_BURST;   // bytes per read() transaction
+// Multi-byte access relies on CTRL2.IF_ADD_INC (set by begin()).
+
+class LIS2DW12_I2C {
+public:
+#ifdef I2C_BUFFER_LENGTH
+  static constexpr size_t MAX_BURST = I2C_BUFFER_LENGTH;
+#else
+  static constexpr size_t MAX_BURST = 32;
+#endif
+
+  LIS2DW12_I2C(TwoWire& wire = Wire, uint8_t addr = 0x18) : _wire(wire), _addr(addr) {}
+
+  // a/b = SDA/SCL (-1: already begun)
+  bool begin(int sda, int scl, uint32_t clockHz) {
+    if (sda >= 0 && scl >= 0) _wire.begin(sda, scl);
+    _wire.setClock(clockHz);
+    return true;
+  }
+
+  bool write(uint8_t reg, const uint8_t* buf, size_t len) {
+    _wire.beginTransmission(_addr);
+    _wire.write(reg);
+    _wire.write(buf, len);
+    return _wire.endTransmission() == 0;
+  }
+
+  bool read(uint8_t reg, uint8_t* buf, size_t len) {
+    _wire.beginTransmission(_addr);
+    _wire.write(reg);
+    if (_wire.endTransmission(false) != 0) return false;
+    if (_wire.requestFrom((int)_addr, (int)len) != (int)len) return false;
+    for (size_t i=0; i<len; i++) buf[i] = _wire.read();
+    return true;
+  }
+
+  TwoWire& wire() const { return _wire; }
+  uint8_t address() const { return _addr; }
+
+private:
+  TwoWire& _wire;
+  uint8_t  _addr;
+};
+
+// 4-wire SPI, mode 3, up to 10 MHz. SPIClass must already be begun with
+// the right SCK/MISO/MOSI pins; CS is driven here.
+class LIS2DW12_SPI {
+public:
+  static constexpr size_t MAX_BURST = 32 * 6; // whole FIFO in one transfer
+
+  LIS2DW12_SPI(SPIClass& spi = SPI, int8_t csPin = 5, uint32_t clockHz = 10000000)
+  : _spi(spi), _cs(csPin), _clockHz(clockHz) {}
+
+  // a/b unused; clockHz > 0 overrides the constructor clock
+  bool begin(int /*a*/, int /*b*/, uint32_t clockHz) {
+    if (clockHz) _clockHz = clockHz;
+    if (_clockHz > 10000000) _clockHz = 10000000;
+    pinMode(_cs, OUTPUT);
+    digitalWrite(_cs, HIGH);
+    return true;
+  }
+
+  bool write(uint8_t reg, const uint8_t* buf, size_t len) {
+    _spi.beginTransaction(SPISettings(_clockHz, MSBFIRST, SPI_MODE3));
+    digitalWrite(_cs, LOW);
+    _spi.transfer(reg & 0x7F);
+    for (size_t i=0; i<len; i++) _spi.transfer(buf[i]);
+    digitalWrite(_cs, HIGH);
+    _spi.endTransaction();
+    return true;
+  }
+
+  bool read(uint8_t reg, uint8_t* buf, size_t len) {
+    _spi.beginTransaction(SPISettings(_clockHz, MSBFIRST, SPI_MODE3));
+    digitalWrite(_cs, LOW);
+    _spi.transfer(reg | 0x80);
+    memset(buf, 0, len);
+    _spi.transfer(buf, len);
+    digitalWrite(_cs, HIGH);
+    _spi.endTransaction();
+    return true;
+  }
+
+  SPIClass& spi() const { return _spi; }
+
+private:
+  SPIClass& _spi;
+  int8_t    _cs;
+  uint32_t  _clockHz;
+};
@@ -1,88 +1,138 @@
 #include "LIS2DW12_ESP32.h"
 #include <math.h>
-#include <Preferences.h>
-
-static constexpr uint32_t CAL_VERSION = 1;
-
-struct CalBlob {
-  uint32_t version;
-  uint8_t  enabled;
-  float    offset_g[3];
-  float    scale[3];
-  uint32_t crc;
-};
-
-static uint32_t crc32_simple(const uint8_t* data, size_t len) {
-  uint32_t c = 0xA5A5A5A5u;
-  for (size_t i=0; i<len; i++) {
-    c ^= data[i];
-    c = (c << 5) | (c >> 27);
-    c += 0x9E3779B9u;
-  }
-  return c;
-}
+#include <string.h>
 
-LIS2DW12::LIS2DW12(TwoWire& wire, uint8_t i2cAddr)
-: _wire(wire), _addr(i2cAddr) {}
+#ifdef ARDUINO
+static inline void waitMs(uint32_t ms) { delay(ms); }
+#else
+static inline void waitMs(uint32_t) {} // host: the mock has no sample clock
+#endif
 
-bool LIS2DW12::begin(int sda, int scl, uint32_t clockHz) {
-  if (sda >= 0 && scl >= 0) {
-    _wire.begin(sda, scl);
-  }
-  _wire.setClock(clockHz);
+template <class Bus>
+bool LIS2DW12T<Bus>::begin(int sda, int scl, uint32_t clockHz) {
+  if (!_bus.begin(sda, scl, clockHz)) return false;
 
   if (!probe()) return false;
 
+  _shadowValid = 0;
+  syncShadow();
   setBDU(true);
   setAutoIncrement(true);
 
   return true;
 }
 
-bool LIS2DW12::probe() {
+template <class Bus>
+bool LIS2DW12T<Bus>::probe() {
   return whoAmI() == WHOAMI_VALUE;
 }
 
-uint8_t LIS2DW12::whoAmI() {
+template <class Bus>
+uint8_t LIS2DW12T<Bus>::whoAmI() {
   uint8_t v = 0;
   if (!readReg(REG_WHOAMI, v)) return 0;
   return v;
 }
 
-bool LIS2DW12::applyConfig(const Config& cfg) {
-  if (!setBDU(cfg.bdu)) return false;
-  if (!setAutoIncrement(cfg.autoInc)) return false;
-  if (!setPowerMode(cfg.odr, cfg.mode, cfg.lpMode)) return false;
-  if (!setScaleAndFilters(cfg.fs, cfg.lowNoise, cfg.bw)) return false;
+template <class Bus>
+bool LIS2DW12T<Bus>::applyConfig(const Config& cfg) {
+  // Register-by-register this is 6 transactions (2x read-modify-write on
+  // CTRL2, CTRL1, CTRL6); here it is one burst write of the changed span.
+  static constexpr uint32_t NAIVE_TX = 6;
+  const uint32_t tx0 = _txCount;
+
+  if ((_shadowValid & 0x3F) != 0x3F && !syncShadow()) return false;
+
+  uint8_t next[6];
+  memcpy(next, _shadow, sizeof(next));
+  next[0] = ctrl1Value(cfg.odr, cfg.mode, cfg.lpMode);
+  next[1] &= ~((1 << 3) | (1 << 2));
+  if (cfg.bdu)     next[1] |= (1 << 3);
+  if (cfg.autoInc) next[1] |= (1 << 2);
+  next[5] = ctrl6Value(cfg.fs, cfg.lowNoise, cfg.bw, false);
+
+  int first = -1, last = -1;
+  for (int i = 0; i < 6; i++) {
+    if (next[i] != _shadow[i]) {
+      if (first < 0) first = i;
+      last = i;
+    }
+  }
+
+  if (first >= 0) {
+    const size_t len = size_t(last - first + 1);
+    if (len > 1 && (_shadow[1] & (1 << 2))) {
+      // IF_ADD_INC is on now, so one transaction covers the span
+      _txCount++;
+      if (!_bus.write(uint8_t(REG_CTRL1 + first), &next[first], len)) {
+        _shadowValid = 0;
+        return false;
+      }
+      memcpy(&_shadow[first], &next[first], len);
+    } else {
+      for (int i = first; i <= last; i++)
+        if (!writeReg(uint8_t(REG_CTRL1 + i), next[i])) return false;
+    }
+  }
+
+  _odr = cfg.odr;
+  _mode = cfg.mode;
+  _lpMode = cfg.lpMode;
+  _fs = cfg.fs;
+
+  const uint32_t used = _txCount - tx0;
+  if (used < NAIVE_TX) _txSaved += NAIVE_TX - used;
   return true;
 }
 
-bool LIS2DW12::setPowerMode(Odr odr, Mode mode, LowPowerMode lpMode) {
-  uint8_t v = (uint8_t(odr) << 4) | (uint8_t(mode) << 2) | uint8_t(lpMode);
-  if (!writeReg(REG_CTRL1, v)) return false;
-
-  _odr = odr;
-  _mode = mode;
-  _lpMode = lpMode;
+template <class Bus>
+bool LIS2DW12T<Bus>::syncShadow() {
+  uint8_t b[6];
+  if (!readBytes(REG_CTRL1, b, sizeof(b))) return false;
+  uint8_t c7 = 0;
+  if (!readBytes(REG_CTRL7, &c7, 1)) return false;
+  memcpy(_shadow, b, sizeof(b));
+  _shadow[1] &= ~((1 << 7) | (1 << 6)); // BOOT / SOFT_RESET self-clear
+  _shadow[SHADOW_N - 1] = c7;
+  _shadowValid = (1 << SHADOW_N) - 1;
   return true;
 }
 
-bool LIS2DW12::setScaleAndFilters(FullScale fs, bool lowNoise, Bandwidth bw, bool highPassPathFDS) {
+uint8_t LIS2DW12Base::ctrl1Value(Odr odr, Mode mode, LowPowerMode lpMode) {
+  return (uint8_t(odr) << 4) | (uint8_t(mode) << 2) | uint8_t(lpMode);
+}
+
+uint8_t LIS2DW12Base::ctrl6Value(FullScale fs, bool lowNoise, Bandwidth bw, bool highPassPathFDS) {
   uint8_t v = (uint8_t(bw) << 6) | (uint8_t(fs) << 4);
   if (highPassPathFDS) v |= (1 << 3);
   if (lowNoise)        v |= (1 << 2);
+  return v;
+}
+
+template <class Bus>
+bool LIS2DW12T<Bus>::setPowerMode(Odr odr, Mode mode, LowPowerMode lpMode) {
+  if (!writeReg(REG_CTRL1, ctrl1Value(odr, mode, lpMode))) return false;
+
+  _odr = odr;
+  _mode = mode;
+  _lpMode = lpMode;
+  return true;
+}
 
-  if (!writeReg(REG_CTRL6, v)) return false;
+template <class Bus>
+bool LIS2DW12T<Bus>::setScaleAndFilters(FullScale fs, bool lowNoise, Bandwidth bw, bool highPassPathFDS) {
+  if (!writeReg(REG_CTRL6, ctrl6Value(fs, lowNoise, bw, highPassPathFDS))) return false;
   _fs = fs;
   return true;
 }
 
-bool LIS2DW12::setRateHz(uint16_t hz) {
+template <class Bus>
+bool LIS2DW12T<Bus>::setRateHz(uint16_t hz) {
   Odr odr = odrFromHz(hz);
   return setPowerMode(odr, _mode, _lpMode);
 }
 
-LIS2DW12::Odr LIS2DW12::odrFromHz(uint16_t hz) {
+LIS2DW12Base::Odr LIS2DW12Base::odrFromHz(uint16_t hz) {
   if (hz == 0) return Odr::PowerDown;
   if (hz <= 2)  return Odr::Hz12_5_or_1_6;
   if (hz <= 13) return Odr::Hz12_5;
@@ -95,15 +145,18 @@ LIS2DW12::Odr LIS2DW12::odrFromHz(uint16_t hz) {
   return Odr::Hz1600_or_200;
 }
 
-bool LIS2DW12::setBDU(bool enable) {
+template <class Bus>
+bool LIS2DW12T<Bus>::setBDU(bool enable) {
   return readModifyWrite(REG_CTRL2, (1 << 3), enable ? (1 << 3) : 0);
 }
 
-bool LIS2DW12::setAutoIncrement(bool enable) {
+template <class Bus>
+bool LIS2DW12T<Bus>::setAutoIncrement(bool enable) {
   return readModifyWrite(REG_CTRL2, (1 << 2), enable ? (1 << 2) : 0);
 }
 
-bool LIS2DW12::readRaw(int16_t& x, int16_t& y, int16_t& z) {
+template <class Bus>
+bool LIS2DW12T<Bus>::readRaw(int16_t& x, int16_t& y, int16_t& z) {
   uint8_t b[6];
   if (!readBytes(REG_OUT_X_L_ADDR, b, 6)) return false;
   x = (int16_t)(uint16_t(b[1]) << 8 | b[0]);
@@ -112,16 +165,18 @@ bool LIS2DW12::readRaw(int16_t& x, int16_t& y, int16_t& z) {
   return true;
 }
 
-bool LIS2DW12::readRaw(int16_t out[3]) {
+template <class Bus>
+bool LIS2DW12T<Bus>::readRaw(int16_t out[3]) {
   return readRaw(out[0], out[1], out[2]);
 }
 
-uint8_t LIS2DW12::activeResolutionBits() const {
+uint8_t LIS2DW12Base::activeResolutionBits() const {
   if (_mode == Mode::LowPower && _lpMode == LowPowerMode::LP1_12bit) return 12;
   return 14;
 }
 
-bool LIS2DW12::readRawAligned(int16_t& x, int16_t& y, int16_t& z) {
+template <class Bus>
+bool LIS2DW12T<Bus>::readRawAligned(int16_t& x, int16_t& y, int16_t& z) {
   if (!readRaw(x, y, z)) return false;
 
   uint8_t bits = activeResolutionBits();
@@ -133,11 +188,66 @@ bool LIS2DW12::readRawAligned(int16_t& x, int16_t& y, int16_t& z) {
   return true;
 }
 
-bool LIS2DW12::readRawAligned(int16_t out[3]) {
+template <class Bus>
+bool LIS2DW12T<Bus>::readRawAligned(int16_t out[3]) {
   return readRawAligned(out[0], out[1], out[2]);
 }
 
-float LIS2DW12::sensitivity_mg_per_lsb(uint8_t resBits, FullScale fs) const {
+// ---------- FIFO ----------
+template <class Bus>
+bool LIS2DW12T<Bus>::setFifo(FifoMode mode, uint8_t threshold) {
+  if (threshold > FIFO_DEPTH - 1) threshold = FIFO_DEPTH - 1;
+  uint8_t v = (uint8_t(mode) << 5) | (threshold & 0x1F);
+  if (!writeReg(REG_FIFO_CTRL, v)) return false;
+  _fifoMode = mode;
+  return true;
+}
+
+template <class Bus>
+bool LIS2DW12T<Bus>::readFifoStatus(FifoStatus& st) {
+  uint8_t v = 0;
+  if (!readReg(REG_FIFO_SAMPLES, v)) return false;
+  st.level     = v & 0x3F;
+  st.overrun   = (v & (1 << 6)) != 0;
+  st.watermark = (v & (1 << 7)) != 0;
+  return true;
+}
+
+template <class Bus>
+bool LIS2DW12T<Bus>::readFifoBurst(int16_t (*out)[3], size_t n, bool aligned) {
+  // With FIFO enabled and IF_ADD_INC set, the address pointer rolls back from
+  // OUT_Z_H (0x2D) to OUT_X_L (0x28), so several samples come out of one read.
+  // Bus::MAX_BURST bounds one read (Wire rx buffer); keep it a multiple of 6.
+  constexpr size_t FIFO_BURST_MAX_SAMPLES = Bus::MAX_BURST / 6;
+  const uint8_t shift = aligned ? ((activeResolutionBits() == 12) ? 4 : 2) : 0;
+  uint8_t b[FIFO_BURST_MAX_SAMPLES * 6];
+
+  size_t done = 0;
+  while (done < n) {
+    size_t take = n - done;
+    if (take > FIFO_BURST_MAX_SAMPLES) take = FIFO_BURST_MAX_SAMPLES;
+    if (!readBytes(REG_OUT_X_L_ADDR, b, take * 6)) return false;
+
+    for (size_t i = 0; i < take; i++) {
+      const uint8_t* p = &b[i * 6];
+      out[done + i][0] = (int16_t)((int16_t)(uint16_t(p[1]) << 8 | p[0]) >> shift);
+      out[done + i][1] = (int16_t)((int16_t)(uint16_t(p[3]) << 8 | p[2]) >> shift);
+      out[done + i][2] = (int16_t)((int16_t)(uint16_t(p[5]) << 8 | p[4]) >> shift);
+    }
+    done += take;
+  }
+  return true;
+}
+
+template <class Bus>
+bool LIS2DW12T<Bus>::routeInt1(uint8_t mask, bool pulsed) {
+  // H_LACTIVE=0, PP_OD=0 -> active high push-pull
+  if (!readModifyWrite(REG_CTRL3, (1 << 5) | (1 << 3), 0)) return false;
+  if (!readModifyWrite(REG_CTRL7, (1 << 7), pulsed ? (1 << 7) : 0)) return false;
+  return writeReg(REG_CTRL4_INT1, mask);
+}
+
+float LIS2DW12Base::sensitivity_mg_per_lsb(uint8_t resBits, FullScale fs) const {
   const bool is12 = (resBits == 12);
   switch (fs) {
     case FullScale::G2:  return is12 ? 0.976f : 0.244f;
@@ -148,12 +258,12 @@ float LIS2DW12::sensitivity_mg_per_lsb(uint8_t resBits, FullScale fs) const {
   return is12 ? 0.976f : 0.244f;
 }
 
-float LIS2DW12::alignedRawToG(int16_t alignedRaw, uint8_t resBits, FullScale fs) const {
+float LIS2DW12Base::alignedRawToG(int16_t alignedRaw, uint8_t resBits, FullScale fs) const {
   float mg_per_lsb = sensitivity_mg_per_lsb(resBits, fs);
   return (float(alignedRaw) * mg_per_lsb) / 1000.0f;
 }
 
-int16_t LIS2DW12::quantizeAlignedRaw(int16_t alignedRaw, uint8_t fromBits, uint8_t toBits) const {
+int16_t LIS2DW12Base::quantizeAlignedRaw(int16_t alignedRaw, uint8_t fromBits, uint8_t toBits) const {
   if (toBits == 0 || toBits >= fromBits) return alignedRaw;
   uint8_t drop = fromBits - toBits;
 
@@ -162,17 +272,18 @@ int16_t LIS2DW12::quantizeAlignedRaw(int16_t alignedRaw, uint8_t fromBits, uint8
   return q;
 }
 
-bool LIS2DW12::readG_uncal(float& gx, float& gy, float& gz) {
+template <class Bus>
+bool LIS2DW12T<Bus>::readG_uncal(float& gx, float& gy, float& gz) {
   int16_t ax, ay, az;
   if (!readRawAligned(ax, ay, az)) return false;
 
   uint8_t res = activeResolutionBits();
 
+  // floored to _qBits but still in res-bit LSBs, so res keeps the scale
   if (_qBits == 10 || _qBits == 12 || _qBits == 14) {
     ax = quantizeAlignedRaw(ax, res, _qBits);
     ay = quantizeAlignedRaw(ay, res, _qBits);
     az = quantizeAlignedRaw(az, res, _qBits);
-    res = _qBits;
   }
 
   gx = alignedRawToG(ax, res, _fs);
@@ -181,31 +292,34 @@ bool LIS2DW12::readG_uncal(float& gx, float& gy, float& gz) {
   return true;
 }
 
-void LIS2DW12::applyCalibration(float& gx, float& gy, float& gz) const {
+void LIS2DW12Base::applyCalibration(float& gx, float& gy, float& gz) const {
   if (!_cal.enabled) return;
   gx = (gx - _cal.offset_g[0]) * _cal.scale[0];
   gy = (gy - _cal.offset_g[1]) * _cal.scale[1];
   gz = (gz - _cal.offset_g[2]) * _cal.scale[2];
 }
 
-bool LIS2DW12::readG(float& gx, float& gy, float& gz) {
+template <class Bus>
+bool LIS2DW12T<Bus>::readG(float& gx, float& gy, float& gz) {
   if (!readG_uncal(gx, gy, gz)) return false;
   applyCalibration(gx, gy, gz);
   return true;
 }
 
-bool LIS2DW12::readG(float out_g[3]) {
+template <class Bus>
+bool LIS2DW12T<Bus>::readG(float out_g[3]) {
   return readG(out_g[0], out_g[1], out_g[2]);
 }
 
 // ---------- Calibration ----------
-bool LIS2DW12::calibrateStatic(uint16_t samples, uint16_t sampleDelayMs, float expectedZ_g) {
+template <class Bus>
+bool LIS2DW12T<Bus>::calibrateStatic(uint16_t samples, uint16_t sampleDelayMs, float expectedZ_g) {
   if (samples < 10) samples = 10;
 
   for (int i = 0; i < 10; i++) {
     float gx, gy, gz;
     readG_uncal(gx, gy, gz);
-    delay(sampleDelayMs);
+    waitMs(sampleDelayMs);
   }
 
   double sx=0, sy=0, sz=0;
@@ -213,7 +327,7 @@ bool LIS2DW12::calibrateStatic(uint16_t samples, uint16_t sampleDelayMs, float e
     float gx, gy, gz;
     if (!readG_uncal(gx, gy, gz)) return false;
     sx += gx; sy += gy; sz += gz;
-    delay(sampleDelayMs);
+    waitMs(sampleDelayMs);
   }
 
   float mx = float(sx / samples);
@@ -231,20 +345,21 @@ bool LIS2DW12::calibrateStatic(uint16_t samples, uint16_t sampleDelayMs, float e
   return true;
 }
 
-void LIS2DW12::setAxisScaleFromMeasured(uint8_t axis, float measured_g, float expected_g) {
+void LIS2DW12Base::setAxisScaleFromMeasured(uint8_t axis, float measured_g, float expected_g) {
   if (axis > 2) return;
   if (fabsf(measured_g) < 1e-6f) return;
   _cal.scale[axis] = expected_g / measured_g;
   _cal.enabled = true;
 }
 
-bool LIS2DW12::collectPoseAverage(Pose /*pose*/, float outAvg_g[3], uint16_t samples, uint16_t sampleDelayMs) {
+template <class Bus>
+bool LIS2DW12T<Bus>::collectPoseAverage(Pose /*pose*/, float outAvg_g[3], uint16_t samples, uint16_t sampleDelayMs) {
   if (samples < 10) samples = 10;
 
   for (int i=0; i<10; i++) {
     float gx, gy, gz;
     readG_uncal(gx, gy, gz);
-    delay(sampleDelayMs);
+    waitMs(sampleDelayMs);
   }
 
   double sx=0, sy=0, sz=0;
@@ -252,7 +367,7 @@ bool LIS2DW12::collectPoseAverage(Pose /*pose*/, float outAvg_g[3], uint16_t sam
     float gx, gy, gz;
     if (!readG_uncal(gx, gy, gz)) return false;
     sx += gx; sy += gy; sz += gz;
-    delay(sampleDelayMs);
+    waitMs(sampleDelayMs);
   }
   outAvg_g[0] = float(sx / samples);
   outAvg_g[1] = float(sy / samples);
@@ -260,7 +375,7 @@ bool LIS2DW12::collectPoseAverage(Pose /*pose*/, float outAvg_g[3], uint16_t sam
   return true;
 }
 
-bool LIS2DW12::calibrate6PositionFromAverages(const float meas[6][3]) {
+bool LIS2DW12Base::calibrate6PositionFromAverages(const float meas[6][3]) {
   const float mxp = meas[(int)Pose::Xp][0];
   const float mxn = meas[(int)Pose::Xn][0];
   const float myp = meas[(int)Pose::Yp][1];
@@ -286,7 +401,9 @@ bool LIS2DW12::calibrate6PositionFromAverages(const float meas[6][3]) {
   return true;
 }
 
-bool LIS2DW12::calibrate6PositionInteractive(Stream& s, uint16_t samples, uint16_t sampleDelayMs) {
+#ifdef ARDUINO
+template <class Bus>
+bool LIS2DW12T<Bus>::calibrate6PositionInteractive(Stream& s, uint16_t samples, uint16_t sampleDelayMs) {
   float meas[6][3] = {0};
 
   auto waitEnter = [&](const char* msg) {
@@ -325,81 +442,57 @@ bool LIS2DW12::calibrate6PositionInteractive(Stream& s, uint16_t samples, uint16
   }
   return ok;
 }
-
-// ---------- NVS ----------
-bool LIS2DW12::saveCalibrationNVS(const char* nameSpace, const char* key) {
-  Preferences pref;
-  if (!pref.begin(nameSpace, false)) return false;
-
-  CalBlob b{};
-  b.version = CAL_VERSION;
-  b.enabled = _cal.enabled ? 1 : 0;
-  for (int i=0; i<3; i++) { b.offset_g[i] = _cal.offset_g[i]; b.scale[i] = _cal.scale[i]; }
-  b.crc = 0;
-  b.crc = crc32_simple(reinterpret_cast<const uint8_t*>(&b), sizeof(CalBlob) - sizeof(uint32_t));
-
-  size_t written = pref.putBytes(key, &b, sizeof(b));
-  pref.end();
-  return written == sizeof(b);
-}
-
-bool LIS2DW12::loadCalibrationNVS(const char* nameSpace, const char* key) {
-  Preferences pref;
-  if (!pref.begin(nameSpace, true)) return false;
-
-  CalBlob b{};
-  size_t got = pref.getBytes(key, &b, sizeof(b));
-  pref.end();
-  if (got != sizeof(b)) return false;
-  if (b.version != CAL_VERSION) return false;
-
-  uint32_t crc = crc32_simple(reinterpret_cast<const uint8_t*>(&b), sizeof(CalBlob) - sizeof(uint32_t));
-  if (crc != b.crc) return false;
-
-  _cal.enabled = (b.enabled != 0);
-  for (int i=0; i<3; i++) { _cal.offset_g[i] = b.offset_g[i]; _cal.scale[i] = b.scale[i]; }
-  return true;
-}
-
-bool LIS2DW12::clearCalibrationNVS(const char* nameSpace, const char* key) {
-  Preferences pref;
-  if (!pref.begin(nameSpace, false)) return false;
-  bool ok = pref.remove(key);
-  pref.end();
-  return ok;
-}
+#endif
 
 // ---------- Low-level ----------
-bool LIS2DW12::writeReg(uint8_t reg, uint8_t val) {
-  _wire.beginTransmission(_addr);
-  _wire.write(reg);
-  _wire.write(val);
-  return _wire.endTransmission() == 0;
-}
-
-bool LIS2DW12::readReg(uint8_t reg, uint8_t& val) {
-  _wire.beginTransmission(_addr);
-  _wire.write(reg);
-  if (_wire.endTransmission(false) != 0) return false;
-  if (_wire.requestFrom((int)_addr, 1) != 1) return false;
-  val = _wire.read();
+template <class Bus>
+bool LIS2DW12T<Bus>::writeReg(uint8_t reg, uint8_t val) {
+  const int i = shadowIndex(reg);
+  if (i >= 0 && (_shadowValid & (1 << i)) && _shadow[i] == val) {
+    _txSaved++;
+    return true;
+  }
+  _txCount++;
+  if (!_bus.write(reg, &val, 1)) {
+    if (i >= 0) _shadowValid &= ~(1 << i);
+    return false;
+  }
+  if (i >= 0) {
+    _shadow[i] = (reg == REG_CTRL2) ? (val & ~((1 << 7) | (1 << 6))) : val;
+    _shadowValid |= (1 << i);
+  }
   return true;
 }
 
-bool LIS2DW12::readBytes(uint8_t startReg, uint8_t* buf, size_t len) {
-  _wire.beginTransmission(_addr);
-  _wire.write(startReg);
-  if (_wire.endTransmission(false) != 0) return false;
-  int got = _wire.requestFrom((int)_addr, (int)len);
-  if (got != (int)len) return false;
-  for (size_t i=0; i<len; i++) buf[i] = _wire.read();
+template <class Bus>
+bool LIS2DW12T<Bus>::readReg(uint8_t reg, uint8_t& val) {
+  _txCount++;
+  if (!_bus.read(reg, &val, 1)) return false;
+  const int i = shadowIndex(reg);
+  if (i >= 0) {
+    _shadow[i] = (reg == REG_CTRL2) ? (val & ~((1 << 7) | (1 << 6))) : val;
+    _shadowValid |= (1 << i);
+  }
   return true;
 }
 
-bool LIS2DW12::readModifyWrite(uint8_t reg, uint8_t clearMask, uint8_t setMask) {
+template <class Bus>
+bool LIS2DW12T<Bus>::readModifyWrite(uint8_t reg, uint8_t clearMask, uint8_t setMask) {
   uint8_t v = 0;
-  if (!readReg(reg, v)) return false;
+  const int i = shadowIndex(reg);
+  if (i >= 0 && (_shadowValid & (1 << i))) {
+    v = _shadow[i];
+    _txSaved++;
+  } else if (!readReg(reg, v)) {
+    return false;
+  }
   v &= ~clearMask;
   v |= setMask;
   return writeReg(reg, v);
 }
+
+#ifdef ARDUINO
+template class LIS2DW12T<LIS2DW12_I2C>;
+template class LIS2DW12T<LIS2DW12_SPI>;
+#endif
+template class LIS2DW12T<LIS2DW12_Mock>;
@@ -1,17 +1,36 @@
 #pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <utility>
+#ifdef ARDUINO
 #include <Arduino.h>
-#include <Wire.h>
+#include "LIS2DW12_Bus.h" // I2C / SPI policies (Wire, SPI)
+#endif
+#include "LIS2DW12_MockBus.h"
 
-class LIS2DW12 {
+// Without ARDUINO (host build) only LIS2DW12_Host is available: no I2C/SPI
+// policies, no NVS storage, no interactive calibration.
+
+// Bus-independent part: register map, config types, conversion and
+// calibration math. LIS2DW12T<Bus> adds everything that touches the bus.
+class LIS2DW12Base {
 public:
   // Registers
   static constexpr uint8_t REG_WHOAMI  = 0x0F; // WHO_AM_I => 0x44
   static constexpr uint8_t REG_CTRL1   = 0x20; // ODR + MODE + LP_MODE
   static constexpr uint8_t REG_CTRL2   = 0x21; // BDU + IF_ADD_INC + ...
+  static constexpr uint8_t REG_CTRL3   = 0x22; // PP_OD + LIR + H_LACTIVE + ...
+  static constexpr uint8_t REG_CTRL4_INT1 = 0x23; // INT1 routing
+  static constexpr uint8_t REG_CTRL5_INT2 = 0x24; // INT2 routing
   static constexpr uint8_t REG_CTRL6   = 0x25; // BW_FILT + FS + LOW_NOISE
+  static constexpr uint8_t REG_STATUS  = 0x27; // DRDY + FIFO_THS + ...
   static constexpr uint8_t REG_OUT_X_L_ADDR = 0x28; // 6 bytes burst
+  static constexpr uint8_t REG_FIFO_CTRL    = 0x2E; // FMODE[7:5] + FTH[4:0]
+  static constexpr uint8_t REG_FIFO_SAMPLES = 0x2F; // FIFO_FTH + FIFO_OVR + DIFF[5:0]
+  static constexpr uint8_t REG_CTRL7   = 0x3F; // DRDY_PULSED + INTERRUPTS_ENABLE + ...
 
   static constexpr uint8_t WHOAMI_VALUE = 0x44;
+  static constexpr uint8_t FIFO_DEPTH   = 32;
 
   // CTRL1 fields
   enum class Odr : uint8_t {
@@ -55,6 +74,26 @@ public:
     ODR_div20 = 0b11
   };
 
+  // FIFO_CTRL FMODE
+  enum class FifoMode : uint8_t {
+    Bypass       = 0b000,
+    Fifo         = 0b001, // stop when full
+    ContToFifo   = 0b011,
+    BypassToCont = 0b100,
+    Continuous   = 0b110  // overwrite oldest when full
+  };
+
+  struct FifoStatus {
+    uint8_t level     = 0;     // unread samples (0..32)
+    bool    watermark = false; // level >= FTH
+    bool    overrun   = false; // FIFO full, oldest sample overwritten
+  };
+
+  // CTRL4_INT1_PAD_CTRL bits (OR together)
+  static constexpr uint8_t INT1_DRDY  = 1 << 0;
+  static constexpr uint8_t INT1_FTH   = 1 << 1;
+  static constexpr uint8_t INT1_DIFF5 = 1 << 2; // FIFO full
+
   struct Config {
     Odr          odr      = Odr::Hz100;
     Mode         mode     = Mode::HighPerf;
@@ -78,8 +117,83 @@ public:
   };
 
 public:
-  LIS2DW12(TwoWire& wire = Wire, uint8_t i2cAddr = 0x18);
+  uint8_t activeResolutionBits() const;
+
+  float sensitivity_mg_per_lsb(uint8_t resBits, FullScale fs) const;
+  float alignedRawToG(int16_t alignedRaw, uint8_t resBits, FullScale fs) const;
+
+  void setOutputQuantization(uint8_t bits) { _qBits = bits; }
+  uint8_t getOutputQuantization() const { return _qBits; }
+
+  bool calibrate6PositionFromAverages(const float meas[6][3]);
+
+  void setAxisScaleFromMeasured(uint8_t axis /*0:X 1:Y 2:Z*/, float measured_g, float expected_g);
+
+  void setCalibration(const Calibration& c) { _cal = c; }
+  Calibration getCalibration() const { return _cal; }
+  void clearCalibration() { _cal = Calibration(); }
+
+#ifdef ARDUINO
+  // Preferences storage, LIS2DW12_NVS.cpp
+  bool saveCalibrationNVS(const char* nameSpace = "lis2dw12", const char* key = "cal");
+  bool loadCalibrationNVS(const char* nameSpace = "lis2dw12", const char* key = "cal");
+  bool clearCalibrationNVS(const char* nameSpace = "lis2dw12", const char* key = "cal");
+#endif
+
+  FullScale getFullScale() const { return _fs; }
+  Mode getMode() const { return _mode; }
+  LowPowerMode getLowPowerMode() const { return _lpMode; }
+  Odr getOdr() const { return _odr; }
+  FifoMode getFifoMode() const { return _fifoMode; }
+
+  // Bus transactions issued / avoided by the CTRL1..CTRL7 shadow cache.
+  uint32_t busTransactions() const { return _txCount; }
+  uint32_t busTransactionsSaved() const { return _txSaved; }
+  // Forget cached CTRL values (e.g. after a soft reset or external writes).
+  void invalidateShadow() { _shadowValid = 0; }
+
+protected:
+  FullScale _fs = FullScale::G2;
+  Mode _mode = Mode::HighPerf;
+  LowPowerMode _lpMode = LowPowerMode::LP2_14bit;
+  Odr _odr = Odr::Hz100;
+  FifoMode _fifoMode = FifoMode::Bypass;
+
+  Calibration _cal;
+  uint8_t _qBits = 0;
 
+  // Shadow of CTRL1..CTRL6 (0x20..0x25) + CTRL7 (0x3F); bit i of
+  // _shadowValid set = _shadow[i] mirrors the device.
+  static constexpr uint8_t SHADOW_N = 7;
+  uint8_t  _shadow[SHADOW_N] = {0};
+  uint8_t  _shadowValid = 0;
+  uint32_t _txCount = 0;
+  uint32_t _txSaved = 0;
+
+  static int shadowIndex(uint8_t reg) {
+    if (reg >= REG_CTRL1 && reg <= REG_CTRL6) return reg - REG_CTRL1;
+    if (reg == REG_CTRL7) return SHADOW_N - 1;
+    return -1;
+  }
+  static uint8_t ctrl1Value(Odr odr, Mode mode, LowPowerMode lpMode);
+  static uint8_t ctrl6Value(FullScale fs, bool lowNoise, Bandwidth bw, bool highPassPathFDS);
+
+  void applyCalibration(float& gx, float& gy, float& gz) const;
+  int16_t quantizeAlignedRaw(int16_t alignedRaw, uint8_t fromBits, uint8_t toBits) const;
+
+  static Odr odrFromHz(uint16_t hz);
+};
+
+// Bus is a compile-time policy (LIS2DW12_I2C, LIS2DW12_SPI, LIS2DW12_Mock):
+// register access is a direct, inlinable call - no virtual dispatch.
+template <class Bus>
+class LIS2DW12T : public LIS2DW12Base {
+public:
+  // Arguments are forwarded to the Bus constructor, e.g. (Wire, 0x18).
+  template <class... Args>
+  explicit LIS2DW12T(Args&&... args) : _bus(std::forward<Args>(args)...) {}
+
+  // I2C: sda/scl pins (-1 = already begun). SPI: pins unused, clockHz = SCK.
   bool begin(int sda = -1, int scl = -1, uint32_t clockHz = 400000);
 
   bool probe();
@@ -102,61 +216,48 @@ public:
   bool readRawAligned(int16_t& x, int16_t& y, int16_t& z);
   bool readRawAligned(int16_t out[3]);
 
-  bool readG(float& gx, float& gy, float& gz);
-  bool readG(float out_g[3]);
+  // FIFO: threshold is the watermark level (0..31) used by FIFO_FTH / INT1_FTH.
+  bool setFifo(FifoMode mode, uint8_t threshold = 0);
+  bool readFifoStatus(FifoStatus& st);
+  // Drains n samples (n <= FIFO level) with auto-increment bursts;
+  // out is XYZ-interleaved int16 (Sample6-compatible layout).
+  bool readFifoBurst(int16_t (*out)[3], size_t n, bool aligned = true);
 
-  uint8_t activeResolutionBits() const;
+  // INT1 pad: route sources (INT1_* mask, 0 = none), active-high push-pull.
+  // pulsed=true makes DRDY a short pulse instead of a latched level.
+  bool routeInt1(uint8_t mask, bool pulsed = false);
 
-  float sensitivity_mg_per_lsb(uint8_t resBits, FullScale fs) const;
-  float alignedRawToG(int16_t alignedRaw, uint8_t resBits, FullScale fs) const;
-
-  void setOutputQuantization(uint8_t bits) { _qBits = bits; }
-  uint8_t getOutputQuantization() const { return _qBits; }
+  bool readG(float& gx, float& gy, float& gz);
+  bool readG(float out_g[3]);
 
   bool calibrateStatic(uint16_t samples = 500, uint16_t sampleDelayMs = 5, float expectedZ_g = 1.0f);
 
   bool collectPoseAverage(Pose pose, float outAvg_g[3], uint16_t samples = 500, uint16_t sampleDelayMs = 5);
-  bool calibrate6PositionFromAverages(const float meas[6][3]);
+#ifdef ARDUINO
   bool calibrate6PositionInteractive(Stream& s, uint16_t samples = 500, uint16_t sampleDelayMs = 5);
+#endif
 
-  void setAxisScaleFromMeasured(uint8_t axis /*0:X 1:Y 2:Z*/, float measured_g, float expected_g);
-
-  void setCalibration(const Calibration& c) { _cal = c; }
-  Calibration getCalibration() const { return _cal; }
-  void clearCalibration() { _cal = Calibration(); }
-
-  bool saveCalibrationNVS(const char* nameSpace = "lis2dw12", const char* key = "cal");
-  bool loadCalibrationNVS(const char* nameSpace = "lis2dw12", const char* key = "cal");
-  bool clearCalibrationNVS(const char* nameSpace = "lis2dw12", const char* key = "cal");
-
+  // CTRL registers go through the shadow cache: unchanged writes are skipped.
   bool writeReg(uint8_t reg, uint8_t val);
   bool readReg(uint8_t reg, uint8_t& val);
-  bool readBytes(uint8_t startReg, uint8_t* buf, size_t len);
+  bool readBytes(uint8_t startReg, uint8_t* buf, size_t len) {
+    _txCount++;
+    return _bus.read(startReg, buf, len);
+  }
+  // Reload the shadow from the device (CTRL1..CTRL6 burst + CTRL7).
+  bool syncShadow();
 
-  uint8_t address() const { return _addr; }
-  TwoWire& wire() const { return _wire; }
-  FullScale getFullScale() const { return _fs; }
-  Mode getMode() const { return _mode; }
-  LowPowerMode getLowPowerMode() const { return _lpMode; }
-  Odr getOdr() const { return _odr; }
+  Bus& bus() { return _bus; }
 
 private:
-  TwoWire& _wire;
-  uint8_t  _addr;
-
-  FullScale _fs = FullScale::G2;
-  Mode _mode = Mode::HighPerf;
-  LowPowerMode _lpMode = LowPowerMode::LP2_14bit;
-  Odr _odr = Odr::Hz100;
-
-  Calibration _cal;
-  uint8_t _qBits = 0;
+  Bus _bus;
 
   bool readModifyWrite(uint8_t reg, uint8_t clearMask, uint8_t setMask);
-  void applyCalibration(float& gx, float& gy, float& gz) const;
-
   bool readG_uncal(float& gx, float& gy, float& gz);
-  int16_t quantizeAlignedRaw(int16_t alignedRaw, uint8_t fromBits, uint8_t toBits) const;
-
-  static Odr odrFromHz(uint16_t hz);
 };
+
+#ifdef ARDUINO
+using LIS2DW12      = LIS2DW12T<LIS2DW12_I2C>;
+using LIS2DW12_Spi  = LIS2DW12T<LIS2DW12_SPI>;
+#endif
+using LIS2DW12_Host = LIS2DW12T<LIS2DW12_Mock>;
@@ -0,0 +1,118 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// In-memory LIS2DW12 register file for LIS2DW12T<LIS2DW12_Mock>.
+// No Arduino dependency: lets driver / recording logic run on a host.
+// Models WHO_AM_I, IF_ADD_INC auto-increment, OUT_X..OUT_Z, STATUS.DRDY
+// and the 32-level FIFO (bypass / FIFO / continuous) incl. FIFO_SAMPLES.
+class LIS2DW12_Mock {
+public:
+  static constexpr size_t MAX_BURST = 32 * 6;
+  static constexpr uint8_t NREGS = 0x40;
+
+  LIS2DW12_Mock() { reset(); }
+
+  void reset() {
+    memset(regs, 0, sizeof(regs));
+    regs[0x0F] = 0x44; // WHO_AM_I
+    regs[0x21] = 0x04; // CTRL2 reset value: IF_ADD_INC
+    _head = _count = 0;
+    _ovr = false;
+    reads = writes = bytesRead = bytesWritten = 0;
+    failNext = 0;
+  }
+
+  bool begin(int, int, uint32_t) { return true; }
+
+  bool write(uint8_t reg, const uint8_t* buf, size_t len) {
+    if (consumeFailure()) return false;
+    writes++;
+    bytesWritten += len;
+    for (size_t i=0; i<len; i++) {
+      if (reg < NREGS) regs[reg] = buf[i];
+      if (reg == 0x2E && fifoMode() == 0) { _count = 0; _ovr = false; } // bypass clears FIFO
+      if (autoInc()) reg++;
+    }
+    return true;
+  }
+
+  bool read(uint8_t reg, uint8_t* buf, size_t len) {
+    if (consumeFailure()) return false;
+    reads++;
+    bytesRead += len;
+    for (size_t i=0; i<len; i++) {
+      if (reg == 0x28 && fifoMode() != 0) popFifo(); // next sample into OUT regs
+      if (reg == 0x2F) regs[0x2F] = fifoSamplesReg();
+      buf[i] = (reg < NREGS) ? regs[reg] : 0;
+      if (reg == 0x2D) regs[0x27] &= ~0x01; // DRDY cleared once Z_H is read
+      if (autoInc()) reg = (reg == 0x2D && fifoMode() != 0) ? 0x28 : uint8_t(reg + 1);
+    }
+    return true;
+  }
+
+  // One sensor ODR tick: left-justified 16-bit output words.
+  void pushSample(int16_t x, int16_t y, int16_t z) {
+    if (fifoMode() == 0) {
+      setOut(x, y, z);
+      regs[0x27] |= 0x01; // DRDY
+      return;
+    }
+    if (_count == FIFO_DEPTH) {
+      if (fifoMode() == 0b001) { _ovr = true; return; } // FIFO mode: stop when full
+      _head = (_head + 1) % FIFO_DEPTH;                   // continuous: overwrite oldest
+      _count--;
+      _ovr = true;
+    }
+    int16_t* s = _fifo[(_head + _count) % FIFO_DEPTH];
+    s[0] = x; s[1] = y; s[2] = z;
+    _count++;
+    regs[0x27] |= 0x01;
+  }
+
+  uint8_t fifoLevel() const { return _count; }
+
+  uint8_t regs[NREGS];
+  uint32_t reads, writes, bytesRead, bytesWritten;
+  uint32_t failNext; // next N transactions fail (bus error injection)
+
+private:
+  static constexpr uint8_t FIFO_DEPTH = 32;
+  int16_t _fifo[FIFO_DEPTH][3];
+  uint8_t _head, _count;
+  bool _ovr;
+
+  bool autoInc() const { return (regs[0x21] & (1 << 2)) != 0; }
+  uint8_t fifoMode() const { return regs[0x2E] >> 5; }
+
+  bool consumeFailure() {
+    if (!failNext) return false;
+    failNext--;
+    return true;
+  }
+
+  uint8_t fifoSamplesReg() const {
+    uint8_t fth = regs[0x2E] & 0x1F;
+    uint8_t v = _count & 0x3F;
+    if (_ovr) v |= (1 << 6);
+    if (_count >= fth && fth) v |= (1 << 7);
+    return v;
+  }
+
+  void popFifo() {
+    if (!_count) return;
+    const int16_t* s = _fifo[_head];
+    setOut(s[0], s[1], s[2]);
+    _head = (_head + 1) % FIFO_DEPTH;
+    _count--;
+    _ovr = false;
+    if (!_count) regs[0x27] &= ~0x01;
+  }
+
+  void setOut(int16_t x, int16_t y, int16_t z) {
+    regs[0x28] = uint8_t(x); regs[0x29] = uint8_t(uint16_t(x) >> 8);
+    regs[0x2A] = uint8_t(y); regs[0x2B] = uint8_t(uint16_t(y) >> 8);
+    regs[0x2C] = uint8_t(z); regs[0x2D] = uint8_t(uint16_t(z) >> 8);
+  }
+};
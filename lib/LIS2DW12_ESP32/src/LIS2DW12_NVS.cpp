@@ -0,0 +1,68 @@
+// Calibration storage in NVS (Preferences); Arduino only.
+#ifdef ARDUINO
+#include "LIS2DW12_ESP32.h"
+#include <Preferences.h>
+
+static constexpr uint32_t CAL_VERSION = 1;
+
+struct CalBlob {
+  uint32_t version;
+  uint8_t  enabled;
+  float    offset_g[3];
+  float    scale[3];
+  uint32_t crc;
+};
+
+static uint32_t crc32_simple(const uint8_t* data, size_t len) {
+  uint32_t c = 0xA5A5A5A5u;
+  for (size_t i=0; i<len; i++) {
+    c ^= data[i];
+    c = (c << 5) | (c >> 27);
+    c += 0x9E3779B9u;
+  }
+  return c;
+}
+
+// ---------- NVS ----------
+bool LIS2DW12Base::saveCalibrationNVS(const char* nameSpace, const char* key) {
+  Preferences pref;
+  if (!pref.begin(nameSpace, false)) return false;
+
+  CalBlob b{};
+  b.version = CAL_VERSION;
+  b.enabled = _cal.enabled ? 1 : 0;
+  for (int i=0; i<3; i++) { b.offset_g[i] = _cal.offset_g[i]; b.scale[i] = _cal.scale[i]; }
+  b.crc = 0;
+  b.crc = crc32_simple(reinterpret_cast<const uint8_t*>(&b), sizeof(CalBlob) - sizeof(uint32_t));
+
+  size_t written = pref.putBytes(key, &b, sizeof(b));
+  pref.end();
+  return written == sizeof(b);
+}
+
+bool LIS2DW12Base::loadCalibrationNVS(const char* nameSpace, const char* key) {
+  Preferences pref;
+  if (!pref.begin(nameSpace, true)) return false;
+
+  CalBlob b{};
+  size_t got = pref.getBytes(key, &b, sizeof(b));
+  pref.end();
+  if (got != sizeof(b)) return false;
+  if (b.version != CAL_VERSION) return false;
+
+  uint32_t crc = crc32_simple(reinterpret_cast<const uint8_t*>(&b), sizeof(CalBlob) - sizeof(uint32_t));
+  if (crc != b.crc) return false;
+
+  _cal.enabled = (b.enabled != 0);
+  for (int i=0; i<3; i++) { _cal.offset_g[i] = b.offset_g[i]; _cal.scale[i] = b.scale[i]; }
+  return true;
+}
+
+bool LIS2DW12Base::clearCalibrationNVS(const char* nameSpace, const char* key) {
+  Preferences pref;
+  if (!pref.begin(nameSpace, false)) return false;
+  bool ok = pref.remove(key);
+  pref.end();
+  return ok;
+}
+#endif
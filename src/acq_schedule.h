@@ -0,0 +1,114 @@
+#pragma once
+
+// Acquisition timing without the hardware: which source wakes the capture
+// loop, how often, when it gives up on a missed edge, and whether a drain
+// is followed by a sleep or by another drain. acq_source.h arms the real
+// sources; tools/acq_schedule_sim.cpp runs the same decisions against a
+// simulated edge source and the mock FIFO.
+#include <stdint.h>
+
+// Wake-up source for the recording task. Samples always come out of the
+// LIS2DW12 FIFO (sensor ODR is the sample clock); the source only decides
+// when the task wakes up to drain it.
+enum class AcqSource : uint8_t
+{
+  Timer = 0, // free-running hw_timer (fallback when INT1 is not wired)
+  Int1Fifo,  // FIFO watermark on INT1 -> GPIO ISR
+  Int1Drdy,  // data-ready on INT1 -> GPIO ISR
+  Sim,       // esp_timer callback standing in for INT1 (no hardware needed)
+};
+
+struct AcqSchedule
+{
+  uint8_t wtm = 16;        // FIFO watermark; task sleeps only below this level
+  uint32_t periodUs = 0;   // expected time between wake-ups
+  uint32_t timeoutMs = 10; // missed-edge guard: drain anyway after this
+};
+
+inline bool acqSourceNeedsInt1(AcqSource src)
+{
+  return src == AcqSource::Int1Fifo || src == AcqSource::Int1Drdy;
+}
+
+inline AcqSchedule acqScheduleFor(AcqSource src, uint16_t hz, uint8_t fifoDepth)
+{
+  AcqSchedule s;
+  if (!hz)
+    hz = 1;
+
+  s.wtm = (src == AcqSource::Int1Drdy) ? 1 : (uint8_t)(fifoDepth / 2);
+  // Slow ODRs: half a second at most, so the watermark edge comes before
+  // the (capped) timeout instead of every wake-up being a timeout.
+  if (s.wtm > hz / 2)
+    s.wtm = (hz >= 2) ? (uint8_t)(hz / 2) : 1;
+
+  const uint32_t wtmUs = (uint32_t)((uint64_t)s.wtm * 1000000ULL / hz);
+  // Polled sources tick twice per watermark window to keep FIFO headroom.
+  s.periodUs = (src == AcqSource::Timer || src == AcqSource::Sim) ? wtmUs / 2 : wtmUs;
+  if (s.periodUs < 500)
+    s.periodUs = 500;
+
+  // A missed edge must be caught well before the FIFO (fifoDepth samples) fills.
+  const uint32_t guard = (src == AcqSource::Int1Drdy) ? fifoDepth / 2 : (s.wtm + fifoDepth) / 2;
+  s.timeoutMs = guard * 1000UL / hz;
+  if (s.timeoutMs < 2)
+    s.timeoutMs = 2;
+  if (s.timeoutMs > 1000)
+    s.timeoutMs = 1000;
+  return s;
+}
+
+// Drain / sleep decision of the capture loop plus the wake-up interval
+// bookkeeping behind the jitter figure. The caller does the waiting.
+class AcqPacer
+{
+public:
+  explicit AcqPacer(const AcqSchedule &sch) : _sch(sch) {}
+
+  // After a drain that saw `level` samples: true = sleep until the next
+  // wake-up, false = drain again right away (catching up; a wake-up
+  // interval that spans a catch-up is not measured).
+  bool shouldWait(uint8_t level)
+  {
+    if (level < _sch.wtm)
+      return true;
+    _haveLast = false;
+    return false;
+  }
+
+  // Outcome of the wait at nowUs. true with jitterUs = |interval - period|
+  // when two wake-ups in a row came from the source.
+  bool waited(bool woke, int64_t nowUs, uint32_t &jitterUs)
+  {
+    if (!woke)
+    {
+      _timeouts++;
+      _haveLast = false;
+      return false;
+    }
+    _wakeups++;
+    const bool have = _haveLast;
+    if (have)
+    {
+      const int64_t dev = (nowUs - _lastWakeUs) - (int64_t)_sch.periodUs;
+      jitterUs = (uint32_t)(dev < 0 ? -dev : dev);
+    }
+    _lastWakeUs = nowUs;
+    _haveLast = true;
+    return have;
+  }
+
+  // Bus error: the next interval does not describe the source.
+  void lostTrack() { _haveLast = false; }
+
+  const AcqSchedule &schedule() const { return _sch; }
+  uint32_t wakeups() const { return _wakeups; }
+  uint32_t timeouts() const { return _timeouts; }
+
+private:
+  AcqSchedule _sch;
+  int64_t _lastWakeUs = 0;
+  bool _haveLast = false;
+  uint32_t _wakeups = 0;
+  uint32_t _timeouts = 0;
+};
@@ -0,0 +1,159 @@
+#include "acq_source.h"
+
+#include <esp_timer.h>
+
+#include "app_state.h"
+#include "config.h"
+
+static TaskHandle_t s_waiter = nullptr;
+static AcqSource s_src = AcqSource::Timer;
+static bool s_running = false;
+
+static hw_timer_t *timer0 = nullptr;
+static esp_timer_handle_t simTimer = nullptr;
+
+// ======================= Wake-up ISRs =======================
+static void IRAM_ATTR onAcqIsr()
+{
+  BaseType_t hpw = pdFALSE;
+  if (s_waiter)
+    vTaskNotifyGiveFromISR(s_waiter, &hpw);
+  if (hpw)
+    portYIELD_FROM_ISR();
+}
+
+static void onSimTimer(void * /*arg*/)
+{
+  // esp_timer task context, same notification path as the GPIO ISR
+  if (s_waiter)
+    xTaskNotifyGive(s_waiter);
+}
+
+static bool startTimerUs(uint32_t period_us)
+{
+  timer0 = timerBegin(0, 80, true); // 80MHz/80=1MHz tick
+  if (!timer0)
+    return false;
+  timerAttachInterrupt(timer0, &onAcqIsr, true);
+  timerAlarmWrite(timer0, period_us, true);
+  timerAlarmEnable(timer0);
+  return true;
+}
+
+static void stopTimer()
+{
+  if (!timer0)
+    return;
+  timerAlarmDisable(timer0);
+  timerDetachInterrupt(timer0);
+  timerEnd(timer0);
+  timer0 = nullptr;
+}
+
+// ======================= Names =======================
+const char *acqSourceName(AcqSource src)
+{
+  switch (src)
+  {
+  case AcqSource::Timer:
+    return "timer";
+  case AcqSource::Int1Fifo:
+    return "int1_fifo";
+  case AcqSource::Int1Drdy:
+    return "int1_drdy";
+  case AcqSource::Sim:
+    return "sim";
+  }
+  return "timer";
+}
+
+bool acqSourceFromName(const String &name, AcqSource &out)
+{
+  const AcqSource all[] = {AcqSource::Timer, AcqSource::Int1Fifo, AcqSource::Int1Drdy, AcqSource::Sim};
+  for (auto s : all)
+    if (name == acqSourceName(s))
+    {
+      out = s;
+      return true;
+    }
+  return false;
+}
+
+// ======================= Start / wait / stop =======================
+bool acqStart(AcqSource src, const AcqSchedule &sch, TaskHandle_t waiter)
+{
+  acqStop();
+  s_waiter = waiter;
+  s_src = src;
+  g_acqWakeups = 0;
+  g_acqTimeouts = 0;
+  ulTaskNotifyTake(pdTRUE, 0); // drop stale notifications
+
+  bool ok = false;
+  switch (src)
+  {
+  case AcqSource::Int1Fifo:
+  case AcqSource::Int1Drdy:
+    if (LIS_INT1_PIN >= 0)
+    {
+      pinMode(LIS_INT1_PIN, INPUT);
+      attachInterrupt(digitalPinToInterrupt(LIS_INT1_PIN), onAcqIsr, RISING);
+      ok = true;
+    }
+    break;
+  case AcqSource::Timer:
+    ok = startTimerUs(sch.periodUs);
+    break;
+  case AcqSource::Sim:
+  {
+    esp_timer_create_args_t args = {};
+    args.callback = &onSimTimer;
+    args.name = "acqSim";
+    ok = esp_timer_create(&args, &simTimer) == ESP_OK &&
+         esp_timer_start_periodic(simTimer, sch.periodUs) == ESP_OK;
+    break;
+  }
+  }
+
+  s_running = ok;
+  if (!ok)
+    s_waiter = nullptr;
+  return ok;
+}
+
+bool acqWait(const AcqSchedule &sch)
+{
+  if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sch.timeoutMs)) > 0)
+  {
+    g_acqWakeups = g_acqWakeups + 1;
+    return true;
+  }
+  g_acqTimeouts = g_acqTimeouts + 1;
+  return false;
+}
+
+void acqStop()
+{
+  if (!s_running)
+    return;
+  switch (s_src)
+  {
+  case AcqSource::Int1Fifo:
+  case AcqSource::Int1Drdy:
+    detachInterrupt(digitalPinToInterrupt(LIS_INT1_PIN));
+    break;
+  case AcqSource::Timer:
+    stopTimer();
+    break;
+  case AcqSource::Sim:
+    if (simTimer)
+    {
+      esp_timer_stop(simTimer);
+      esp_timer_delete(simTimer);
+      simTimer = nullptr;
+    }
+    break;
+  }
+  s_running = false;
+  s_waiter = nullptr;
+}
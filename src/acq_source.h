@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "acq_schedule.h"
+
+const char *acqSourceName(AcqSource src);
+bool acqSourceFromName(const String &name, AcqSource &out);
+
+// Arms the source; wake-ups are delivered as task notifications to waiter.
+bool acqStart(AcqSource src, const AcqSchedule &sch, TaskHandle_t waiter);
+// Blocks until the next wake-up; false on timeout.
+bool acqWait(const AcqSchedule &sch);
+void acqStop();
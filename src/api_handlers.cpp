@@ -3,12 +3,26 @@
 #include <LittleFS.h>
 #include <WiFi.h>
 #include <Update.h>
-#include <arduinoFFT.h>
+#include <esp_timer.h>
 
 #include "LIS2DW12_ESP32.h"
 #include "api_handlers.h"
 #include "config.h"
+#include "decimator.h"
+#include "envelope.h"
+#include "event_push.h"
 #include "html_pages.h"
+#include "live_sampler.h"
+#include "live_spectrum.h"
+#include "rec_pack.h"
+#include "rec_reader.h"
+#include "rec_writer.h"
+#include "sample_convert.h"
+#include "sensor_service.h"
+#include "stft.h"
+#include "stream_session.h"
+#include "vib_severity.h"
+#include "welch_psd.h"
 #include <string.h>
 
 static String versionJson()
@@ -20,48 +34,20 @@ static String versionJson()
   s += "}";
   return s;
 }
-#define FFT_N 1024 // power of 2
-#define FFT_WINDOW FFT_WIN_TYP_HANN
-
-// ======================= I2C mutex =======================
-
-// ======================= Timer =======================
-static volatile uint32_t dueCount = 0;
-static hw_timer_t *timer0 = nullptr;
-static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
-
-void IRAM_ATTR onTimer()
-{
-  portENTER_CRITICAL_ISR(&mux);
-  dueCount++;
-  portEXIT_CRITICAL_ISR(&mux);
-}
-
-bool startTimerHz(uint16_t hz)
-{
-  if (!hz)
-    return false;
-  uint32_t period_us = 1000000UL / hz;
-  timer0 = timerBegin(0, 80, true); // 80MHz/80=1MHz tick
-  timerAttachInterrupt(timer0, &onTimer, true);
-  timerAlarmWrite(timer0, period_us, true);
-  timerAlarmEnable(timer0);
-  return true;
-}
-
-void stopTimer()
-{
-  if (!timer0)
-    return;
-  timerAlarmDisable(timer0);
-  timerDetachInterrupt(timer0);
-  timerEnd(timer0);
-  timer0 = nullptr;
-}
+#define FFT_N 1024 // default Welch segment (power of 2, up to FFT_MAX_N)
+#define FFT_OVERLAP_PCT 50
+#define FFT_ALL_MAX_N 2048 // axis=all: 4 channels of segment + sums (~72 kB at 2048 with mag=1)
+#define STFT_N 512 // default spectrogram frame
+#define STFT_TARGET_FRAMES 400 // default hop aims at this many rows
+#define STFT_MAX_FRAMES 4096
+#define STFT_SEND_BYTES 2048 // rows are batched into chunks of about this size
+#define ANALYZE_BLOCK 256 // samples per read/convert pass
+#define ANALYZE_INDEX_MIN_BLOCKS 64 // shorter files are scanned: cheap, and finer than one point per block
 
 // State lives in app_state.cpp
 static void resetLivePreviewState()
 {
+  portENTER_CRITICAL(&g_liveMux);
   g_liveLastMs = 0;
   for (int i = 0; i < 3; i++)
   {
@@ -73,6 +59,7 @@ static void resetLivePreviewState()
   g_live_mag_acc = 0;
   g_live_mag_vel_mmps = 0;
   g_live_mag_disp_mm = 0;
+  portEXIT_CRITICAL(&g_liveMux);
 }
 
 // ======================= Helpers =======================
@@ -121,26 +108,121 @@ static String makeNewFileNameFromUI(const String &ts12)
   return base + "_" + String(millis()) + ".dat";
 }
 
-static bool rewriteHeaderSamples(const String &path, uint32_t samplesWritten)
+// Acquisition health (rec_trailer.h) for /api/info and /api/analyze.
+static String healthJson(const RecHealth &h)
 {
-  if (!fileExists(path))
-    return false;
-  File f = LittleFS.open(path, "r+");
-  if (!f)
-    return false;
+  String s = "{";
+  s += "\"i2cErrors\":" + String(h.i2cErrors) + ",";
+  s += "\"skippedTicks\":" + String(h.skippedTicks) + ",";
+  s += "\"duplicates\":" + String(h.duplicates) + ",";
+  s += "\"fifoOverruns\":" + String(h.fifoOverruns) + ",";
+  s += "\"ringDropped\":" + String(h.ringDropped) + ",";
+  s += "\"wakeups\":" + String(h.wakeups) + ",";
+  s += "\"periodUs\":" + String(h.periodUs) + ",";
+  s += "\"jitterMaxUs\":" + String(h.jitterMaxUs) + ",";
+  s += "\"clean\":";
+  s += (h.i2cErrors || h.skippedTicks || h.duplicates || h.fifoOverruns || h.ringDropped) ? "false" : "true";
+  // bin 0: < 1 us, bin b: [2^(b-1), 2^b) us
+  s += ",\"jitterHist\":[";
+  for (size_t i = 0; i < REC_JITTER_BINS; i++)
+  {
+    if (i)
+      s += ",";
+    s += h.jitter[i];
+  }
+  s += "]}";
+  return s;
+}
 
-  FileHeaderV3 h{};
-  size_t got = f.read((uint8_t *)&h, sizeof(h));
-  if (got != sizeof(h))
+// Recording features (rec_features.h) in g for /api/analyze; compact: the
+// handful /api/list carries per file.
+static String featuresJson(const RecFeatures &f, const ConvCoeffs &cc, bool compact)
+{
+  RecFeatureStats st[3];
+  for (int a = 0; a < 3; a++)
+    st[a] = recFeatureStats(f, a, cc.k[a], cc.b[a]);
+  auto arr = [&](const char *key, float RecFeatureStats::*m, int dec)
   {
-    f.close();
-    return false;
+    return "\"" + String(key) + "\":[" + String(st[0].*m, dec) + "," + String(st[1].*m, dec) + "," +
+           String(st[2].*m, dec) + "]";
+  };
+
+  String s = "{";
+  s += arr("rms", &RecFeatureStats::rms, 5) + ",";
+  s += arr("crest", &RecFeatureStats::crest, 2) + ",";
+  s += arr("kurt", &RecFeatureStats::kurt, 2) + ",";
+  s += "\"clip\":[" + String(st[0].clip) + "," + String(st[1].clip) + "," + String(st[2].clip) + "]";
+  if (compact)
+    return s + "}";
+  s += ",\"samples\":" + String(f.n) + ",";
+  s += arr("mean", &RecFeatureStats::mean, 5) + ",";
+  s += arr("std", &RecFeatureStats::std, 5) + ",";
+  s += arr("peak", &RecFeatureStats::peak, 5) + ",";
+  s += arr("pp", &RecFeatureStats::pp, 5) + ",";
+  s += arr("skew", &RecFeatureStats::skew, 3) + ",";
+  // histogram bin b of axis a: [lo + b * step, lo + (b + 1) * step) g
+  s += "\"hist_lo_g\":[";
+  for (int a = 0; a < 3; a++)
+    s += String(cc.k[a] * f.histLo + cc.b[a], 4) + (a < 2 ? "," : "],");
+  s += "\"hist_step_g\":[";
+  for (int a = 0; a < 3; a++)
+    s += String(cc.k[a] * (float)(1L << f.histShift), 5) + (a < 2 ? "," : "],");
+  s += "\"hist\":[";
+  for (int a = 0; a < 3; a++)
+  {
+    s += "[";
+    for (size_t b = 0; b < REC_FEAT_BINS; b++)
+    {
+      if (b)
+        s += ",";
+      s += f.axis[a].hist[b];
+    }
+    s += (a < 2 ? "]," : "]");
   }
-  h.samples = samplesWritten;
-  f.seek(0, SeekSet);
-  size_t wrote = f.write((uint8_t *)&h, sizeof(h));
-  f.close();
-  return wrote == sizeof(h);
+  s += "]}";
+  return s;
+}
+
+// "YYMMDDHHMMSS" + sec, calendar aware (20YY, leap years).
+static String tsAddSeconds(const String &ts12, uint32_t sec)
+{
+  int yy = ts12.substring(0, 2).toInt();
+  int mo = ts12.substring(2, 4).toInt();
+  int dd = ts12.substring(4, 6).toInt();
+  uint32_t t = ts12.substring(6, 8).toInt() * 3600UL + ts12.substring(8, 10).toInt() * 60UL +
+               ts12.substring(10, 12).toInt() + sec;
+  uint32_t days = t / 86400UL;
+  t %= 86400UL;
+  static const uint8_t dim[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  while (days--)
+  {
+    int last = dim[(mo - 1) % 12] + ((mo == 2 && (yy % 4) == 0) ? 1 : 0);
+    if (++dd > last)
+    {
+      dd = 1;
+      if (++mo > 12)
+      {
+        mo = 1;
+        yy = (yy + 1) % 100;
+      }
+    }
+  }
+  char out[13];
+  snprintf(out, sizeof(out), "%02d%02d%02d%02lu%02lu%02lu", yy, mo, dd,
+           (unsigned long)(t / 3600), (unsigned long)(t / 60 % 60), (unsigned long)(t % 60));
+  return String(out);
+}
+
+// Continuous mode: /accel<start of this segment>_NN.dat, NN = segment % 100.
+// Called by the writer task; reads only what recordJob fixed before starting.
+static String s_segBaseTs;
+static uint16_t s_segRateHz = 1;
+
+static String segmentPath(uint32_t seg, uint64_t firstSample)
+{
+  char suf[8];
+  snprintf(suf, sizeof(suf), "_%02u", (unsigned)(seg % 100));
+  return "/accel" + tsAddSeconds(s_segBaseTs, (uint32_t)(firstSample / s_segRateHz)) + String(suf) + ".dat";
 }
 
 static LIS2DW12::FullScale fsFromG(uint8_t fs_g)
@@ -197,37 +279,6 @@ static const char *poseName(int step)
 }
 
 // ---- Analysis helpers ----
-static float mgPerLsb(uint8_t res_bits, uint8_t fs_g)
-{
-  // AN5038 Table 15
-  const bool is12 = (res_bits == 12);
-  switch (fs_g)
-  {
-  case 2:
-    return is12 ? 0.976f : 0.244f;
-  case 4:
-    return is12 ? 1.952f : 0.488f;
-  case 8:
-    return is12 ? 3.904f : 0.976f;
-  case 16:
-    return is12 ? 7.808f : 1.952f;
-  default:
-    return is12 ? 0.976f : 0.244f;
-  }
-}
-
-static float rawAlignedToG(int16_t rawAligned, uint8_t res_bits, uint8_t fs_g)
-{
-  // aligned raw already right-aligned (12/14)
-  float mg = mgPerLsb(res_bits, fs_g);
-  return (float)rawAligned * (mg / 1000.0f);
-}
-
-static float applyCal1(float g, float offset, float scale)
-{
-  return (g - offset) * scale;
-}
-
 static float rmsFromSumSq(double sumSq, uint32_t n)
 {
   return (n > 0) ? sqrtf((float)(sumSq / (double)n)) : 0.0f;
@@ -263,6 +314,31 @@ static String buildFilesJsonNow()
       out += "{";
       out += "\"name\":\"" + name + "\",";
       out += "\"size\":" + String((uint32_t)f.size());
+
+      // header is already at hand: format + compression ratio per file
+      FileHeaderV3 h{};
+      const uint32_t size = f.size();
+      if (size >= sizeof(h) && f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) && recHeaderOk(h))
+      {
+        const uint32_t hdrBytes = recHeaderBytes(h.version);
+        const RecTrailer tr = recScanTrailer(size, hdrBytes, [&f](uint32_t off, void *dst, size_t len)
+                                             { return f.seek(off, SeekSet) && f.read((uint8_t *)dst, len) == len; });
+        const bool indexed = tr.indexed;
+        const uint32_t dataEnd = tr.dataEnd;
+        const float ratio = (h.version == 4 && h.samples && dataEnd > hdrBytes)
+                                ? (float)h.samples * sizeof(Sample6) / (float)(dataEnd - hdrBytes)
+                                : 1.0f;
+        out += ",\"version\":" + String(h.version);
+        out += ",\"samples\":" + String(h.samples);
+        out += ",\"ratio\":" + String(ratio, 2);
+        out += ",\"indexed\":" + String(indexed ? "true" : "false");
+        // features chunk: summary without touching the samples
+        const int fi = tr.find("FEAT");
+        RecFeatures ft;
+        if (fi >= 0 && tr.chunk[fi].bytes == sizeof(ft) && f.seek(tr.chunk[fi].offset, SeekSet) &&
+            f.read((uint8_t *)&ft, sizeof(ft)) == sizeof(ft) && recCrc32(0, &ft, sizeof(ft)) == tr.chunk[fi].crc)
+          out += ",\"feat\":" + featuresJson(ft, convCoeffsFromHeader(h), true);
+      }
       out += "}";
     }
 
@@ -308,33 +384,14 @@ static String fsInfoJson()
   return s;
 }
 
-// ======================= Recording task =======================
-static void recordTask(void * /*arg*/)
+// ======================= Acquisition (shared) =======================
+// Probes and configures the sensor from g_cfg and fills everything of the
+// header but version / record_s / samples. Starts a fresh g_health.
+static bool setupCapture(LIS2DW12 &lis, FileHeaderV3 &h)
 {
-  g_recording = true;
-  g_stopRequested = false;
-  g_samplesWritten = 0;
-  g_maxBacklog = 0;
-  g_elapsedMs = 0;
-
-  String ts = g_uiTimestamp;
-  String path = makeNewFileNameFromUI(ts);
-  g_currentFile = path;
-
-  if (g_i2cMutex)
-    xSemaphoreTake(g_i2cMutex, portMAX_DELAY);
-
-  Wire.setClock(1000000);
-  LIS2DW12 lis(Wire, 0x18);
-  if (!lis.begin(-1, -1, 1000000))
-  {
-    if (g_i2cMutex)
-      xSemaphoreGive(g_i2cMutex);
-    g_recording = false;
-    g_recTask = nullptr;
-    vTaskDelete(nullptr);
-    return;
-  }
+  memset(&g_health, 0, sizeof(g_health));
+  if (!lis.probe())
+    return false;
 
   LIS2DW12::Config cfg;
   cfg.mode = g_cfg.mode;
@@ -347,14 +404,7 @@ static void recordTask(void * /*arg*/)
   cfg.autoInc = true;
 
   if (!lis.applyConfig(cfg))
-  {
-    if (g_i2cMutex)
-      xSemaphoreGive(g_i2cMutex);
-    g_recording = false;
-    g_recTask = nullptr;
-    vTaskDelete(nullptr);
-    return;
-  }
+    return false;
 
   if (g_cfg.mode == LIS2DW12::Mode::LowPower && g_cfg.hz == 2)
   {
@@ -367,27 +417,13 @@ static void recordTask(void * /*arg*/)
     lis.setRateHz(g_cfg.hz);
   }
 
-  lis.setOutputQuantization(g_cfg.qBits);
-  lis.loadCalibrationNVS("lis2dw12", "cal");
-  auto cal = lis.getCalibration();
-
-  File f = LittleFS.open(path, "w");
-  if (!f)
-  {
-    if (g_i2cMutex)
-      xSemaphoreGive(g_i2cMutex);
-    g_recording = false;
-    g_recTask = nullptr;
-    vTaskDelete(nullptr);
-    return;
-  }
+  // q_bits is applied by captureBlocks (qMask) and recorded in the header,
+  // not through the driver's readG quantisation
+  const LIS2DW12::Calibration &cal = sensorCalibration();
 
-  FileHeaderV3 h{};
+  memset(&h, 0, sizeof(h));
   memcpy(h.magic, "LIS2DW12", 8);
-  h.version = 3;
   h.rate_hz = g_cfg.hz;
-  h.record_s = g_cfg.sec;
-  h.samples = 0;
   h.fs_g = fsToByte(cfg.fs);
   h.res_bits = lis.activeResolutionBits();
   h.q_bits = g_cfg.qBits;
@@ -396,173 +432,309 @@ static void recordTask(void * /*arg*/)
     h.cal_offset_g[i] = cal.offset_g[i];
     h.cal_scale[i] = cal.scale[i];
   }
+  return true;
+}
 
-  if (f.write((uint8_t *)&h, sizeof(h)) != sizeof(h))
-  {
-    f.close();
-    if (g_i2cMutex)
-      xSemaphoreGive(g_i2cMutex);
-    g_recording = false;
-    g_recTask = nullptr;
-    vTaskDelete(nullptr);
-    return;
-  }
-  f.close();
-
-  const uint32_t targetN = (uint32_t)g_cfg.hz * (uint32_t)g_cfg.sec;
-  const size_t CHUNK_N = 1024;
-  Sample6 *chunk = (Sample6 *)malloc(CHUNK_N * sizeof(Sample6));
-  if (!chunk)
-  {
-    if (g_i2cMutex)
-      xSemaphoreGive(g_i2cMutex);
-    g_recording = false;
-    g_recTask = nullptr;
-    vTaskDelete(nullptr);
-    return;
-  }
-
-  dueCount = 0;
-  startTimerHz(g_cfg.hz);
-
+// Where full blocks go: the flash writer or the stream sender.
+struct BlockSink
+{
+  RecBlock *(*acquire)();
+  void (*commit)();
+  bool (*failed)();
+  volatile uint32_t *dropped; // blocks lost because the sink was full
+};
+
+// Drains the FIFO into sink blocks until targetN samples, stop or sink
+// failure. Returns samples captured (dropped blocks included).
+static uint64_t captureBlocks(LIS2DW12 &lis, const BlockSink &sink, uint64_t targetN)
+{
+  // Sensor ODR is the sample clock: FIFO runs continuous, we drain it in bursts
+  // whenever the acquisition source wakes us (INT1 edge, timer or sim).
+  AcqSource acq = g_cfg.acq;
+  if (acqSourceNeedsInt1(acq) && LIS_INT1_PIN < 0)
+    acq = AcqSource::Timer;
+  g_cfg.acq = acq;
+  const AcqSchedule sch = acqScheduleFor(acq, g_cfg.hz, LIS2DW12::FIFO_DEPTH);
+
+  lis.setFifo(LIS2DW12::FifoMode::Bypass); // flush stale samples
+  lis.setFifo(LIS2DW12::FifoMode::Continuous, sch.wtm);
+  if (acq == AcqSource::Int1Fifo)
+    lis.routeInt1(LIS2DW12::INT1_FTH);
+  else if (acq == AcqSource::Int1Drdy)
+    lis.routeInt1(LIS2DW12::INT1_DRDY, true);
+
+  acqStart(acq, sch, xTaskGetCurrentTaskHandle());
+
+  AcqPacer pacer(sch);
   uint32_t tStart = millis();
-  uint32_t idx = 0;
+  uint64_t idx = 0; // 64 bit: continuous sessions run for days
   uint32_t maxBacklog = 0;
-
-  while (idx < targetN && !g_stopRequested)
-  {
-    uint32_t localDue = 0;
-    portENTER_CRITICAL(&mux);
-    localDue = dueCount;
-    dueCount = 0;
-    portEXIT_CRITICAL(&mux);
-
-    if (localDue > maxBacklog)
-      maxBacklog = localDue;
-
-    while (localDue && idx < targetN && !g_stopRequested)
+  uint32_t fifoOverruns = 0;
+  uint32_t dropped = 0;
+  g_fifoOverruns = 0;
+
+  // health: everything that can bend the time base without an error
+  // (zeroed by setupCapture, before the writer snapshots it)
+  g_health.periodUs = sch.periodUs;
+
+  // quantisation happens here, so file, index and stream all see the
+  // same values the packed codecs store
+  const uint8_t res = lis.activeResolutionBits();
+  const int16_t qMask = (g_cfg.qBits && g_cfg.qBits < res) ? (int16_t)(0xFFFF << (res - g_cfg.qBits)) : (int16_t)-1;
+  Sample6 last{};
+  bool haveLast = false;
+
+  // live preview rides along on the samples read here (live_sampler.h)
+  const LIS2DW12::Calibration &cal = sensorCalibration();
+  liveTapBegin(convCoeffs(res, fsToByte(fsFromG(g_cfg.fs_g)), cal.offset_g, cal.scale), (float)g_cfg.hz,
+               g_recording ? LiveSource::Recording : LiveSource::Stream);
+
+  // When the sink is full the FIFO is still drained (into a scratch block
+  // that is thrown away) so timing holds.
+  static RecBlock scratch;
+  RecBlock *blk = nullptr;
+  scratch.n = 0;
+
+  while (idx < targetN && !g_stopRequested && !sink.failed())
+  {
+    LIS2DW12::FifoStatus st;
+    if (!lis.readFifoStatus(st))
     {
-      size_t fill = 0;
-
-      while (localDue && fill < CHUNK_N && idx < targetN && !g_stopRequested)
+      g_health.i2cErrors++;
+      pacer.lostTrack();
+      vTaskDelay(1);
+      continue;
+    }
+    if (st.overrun)
+      g_fifoOverruns = g_health.fifoOverruns = ++fifoOverruns;
+    if (st.level > maxBacklog)
+      maxBacklog = st.level;
+
+    if (!blk && scratch.n == 0)
+      blk = sink.acquire();
+    RecBlock *dst = blk ? blk : &scratch;
+
+    size_t take = st.level;
+    if (take > REC_BLOCK_N - dst->n)
+      take = REC_BLOCK_N - dst->n;
+    if (take > targetN - idx)
+      take = targetN - idx;
+
+    if (dst->n == 0)
+    {
+      dst->first = idx;
+      dst->t_us = micros();
+    }
+    if (take && lis.readFifoBurst(reinterpret_cast<int16_t(*)[3]>(&dst->s[dst->n]), take))
+    {
+      sensorMarkFirstSample();
+      // FIFO pops cannot repeat a sample; a bit-identical one at a burst
+      // boundary only counts when STATUS.DRDY confirms nothing new was there
+      const Sample6 &f = dst->s[dst->n];
+      uint8_t status;
+      if (haveLast && f.ax == last.ax && f.ay == last.ay && f.az == last.az &&
+          lis.readReg(LIS2DW12::REG_STATUS, status) && !(status & 0x01))
+        g_health.duplicates++;
+      last = dst->s[dst->n + take - 1];
+      haveLast = true;
+      if (qMask != -1)
       {
-        int16_t ax, ay, az;
-        if (lis.readRawAligned(ax, ay, az))
-        {
-          chunk[fill].ax = ax;
-          chunk[fill].ay = ay;
-          chunk[fill].az = az;
-          fill++;
-          idx++;
-        }
-        localDue--;
+        int16_t *v = &dst->s[dst->n].ax;
+        for (size_t i = 0; i < take * 3; i++)
+          v[i] &= qMask;
       }
+      liveTapPush(&dst->s[dst->n], take); // dropped blocks too: the preview does not care
+      dst->n += take;
+      idx += take;
+    }
+    else if (take)
+    {
+      g_health.i2cErrors++; // part of the burst may be gone: time base suspect
+    }
 
-      if (fill)
+    if (dst->n == REC_BLOCK_N || (dst->n && idx >= targetN))
+    {
+      if (blk)
       {
-        File wf = LittleFS.open(path, "a");
-        if (!wf)
-          break;
-        size_t bytes = fill * sizeof(Sample6);
-        size_t wrote = wf.write((uint8_t *)chunk, bytes);
-        wf.close();
-        if (wrote != bytes)
-          break;
-        g_samplesWritten = idx;
+        sink.commit();
+        blk = nullptr;
+      }
+      else
+      {
+        *sink.dropped = g_health.ringDropped = ++dropped;
+        scratch.n = 0;
       }
     }
 
     g_elapsedMs = millis() - tStart;
-    delay(0);
+    if (pacer.shouldWait(st.level))
+    {
+      const bool woke = acqWait(sch);
+      uint32_t jitterUs;
+      if (pacer.waited(woke, esp_timer_get_time(), jitterUs))
+        recHealthAddJitter(g_health, jitterUs);
+      if (!woke)
+        g_health.skippedTicks++;
+    }
   }
 
-  stopTimer();
-  free(chunk);
+  // hand over the partial block on stop
+  if (blk && blk->n)
+    sink.commit();
+  else if (scratch.n)
+    *sink.dropped = g_health.ringDropped = ++dropped;
+
+  acqStop();
+  liveTapEnd();
+  lis.routeInt1(0);
+  lis.setFifo(LIS2DW12::FifoMode::Bypass);
 
-  g_samplesWritten = idx;
   g_maxBacklog = maxBacklog;
+  g_fifoOverruns = fifoOverruns;
   g_elapsedMs = millis() - tStart;
+  return idx;
+}
+
+// ======================= Recording job =======================
+// Runs on the sensor service task; g_recording is set by the handler.
+static void recordJob(LIS2DW12 &lis, void * /*arg*/)
+{
+  g_stopRequested = false;
+  g_samplesWritten = 0;
+  g_maxBacklog = 0;
+  g_elapsedMs = 0;
 
-  rewriteHeaderSamples(path, idx);
+  String ts = g_uiTimestamp;
+  const bool continuous = g_cfg.continuous;
+  s_segBaseTs = ts;
+  s_segRateHz = g_cfg.hz ? g_cfg.hz : 1;
+  String path = continuous ? segmentPath(0, 0) : makeNewFileNameFromUI(ts);
+  g_currentFile = path;
 
-  rebuildListCache();
+  FileHeaderV4 hdr{};
+  FileHeaderV3 &h = hdr.v3;
+  if (!setupCapture(lis, h))
+  {
+    g_recording = false;
+    return;
+  }
+  h.version = g_cfg.fileVersion;
+  h.record_s = continuous ? g_cfg.segSec : g_cfg.sec;
+  h.samples = 0;
+  hdr.block_n = REC_BLOCK_N;
+  hdr.codec = g_cfg.codec;
+  if (g_cfg.decMain)
+    h.rate_hz = g_cfg.hz / g_cfg.decMain;
+
+  // continuous: runs until stopped, the writer cuts the stream into segments
+  const uint64_t targetN = continuous ? UINT64_MAX : (uint64_t)g_cfg.hz * g_cfg.sec;
+  RecSegmentPlan plan;
+  if (continuous)
+  {
+    plan.samples = (uint32_t)g_cfg.hz * g_cfg.segSec;
+    plan.bytes = g_cfg.segKB * 1024UL;
+    plan.path = segmentPath;
+  }
+  recRetentionSetQuota(g_cfg.minFreeKB * 1024UL);
+  RecDecimPlan dec;
+  dec.inRateHz = g_cfg.hz;
+  dec.main = g_cfg.decMain;
+  dec.sides = g_cfg.decSides;
+  const bool decimating = dec.main || dec.sides;
+  if (!recWriterStart(path, hdr, continuous ? &plan : nullptr, decimating ? &dec : nullptr))
+  {
+    g_recording = false;
+    return;
+  }
+
+  const BlockSink sink = {recWriterAcquire, recWriterCommit, recWriterFailed, &g_ringDropped};
+  captureBlocks(lis, sink, targetN);
 
-  if (g_i2cMutex)
-    xSemaphoreGive(g_i2cMutex);
+  uint32_t written = recWriterFinish();
+  g_currentFile = recWriterCurrentPath(); // last segment in continuous mode
+  g_samplesWritten = written;
+
+  rebuildListCache();
+  recRetentionKick(); // one-shot sessions are subject to the quota too
 
   g_recording = false;
-  g_recTask = nullptr;
-  vTaskDelete(nullptr);
 }
 
-// ======================= Calibration tasks =======================
-static void calibrateStaticTask(void * /*arg*/)
+// ======================= Stream job =======================
+// Live samples to a TCP client (see stream_session.h); nothing touches
+// flash. Runs until /api/stop or the client disconnects.
+static void streamJob(LIS2DW12 &lis, void * /*arg*/)
 {
-  g_calibratingStatic = true;
+  g_stopRequested = false;
+  g_maxBacklog = 0;
+  g_elapsedMs = 0;
+
+  FileHeaderV3 h;
+  if (!setupCapture(lis, h))
+  {
+    g_streaming = false;
+    return;
+  }
+  h.version = 3;
+  h.record_s = 0;
+  h.samples = 0;
+
+  if (!streamSessionOpen(h))
+  {
+    g_streaming = false;
+    return;
+  }
+
+  const BlockSink sink = {streamAcquire, streamCommit, streamFailed, &g_stDropped};
+  captureBlocks(lis, sink, UINT64_MAX);
+  streamSessionClose();
+
+  g_streaming = false;
+}
 
-  if (g_i2cMutex)
-    xSemaphoreTake(g_i2cMutex, portMAX_DELAY);
+// ======================= Calibration jobs =======================
+static bool configureForCalibration(LIS2DW12 &lis)
+{
+  if (!lis.probe())
+    return false;
+  LIS2DW12::Config cfg;
+  cfg.odr = LIS2DW12::Odr::Hz100;
+  cfg.mode = LIS2DW12::Mode::HighPerf;
+  cfg.lpMode = LIS2DW12::LowPowerMode::LP2_14bit;
+  cfg.fs = LIS2DW12::FullScale::G2;
+  cfg.lowNoise = true;
+  cfg.bdu = true;
+  cfg.autoInc = true;
+  // full resolution: the instance is shared with the capture jobs
+  lis.setOutputQuantization(0);
+  return lis.applyConfig(cfg);
+}
 
-  Wire.setClock(400000);
-  LIS2DW12 lis(Wire, 0x18);
-  bool ok = lis.begin(-1, -1, 400000);
+static void calibrateStaticJob(LIS2DW12 &lis, void * /*arg*/)
+{
+  bool ok = configureForCalibration(lis);
   if (ok)
   {
-    LIS2DW12::Config cfg;
-    cfg.mode = LIS2DW12::Mode::HighPerf;
-    cfg.lpMode = LIS2DW12::LowPowerMode::LP2_14bit;
-    cfg.fs = LIS2DW12::FullScale::G2;
-    cfg.lowNoise = true;
-    cfg.bdu = true;
-    cfg.autoInc = true;
-    lis.applyConfig(cfg);
-    lis.setRateHz(100);
-
     ok = lis.calibrateStatic(600, 5, 1.0f);
     if (ok)
-    {
-      lis.saveCalibrationNVS("lis2dw12", "cal");
-      g_calDirty = true;
-    }
+      sensorSaveCalibration(lis.getCalibration());
   }
 
-  if (g_i2cMutex)
-    xSemaphoreGive(g_i2cMutex);
   g_calibratingStatic = false;
   resetLivePreviewState();
-  vTaskDelete(nullptr);
 }
 
-static void calibrate6PosTask(void * /*arg*/)
+static void calibrate6PosJob(LIS2DW12 &lis, void * /*arg*/)
 {
-  g_calibrating6 = true;
   g_calibStep = 0;
 
-  if (g_i2cMutex)
-    xSemaphoreTake(g_i2cMutex, portMAX_DELAY);
-
-  Wire.setClock(400000);
-  LIS2DW12 lis(Wire, 0x18);
-  if (!lis.begin(-1, -1, 400000))
+  if (!configureForCalibration(lis))
   {
-    if (g_i2cMutex)
-      xSemaphoreGive(g_i2cMutex);
     g_calibrating6 = false;
     g_calibStep = -1;
-    vTaskDelete(nullptr);
     return;
   }
 
-  LIS2DW12::Config cfg;
-  cfg.mode = LIS2DW12::Mode::HighPerf;
-  cfg.lpMode = LIS2DW12::LowPowerMode::LP2_14bit;
-  cfg.fs = LIS2DW12::FullScale::G2;
-  cfg.lowNoise = true;
-  cfg.bdu = true;
-  cfg.autoInc = true;
-  lis.applyConfig(cfg);
-  lis.setRateHz(100);
-
   for (int pose = 0; pose < 6; pose++)
   {
     g_calibStep = pose;
@@ -571,11 +743,8 @@ static void calibrate6PosTask(void * /*arg*/)
     float avg[3] = {0, 0, 0};
     if (!lis.collectPoseAverage((LIS2DW12::Pose)pose, avg, 700, 5))
     {
-      if (g_i2cMutex)
-        xSemaphoreGive(g_i2cMutex);
       g_calibrating6 = false;
       g_calibStep = -1;
-      vTaskDelete(nullptr);
       return;
     }
     g_calibAvg[pose][0] = avg[0];
@@ -583,17 +752,12 @@ static void calibrate6PosTask(void * /*arg*/)
     g_calibAvg[pose][2] = avg[2];
   }
 
-  lis.calibrate6PositionFromAverages(g_calibAvg);
-  lis.saveCalibrationNVS("lis2dw12", "cal");
-  g_calDirty = true;
-
-  if (g_i2cMutex)
-    xSemaphoreGive(g_i2cMutex);
+  if (lis.calibrate6PositionFromAverages(g_calibAvg))
+    sensorSaveCalibration(lis.getCalibration());
 
   g_calibStep = -1;
   g_calibrating6 = false;
   resetLivePreviewState();
-  vTaskDelete(nullptr);
 }
 
 static String infoJson()
@@ -617,10 +781,139 @@ static String infoJson()
   s += "\"maxBacklog\":";
   s += (uint32_t)g_maxBacklog;
   s += ",";
+  s += "\"fifoOverruns\":";
+  s += (uint32_t)g_fifoOverruns;
+  s += ",";
+  s += "\"acq\":\"";
+  s += acqSourceName(g_cfg.acq);
+  s += "\",";
+  s += "\"acqWakeups\":";
+  s += (uint32_t)g_acqWakeups;
+  s += ",";
+  s += "\"acqTimeouts\":";
+  s += (uint32_t)g_acqTimeouts;
+  s += ",";
+  s += "\"firstSampleUs\":";
+  s += (uint32_t)g_firstSampleUs;
+  s += ",";
   s += "\"elapsedMs\":";
   s += (uint32_t)g_elapsedMs;
   s += ",";
-  s += "\"currentFile\":\"" + g_currentFile + "\",";
+  s += "\"ringBlocks\":";
+  s += (uint32_t)REC_RING_BLOCKS;
+  s += ",";
+  s += "\"ringHighWater\":";
+  s += (uint32_t)g_ringHighWater;
+  s += ",";
+  s += "\"ringDropped\":";
+  s += (uint32_t)g_ringDropped;
+  s += ",";
+  s += "\"viewers\":";
+  s += eventPushViewers();
+  s += ",";
+  s += "\"wrMaxUs\":";
+  s += (uint32_t)g_wrMaxUs;
+  s += ",";
+  s += "\"wrStalls\":";
+  s += (uint32_t)g_wrStalls;
+  s += ",";
+  s += "\"wrStallMs\":";
+  s += (uint32_t)g_wrStallMs;
+  s += ",";
+  s += "\"wrBytes\":";
+  s += (uint32_t)g_wrBytes;
+  s += ",";
+  s += "\"wrBps\":";
+  s += (uint32_t)g_wrBps;
+  s += ",";
+  s += "\"fmt\":";
+  s += g_cfg.fileVersion;
+  s += ",";
+  s += "\"codec\":";
+  s += g_cfg.codec;
+  s += ",";
+  s += "\"q_bits\":";
+  s += g_cfg.qBits;
+  s += ",";
+  s += "\"ratio\":";
+  s += String(g_wrBytes ? (float)g_wrRawBytes / (float)g_wrBytes : 1.0f, 2);
+  s += ",";
+  s += "\"encMaxUs\":";
+  s += (uint32_t)g_encMaxUs;
+  s += ",";
+  s += "\"repairedFiles\":";
+  s += (uint32_t)g_repairedFiles;
+  s += ",";
+  s += "\"continuous\":";
+  s += (g_cfg.continuous ? "true" : "false");
+  s += ",";
+  s += "\"segSec\":";
+  s += g_cfg.segSec;
+  s += ",";
+  s += "\"segCount\":";
+  s += (uint32_t)g_segCount;
+  s += ",";
+  s += "\"segSwitchLastUs\":";
+  s += (uint32_t)g_segSwitchLastUs;
+  s += ",";
+  s += "\"segSwitchMaxUs\":";
+  s += (uint32_t)g_segSwitchMaxUs;
+  s += ",";
+  s += "\"segDropped\":";
+  s += (uint32_t)g_segDropped;
+  s += ",";
+  s += "\"decMain\":";
+  s += g_cfg.decMain;
+  s += ",";
+  s += "\"decSides\":";
+  s += g_cfg.decSides;
+  s += ",";
+  s += "\"decMaxUs\":";
+  s += (uint32_t)g_decMaxUs;
+  s += ",";
+  s += "\"decCpuPct\":";
+  s += String(g_elapsedMs ? (float)g_decBusyUs / (10.0f * (float)g_elapsedMs) : 0.0f, 2);
+  s += ",";
+  s += "\"minFreeKB\":";
+  s += g_cfg.minFreeKB;
+  s += ",";
+  s += "\"retDeleted\":";
+  s += (uint32_t)g_retDeleted;
+  s += ",";
+  s += "\"retFreedKB\":";
+  s += (uint32_t)g_retFreedKB;
+  s += ",";
+  s += "\"health\":";
+  s += healthJson(g_health);
+  s += ",";
+  s += "\"streaming\":";
+  s += (g_streaming ? "true" : "false");
+  s += ",";
+  s += "\"streamPort\":";
+  s += STREAM_PORT;
+  s += ",";
+  s += "\"stFrames\":";
+  s += (uint32_t)g_stFrames;
+  s += ",";
+  s += "\"stDropped\":";
+  s += (uint32_t)g_stDropped;
+  s += ",";
+  s += "\"stBytes\":";
+  s += (uint32_t)g_stBytes;
+  s += ",";
+  s += "\"stBps\":";
+  s += (uint32_t)g_stBps;
+  s += ",";
+  s += "\"stSendMaxUs\":";
+  s += (uint32_t)g_stSendMaxUs;
+  s += ",";
+  s += "\"stStalls\":";
+  s += (uint32_t)g_stStalls;
+  s += ",";
+  s += "\"stRingHighWater\":";
+  s += (uint32_t)g_stRingHighWater;
+  s += ",";
+  s += "\"currentFile\":\"" + (g_recording ? recWriterCurrentPath() : g_currentFile) + "\",";
   s += "\"mode\":\"";
   s += (g_cfg.mode == LIS2DW12::Mode::LowPower ? "LP" : g_cfg.mode == LIS2DW12::Mode::HighPerf ? "HP"
                                                                                                : "OD");
@@ -676,7 +969,7 @@ void handleApiFsInfo() { server.send(200, "application/json", fsInfoJson()); }
 
 void handleApiStart()
 {
-  if (g_recording || g_calibratingStatic || g_calibrating6)
+  if (g_recording || g_streaming || g_calibratingStatic || g_calibrating6)
   {
     server.send(409, "text/plain", "Busy");
     return;
@@ -693,8 +986,18 @@ void handleApiStart()
     return;
   }
 
+  // continuous: cont=1&seg=<s>[&segKB=<kB>][&minFreeKB=<kB>], sec is ignored
+  const bool continuous = server.hasArg("cont") && server.arg("cont").toInt() == 1;
+  uint16_t segSec = server.hasArg("seg") ? (uint16_t)server.arg("seg").toInt() : 60;
+  uint32_t segKB = server.hasArg("segKB") ? (uint32_t)server.arg("segKB").toInt() : 0;
+  if (continuous && (segSec < 10 || segSec > 3600))
+  {
+    server.send(400, "text/plain", "Invalid seg (10..3600 s)");
+    return;
+  }
+
   const uint16_t allowedSec[] = {15, 30, 45, 60, 75, 90, 120, 180};
-  bool secOk = false;
+  bool secOk = continuous;
   for (auto v : allowedSec)
     if (sec == v)
       secOk = true;
@@ -704,6 +1007,16 @@ void handleApiStart()
     return;
   }
 
+  // default quota keeps 1/8 of the FS free while rotating, none otherwise
+  uint32_t minFreeKB = continuous ? (uint32_t)(LittleFS.totalBytes() / 8 / 1024) : 0;
+  if (server.hasArg("minFreeKB"))
+    minFreeKB = (uint32_t)server.arg("minFreeKB").toInt();
+  if (minFreeKB * 1024ULL >= LittleFS.totalBytes())
+  {
+    server.send(400, "text/plain", "Invalid minFreeKB");
+    return;
+  }
+
   if (!(fs_g == 2 || fs_g == 4 || fs_g == 8 || fs_g == 16))
   {
     server.send(400, "text/plain", "Invalid fs");
@@ -718,27 +1031,158 @@ void handleApiStart()
     return;
   }
 
-  g_cfg.hz = hz;
-  g_cfg.sec = sec;
-  g_cfg.fs_g = fs_g;
-  g_cfg.qBits = 0;
-  g_cfg.mode = mode;
-  g_uiTimestamp = ts;
+  AcqSource acq = (LIS_INT1_PIN >= 0) ? AcqSource::Int1Fifo : AcqSource::Timer;
+  if (server.hasArg("acq") && !acqSourceFromName(server.arg("acq"), acq))
+  {
+    server.send(400, "text/plain", "Invalid acq (timer|int1_fifo|int1_drdy|sim)");
+    return;
+  }
 
-  g_stopRequested = false;
-  BaseType_t ok = xTaskCreatePinnedToCore(recordTask, "rec", 8192, nullptr, 2, &g_recTask, 1);
-  if (ok != pdPASS)
+  uint8_t fileVersion = server.hasArg("fmt") ? (uint8_t)server.arg("fmt").toInt() : 4;
+  if (fileVersion != 3 && fileVersion != 4)
   {
-    server.send(500, "text/plain", "Task create failed");
+    server.send(400, "text/plain", "Invalid fmt (3|4)");
     return;
   }
 
-  server.send(200, "text/plain", "OK started");
+  // q: keep only the top q bits of each sample. V4 stores 10/12-bit samples
+  // bit-packed (codec=pack, the default for them) or Rice coded (codec=rice).
+  uint8_t qBits = server.hasArg("q") ? (uint8_t)server.arg("q").toInt() : 0;
+  if (!(qBits == 0 || qBits == 10 || qBits == 12 || qBits == 14))
+  {
+    server.send(400, "text/plain", "Invalid q (0|10|12|14)");
+    return;
+  }
+  const bool packable = (fileVersion == 4 && (qBits == 10 || qBits == 12));
+  String codecArg = server.hasArg("codec") ? server.arg("codec") : String(packable ? "pack" : "rice");
+  uint8_t codec = REC_CODEC_DELTA_RICE;
+  if (codecArg == "pack")
+  {
+    if (!packable)
+    {
+      server.send(400, "text/plain", "codec=pack needs fmt=4 and q=10|12");
+      return;
+    }
+    codec = (qBits == 10) ? REC_CODEC_PACK10 : REC_CODEC_PACK12;
+  }
+  else if (codecArg != "rice")
+  {
+    server.send(400, "text/plain", "Invalid codec (rice|pack)");
+    return;
+  }
+
+  // dec=4[,16..]: decimated companions (_d<M>.dat) next to the full-rate
+  // file; full=0 stores the first factor in the main file instead
+  uint8_t decMain = 0, decSides = 0;
+  if (server.hasArg("dec") && server.arg("dec").length())
+  {
+    String list = server.arg("dec") + ",";
+    for (int from = 0, comma; (comma = list.indexOf(',', from)) >= 0; from = comma + 1)
+    {
+      const long f = list.substring(from, comma).toInt();
+      // 1.6 / 12.5 Hz are nominal rates: nothing to divide exactly
+      if (f < 2 || f > 16 || !decimFactorOk((uint8_t)f) || (decSides & f) || decMain == f || hz < 25 || hz % f != 0)
+      {
+        server.send(400, "text/plain", "Invalid dec (2|4|8|16, dividing hz >= 25)");
+        return;
+      }
+      if (!decMain && server.hasArg("full") && server.arg("full").toInt() == 0)
+        decMain = (uint8_t)f;
+      else
+        decSides |= (uint8_t)f;
+    }
+    if (continuous)
+    {
+      server.send(400, "text/plain", "dec is not supported with cont=1");
+      return;
+    }
+  }
+
+  g_cfg.hz = hz;
+  g_cfg.sec = sec;
+  g_cfg.fs_g = fs_g;
+  g_cfg.qBits = qBits;
+  g_cfg.codec = codec;
+  g_cfg.fileVersion = fileVersion;
+  g_cfg.continuous = continuous;
+  g_cfg.segSec = segSec;
+  g_cfg.segKB = segKB;
+  g_cfg.minFreeKB = minFreeKB;
+  g_cfg.decMain = decMain;
+  g_cfg.decSides = decSides;
+  g_cfg.mode = mode;
+  g_cfg.acq = acq;
+  g_uiTimestamp = ts;
+
+  g_stopRequested = false;
+  g_recording = true;
+  SensorJob job;
+  job.fn = recordJob;
+  job.clockHz = SENSOR_I2C_FAST_HZ;
+  if (!sensorServiceSubmit(job))
+  {
+    g_recording = false;
+    server.send(500, "text/plain", "Sensor service busy");
+    return;
+  }
+
+  server.send(200, "text/plain", "OK started");
+}
+
+// /api/stream?hz=&fs=[&acq=]: answers at once; the session then waits up
+// to STREAM_ACCEPT_MS for a TCP client on STREAM_PORT. Stop with /api/stop.
+void handleApiStream()
+{
+  if (g_recording || g_streaming || g_calibratingStatic || g_calibrating6)
+  {
+    server.send(409, "text/plain", "Busy");
+    return;
+  }
+
+  uint16_t uiHz = server.hasArg("hz") ? (uint16_t)server.arg("hz").toInt() : 1600;
+  uint8_t fs_g = server.hasArg("fs") ? (uint8_t)server.arg("fs").toInt() : 2;
+  if (!(fs_g == 2 || fs_g == 4 || fs_g == 8 || fs_g == 16))
+  {
+    server.send(400, "text/plain", "Invalid fs");
+    return;
+  }
+  uint16_t hz = 100;
+  LIS2DW12::Mode mode = LIS2DW12::Mode::HighPerf;
+  if (!parseHzFromUI(uiHz, hz, mode))
+  {
+    server.send(400, "text/plain", "Invalid hz");
+    return;
+  }
+  AcqSource acq = (LIS_INT1_PIN >= 0) ? AcqSource::Int1Fifo : AcqSource::Timer;
+  if (server.hasArg("acq") && !acqSourceFromName(server.arg("acq"), acq))
+  {
+    server.send(400, "text/plain", "Invalid acq (timer|int1_fifo|int1_drdy|sim)");
+    return;
+  }
+
+  g_cfg.hz = hz;
+  g_cfg.fs_g = fs_g;
+  g_cfg.qBits = 0;
+  g_cfg.mode = mode;
+  g_cfg.acq = acq;
+
+  g_stopRequested = false;
+  g_streaming = true;
+  SensorJob job;
+  job.fn = streamJob;
+  job.clockHz = SENSOR_I2C_FAST_HZ;
+  if (!sensorServiceSubmit(job))
+  {
+    g_streaming = false;
+    server.send(500, "text/plain", "Sensor service busy");
+    return;
+  }
+  server.send(200, "text/plain", "OK waiting for client on tcp/" + String(STREAM_PORT));
 }
 
 void handleApiStop()
 {
-  if (!g_recording)
+  if (!g_recording && !g_streaming)
   {
     server.send(200, "text/plain", "Not recording");
     return;
@@ -768,9 +1212,12 @@ void handleDownload()
     return;
   }
 
+  const bool pin = recReadPin(path); // retention must not delete it mid-download
   File f = LittleFS.open(path, "r");
   if (!f)
   {
+    if (pin)
+      recReadUnpin(path);
     server.send(500, "text/plain", "Open failed");
     return;
   }
@@ -783,8 +1230,40 @@ void handleDownload()
   server.sendHeader("Connection", "close");
   server.streamFile(f, "application/octet-stream");
   f.close();
+  if (pin)
+    recReadUnpin(path);
 }
 
+// ISO 10816 / 20816 block of /api/analyze (vib_severity.h)
+static String severityJson(const VibSeverity &v, const IsoClass &c, uint32_t ms)
+{
+  String s = "{";
+  s += "\"band_hz\":[" + String(v.fLo(), 1) + "," + String(v.fHi(), 1) + "],";
+  s += "\"vel_rms_mms\":[" + String(v.velRmsMms(0), 3) + "," + String(v.velRmsMms(1), 3) + "," +
+       String(v.velRmsMms(2), 3) + "],";
+  s += "\"disp_pp_um\":[" + String(v.dispPpUm(0), 1) + "," + String(v.dispPpUm(1), 1) + "," +
+       String(v.dispPpUm(2), 1) + "],";
+  s += "\"vel_rms_max_mms\":" + String(v.velRmsMaxMms(), 3) + ",";
+  s += "\"iso\":\"" + String(c.name) + "\",";
+  s += "\"iso_desc\":\"" + String(c.desc) + "\",";
+  s += "\"limits_mms\":[" + String(c.ab, 2) + "," + String(c.bc, 2) + "," + String(c.cd, 2) + "],";
+  s += "\"zones\":\"";
+  for (uint8_t a = 0; a < 3; a++)
+    s += isoZone(c, v.velRmsMms(a));
+  s += "\",\"zone\":\"";
+  s += isoZone(c, v.velRmsMaxMms());
+  s += "\",\"samples\":" + String(v.used()) + ",";
+  s += "\"ms\":" + String(ms);
+  s += "}";
+  return s;
+}
+
+// /api/analyze?file=[&t0=&t1=][&mode=scan][&sev=0|1][&band=10|2][&iso=II]
+// Severity (velocity RMS, displacement p-p, ISO zone) rides along the
+// sample scan; a whole-file answer from the block index skips it unless
+// sev=1 asks for the extra pass. Whole-file requests also return the
+// features the writer stored ("features": moments, crest, clipping,
+// histogram) as they are.
 void handleApiAnalyze()
 {
   if (!server.hasArg("file"))
@@ -814,47 +1293,63 @@ void handleApiAnalyze()
     return;
   }
 
-  File f = LittleFS.open(path, "r");
-  if (!f)
+  RecReader rd;
+  if (!rd.open(path))
   {
-    server.send(500, "text/plain", "Open failed");
+    server.send(400, "text/plain", rd.error());
     return;
   }
-  if (f.size() < (int)sizeof(FileHeaderV3))
+  const FileHeaderV3 &h = rd.header();
+  const uint32_t total = rd.samples();
+
+  // optional time range [t0, t1) in seconds: seek there instead of scanning
+  const bool ranged = server.hasArg("t0") || server.hasArg("t1");
+  uint32_t s0 = 0, s1 = total;
+  if (ranged && h.rate_hz)
   {
-    f.close();
-    server.send(400, "text/plain", "Bad file");
-    return;
+    float t0 = server.hasArg("t0") ? server.arg("t0").toFloat() : 0.0f;
+    float t1 = server.hasArg("t1") ? server.arg("t1").toFloat() : (float)total / h.rate_hz;
+    s0 = (t0 > 0) ? (uint32_t)(t0 * h.rate_hz) : 0;
+    s1 = (t1 > 0) ? (uint32_t)(t1 * h.rate_hz) : 0;
+    if (s1 > total)
+      s1 = total;
+    if (s0 > s1)
+      s0 = s1;
   }
 
-  FileHeaderV3 h{};
-  if (f.read((uint8_t *)&h, sizeof(h)) != sizeof(h))
+  // block index: built and appended on first access for files without one;
+  // a whole-file overview of a long recording is then answered from it alone
+  const bool indexed = rd.ensureIndex();
+  const bool fromIndex = indexed && !ranged && server.arg("mode") != "scan" &&
+                         rd.indexEntries() >= ANALYZE_INDEX_MIN_BLOCKS;
+  const uint32_t n = s1 - s0;
+
+  const IsoClass *iso = isoClassFromName(server.hasArg("iso") ? server.arg("iso").c_str() : "II");
+  if (!iso)
   {
-    f.close();
-    server.send(400, "text/plain", "Read header failed");
+    server.send(400, "text/plain", "Invalid iso (I|II|III|IV|g1r|g1f|g2r|g2f)");
     return;
   }
-
-  if (memcmp(h.magic, "LIS2DW12", 8) != 0)
+  const float bandLo = server.hasArg("band") ? server.arg("band").toFloat() : 10.0f;
+  if (bandLo != 10.0f && bandLo != 2.0f)
   {
-    f.close();
-    server.send(400, "text/plain", "Bad magic");
+    server.send(400, "text/plain", "Invalid band (10|2 Hz lower edge)");
     return;
   }
-
-  // gerçek sample sayısını dosya boyutuna göre limitliyoruz
-  const uint32_t headerBytes = sizeof(FileHeaderV3);
-  const uint32_t sampleBytes = sizeof(Sample6);
-  const uint32_t maxPossibleSamples = (uint32_t)((f.size() - headerBytes) / sampleBytes);
-  uint32_t n = h.samples;
-  if (n == 0 || n > maxPossibleSamples)
-    n = maxPossibleSamples;
+  const String sevArg = server.arg("sev");
+  VibSeverity sev;
+  const bool wantSev = sevArg == "1" || (sevArg != "0" && !fromIndex);
+  const bool doSev = wantSev && sev.begin(h.rate_hz, bandLo);
+  sev.expect(n);
+  uint32_t sevMs = 0;
 
   // Downsample hedefi
   const uint32_t MAXPTS = 2000;
   uint32_t pts = (n <= MAXPTS) ? n : MAXPTS;
   if (pts < 2)
     pts = n; // çok küçükse
+  if (fromIndex)
+    pts = rd.indexEntries(); // one point per index block
 
   // bucket step
   const double step = (pts > 0) ? ((double)n / (double)pts) : 1.0;
@@ -875,7 +1370,6 @@ void handleApiAnalyze()
       free(sumZ);
     if (cnt)
       free(cnt);
-    f.close();
     server.send(500, "text/plain", "OOM");
     return;
   }
@@ -885,49 +1379,134 @@ void handleApiAnalyze()
   float maxX = -INFINITY, maxY = -INFINITY, maxZ = -INFINITY;
   double ssX = 0, ssY = 0, ssZ = 0;
 
-  // iterate
-  Sample6 s{};
+  const ConvCoeffs cc = convCoeffsFromHeader(h);
   uint32_t i = 0;
-  while (i < n && f.read((uint8_t *)&s, sizeof(s)) == sizeof(s))
-  {
-    float gx = rawAlignedToG(s.ax, h.res_bits, h.fs_g);
-    float gy = rawAlignedToG(s.ay, h.res_bits, h.fs_g);
-    float gz = rawAlignedToG(s.az, h.res_bits, h.fs_g);
-
-    gx = applyCal1(gx, h.cal_offset_g[0], h.cal_scale[0]);
-    gy = applyCal1(gy, h.cal_offset_g[1], h.cal_scale[1]);
-    gz = applyCal1(gz, h.cal_offset_g[2], h.cal_scale[2]);
-
-    if (gx < minX)
-      minX = gx;
-    if (gx > maxX)
-      maxX = gx;
-    ssX += (double)gx * (double)gx;
-    if (gy < minY)
-      minY = gy;
-    if (gy > maxY)
-      maxY = gy;
-    ssY += (double)gy * (double)gy;
-    if (gz < minZ)
-      minZ = gz;
-    if (gz > maxZ)
-      maxZ = gz;
-    ssZ += (double)gz * (double)gz;
-
-    uint32_t b = (pts <= 1) ? 0 : (uint32_t)floor((double)i / step);
-    if (b >= pts)
-      b = pts - 1;
-    sumX[b] += gx;
-    sumY[b] += gy;
-    sumZ[b] += gz;
-    if (cnt[b] < 65535)
-      cnt[b]++;
-
-    i++;
-    if ((i & 0x3FF) == 0)
-      delay(0); // watchdog friendly
+  if (fromIndex)
+  {
+    // g = raw * k + b is linear, so raw block sums convert exactly:
+    //   sum g = k*sum + b*n,  sum g^2 = k^2*sumsq + 2kb*sum + b^2*n
+    float mins[3] = {+INFINITY, +INFINITY, +INFINITY};
+    float maxs[3] = {-INFINITY, -INFINITY, -INFINITY};
+    double ss[3] = {0, 0, 0};
+    float *sums[3] = {sumX, sumY, sumZ};
+    const RecIndexEntry *idx = rd.index();
+    for (uint32_t e = 0; e < pts; e++)
+    {
+      for (int a = 0; a < 3; a++)
+      {
+        const double k = cc.k[a], b = cc.b[a];
+        float lo = (float)(k * idx[e].min[a] + b), hi = (float)(k * idx[e].max[a] + b);
+        if (lo > hi)
+        {
+          float t = lo;
+          lo = hi;
+          hi = t;
+        }
+        if (lo < mins[a])
+          mins[a] = lo;
+        if (hi > maxs[a])
+          maxs[a] = hi;
+        ss[a] += k * k * (double)idx[e].sumsq[a] + 2.0 * k * b * idx[e].sum[a] + b * b * idx[e].n;
+        sums[a][e] = (float)(k * idx[e].sum[a] + b * idx[e].n);
+      }
+      cnt[e] = idx[e].n;
+      i += idx[e].n;
+    }
+    minX = mins[0], minY = mins[1], minZ = mins[2];
+    maxX = maxs[0], maxY = maxs[1], maxZ = maxs[2];
+    ssX = ss[0], ssY = ss[1], ssZ = ss[2];
   }
-  f.close();
+  else if (s0 && !rd.seekSample(s0))
+  {
+    free(sumX);
+    free(sumY);
+    free(sumZ);
+    free(cnt);
+    server.send(400, "text/plain", "Seek failed");
+    return;
+  }
+
+  // iterate: read a block, convert it in one pass, then accumulate
+  static Sample6 blk[ANALYZE_BLOCK];
+  static float bx[ANALYZE_BLOCK], by[ANALYZE_BLOCK], bz[ANALYZE_BLOCK];
+  while (!fromIndex && i < n)
+  {
+    size_t want = (n - i < ANALYZE_BLOCK) ? (n - i) : ANALYZE_BLOCK;
+    size_t got = rd.read(blk, want);
+    if (got == 0)
+      break;
+    convertSamples(blk, got, h.res_bits, h.fs_g, cc, bx, by, bz);
+    if (doSev)
+    {
+      const uint32_t t0 = millis();
+      for (size_t k = 0; k < got; k++)
+      {
+        const float g3[3] = {bx[k], by[k], bz[k]};
+        sev.push(g3);
+      }
+      sevMs += millis() - t0;
+    }
+
+    for (size_t k = 0; k < got; k++)
+    {
+      const float gx = bx[k], gy = by[k], gz = bz[k];
+      if (gx < minX)
+        minX = gx;
+      if (gx > maxX)
+        maxX = gx;
+      ssX += (double)gx * (double)gx;
+      if (gy < minY)
+        minY = gy;
+      if (gy > maxY)
+        maxY = gy;
+      ssY += (double)gy * (double)gy;
+      if (gz < minZ)
+        minZ = gz;
+      if (gz > maxZ)
+        maxZ = gz;
+      ssZ += (double)gz * (double)gz;
+
+      uint32_t b = (pts <= 1) ? 0 : (uint32_t)floor((double)i / step);
+      if (b >= pts)
+        b = pts - 1;
+      sumX[b] += gx;
+      sumY[b] += gy;
+      sumZ[b] += gz;
+      if (cnt[b] < 65535)
+        cnt[b]++;
+      i++;
+    }
+    if (got < want)
+      break;
+    delay(0); // watchdog friendly
+  }
+
+  // index answered the overview: severity needs its own pass over the samples
+  if (fromIndex && doSev && rd.seekSample(0))
+  {
+    const uint32_t t0 = millis();
+    size_t got;
+    uint32_t blocks = 0;
+    while ((got = rd.read(blk, ANALYZE_BLOCK)) > 0)
+    {
+      convertSamples(blk, got, h.res_bits, h.fs_g, cc, bx, by, bz);
+      for (size_t k = 0; k < got; k++)
+      {
+        const float g3[3] = {bx[k], by[k], bz[k]};
+        sev.push(g3);
+      }
+      if ((++blocks & 0x0F) == 0)
+        delay(0); // watchdog friendly
+    }
+    sevMs = millis() - t0;
+  }
+  // trailer chunks while the file is open; features describe the whole
+  // file, so the writer's values stand in for a pass only without a range
+  RecHealth hl;
+  const bool hasHealth = rd.health(hl);
+  RecFeatures ft;
+  const bool hasFeat = !ranged && rd.features(ft);
+  rd.close();
 
   const uint32_t usedN = i;
   const float rmsX = rmsFromSumSq(ssX, usedN);
@@ -942,7 +1521,7 @@ void handleApiAnalyze()
 
   // meta + stats
   String head;
-  head.reserve(1024);
+  head.reserve(2048);
   head += "{";
   head += "\"file\":\"" + path + "\",";
   head += "\"rate_hz\":" + String(h.rate_hz) + ",";
@@ -952,9 +1531,25 @@ void handleApiAnalyze()
   head += "\"fs_g\":" + String(h.fs_g) + ",";
   head += "\"res_bits\":" + String(h.res_bits) + ",";
   head += "\"q_bits\":" + String(h.q_bits) + ",";
+  head += "\"version\":" + String(h.version) + ",";
+  head += "\"file_bytes\":" + String(rd.fileBytes()) + ",";
+  head += "\"ratio\":" + String(rd.ratio(), 3) + ",";
+  head += "\"indexed\":" + String(indexed ? "true" : "false") + ",";
+  head += "\"source\":\"" + String(fromIndex ? "index" : "samples") + "\",";
+  if (hasHealth)
+    head += "\"health\":" + healthJson(hl) + ",";
+  if (hasFeat)
+    head += "\"features\":" + featuresJson(ft, cc, false) + ",";
+  if (ranged && h.rate_hz)
+  {
+    head += "\"t0\":" + String((float)s0 / h.rate_hz, 4) + ",";
+    head += "\"t1\":" + String((float)s1 / h.rate_hz, 4) + ",";
+  }
   head += "\"min\":[" + String(minX, 6) + "," + String(minY, 6) + "," + String(minZ, 6) + "],";
   head += "\"max\":[" + String(maxX, 6) + "," + String(maxY, 6) + "," + String(maxZ, 6) + "],";
   head += "\"rms\":[" + String(rmsX, 6) + "," + String(rmsY, 6) + "," + String(rmsZ, 6) + "],";
+  if (doSev && sev.used())
+    head += "\"severity\":" + severityJson(sev, *iso, sevMs) + ",";
   head += "\"pts\":" + String(pts) + ",";
   // downsample sonrası efektif örnekleme (yaklaşık)
   float effHz = (pts > 1 && usedN > 1) ? (float)h.rate_hz * ((float)pts / (float)usedN) : (float)h.rate_hz;
@@ -1011,7 +1606,7 @@ void handleDownloadCSV(); // forward decl (aşağıda aynen devam edeceksin)
 
 void handleApiDelete()
 {
-  if (g_recording || g_calibratingStatic || g_calibrating6)
+  if (g_recording || g_streaming || g_calibratingStatic || g_calibrating6)
   {
     server.send(409, "text/plain", "Busy");
     return;
@@ -1044,15 +1639,18 @@ void handleApiDelete()
 
 void handleApiCalibrateStatic()
 {
-  if (g_recording || g_calibratingStatic || g_calibrating6)
+  if (g_recording || g_streaming || g_calibratingStatic || g_calibrating6)
   {
     server.send(409, "text/plain", "Busy");
     return;
   }
-  BaseType_t ok = xTaskCreatePinnedToCore(calibrateStaticTask, "calS", 4096, nullptr, 2, nullptr, 1);
-  if (ok != pdPASS)
+  g_calibratingStatic = true;
+  SensorJob job;
+  job.fn = calibrateStaticJob;
+  if (!sensorServiceSubmit(job))
   {
-    server.send(500, "text/plain", "Task create failed");
+    g_calibratingStatic = false;
+    server.send(500, "text/plain", "Sensor service busy");
     return;
   }
   server.send(200, "text/plain", "Static calibration started");
@@ -1060,89 +1658,35 @@ void handleApiCalibrateStatic()
 
 void handleApiCalibrate6()
 {
-  if (g_recording || g_calibratingStatic || g_calibrating6)
+  if (g_recording || g_streaming || g_calibratingStatic || g_calibrating6)
   {
     server.send(409, "text/plain", "Busy");
     return;
   }
-  BaseType_t ok = xTaskCreatePinnedToCore(calibrate6PosTask, "cal6", 6144, nullptr, 2, nullptr, 1);
-  if (ok != pdPASS)
+  g_calibrating6 = true;
+  SensorJob job;
+  job.fn = calibrate6PosJob;
+  if (!sensorServiceSubmit(job))
   {
-    server.send(500, "text/plain", "Task create failed");
+    g_calibrating6 = false;
+    server.send(500, "text/plain", "Sensor service busy");
     return;
   }
   server.send(200, "text/plain", "6-pos calibration started");
 }
 
+// /api/live[?fc=][&rate=1..20]: never waits for the sensor. Starts the
+// background sampler (live_sampler.h) when it is not running and answers
+// with its latest publication ("ready":false until the first one).
 void handleApiLive()
 {
-  if (g_recording || g_calibratingStatic || g_calibrating6)
+  const uint32_t t0 = micros();
+  if (g_calibratingStatic || g_calibrating6) // recordings and streams feed the preview
   {
     server.send(200, "application/json", "{\"enabled\":false}");
     return;
   }
 
-  uint32_t now = millis();
-  if (now - g_liveLastMs < 1000)
-  {
-    String s = "{";
-    s += "\"enabled\":true,";
-    s += "\"hz\":" + String(LIVE_PREVIEW_HZ) + ",";
-    s += "\"fc\":" + String(g_live_lp_cut_hz, 1) + ",";
-    s += "\"ax\":" + String(g_live_acc_mps2[0], 3) + ",";
-    s += "\"ay\":" + String(g_live_acc_mps2[1], 3) + ",";
-    s += "\"az\":" + String(g_live_acc_mps2[2], 3) + ",";
-    s += "\"mag\":" + String(g_live_mag_acc, 3) + ",";
-    s += "\"vx_mmps\":" + String(g_live_vel_mmps[0], 2) + ",";
-    s += "\"vy_mmps\":" + String(g_live_vel_mmps[1], 2) + ",";
-    s += "\"vz_mmps\":" + String(g_live_vel_mmps[2], 2) + ",";
-    s += "\"vmag_mmps\":" + String(g_live_mag_vel_mmps, 2) + ",";
-    s += "\"dx_mm\":" + String(g_live_disp_mm[0], 2) + ",";
-    s += "\"dy_mm\":" + String(g_live_disp_mm[1], 2) + ",";
-    s += "\"dz_mm\":" + String(g_live_disp_mm[2], 2) + ",";
-    s += "\"dmag_mm\":" + String(g_live_mag_disp_mm, 2);
-    s += "}";
-    server.send(200, "application/json", s);
-    return;
-  }
-  g_liveLastMs = now;
-
-  if (g_i2cMutex)
-  {
-    if (xSemaphoreTake(g_i2cMutex, pdMS_TO_TICKS(50)) != pdTRUE)
-    {
-      server.send(200, "application/json", "{\"enabled\":false}");
-      return;
-    }
-  }
-
-  Wire.setClock(1000000);
-  LIS2DW12 lis(Wire, 0x18);
-  if (!lis.begin(-1, -1, 1000000))
-  {
-    if (g_i2cMutex)
-      xSemaphoreGive(g_i2cMutex);
-    server.send(200, "application/json", "{\"enabled\":false}");
-    return;
-  }
-
-  LIS2DW12::Config cfg;
-  cfg.mode = LIS2DW12::Mode::HighPerf;
-  cfg.lpMode = LIS2DW12::LowPowerMode::LP2_14bit;
-  cfg.fs = LIS2DW12::FullScale::G2;
-  cfg.lowNoise = true;
-  cfg.bdu = true;
-  cfg.autoInc = true;
-  lis.applyConfig(cfg);
-  lis.setRateHz(LIVE_PREVIEW_HZ);
-
-  lis.loadCalibrationNVS("lis2dw12", "cal");
-  g_calDirty = false;
-
-  auto cal = lis.getCalibration();
-  const uint8_t resBits = lis.activeResolutionBits();
-  const uint8_t fs_g = fsToByte(cfg.fs);
-
   float cutoff = g_live_lp_cut_hz;
   if (server.hasArg("fc"))
   {
@@ -1153,117 +1697,235 @@ void handleApiLive()
   }
   // remember last used cutoff
   g_live_lp_cut_hz = cutoff;
+  long rate = server.hasArg("rate") ? server.arg("rate").toInt() : g_liveRateHz;
+  if (rate < 1 || rate > LIVE_RATE_MAX)
+    rate = LIVE_RATE_DEFAULT;
 
-  const uint16_t samples = LIVE_PREVIEW_HZ;
-  const float dt = 1.0f / (float)LIVE_PREVIEW_HZ;
-  const float tau = 1.0f / (2.0f * PI * cutoff);
-  const float alpha = dt / (tau + dt); // 1st-order LPF coefficient
-
-  double sumAcc[3] = {0, 0, 0};
-  float vel[3] = {0, 0, 0};
-  float disp[3] = {0, 0, 0};
-  float lpf[3] = {0, 0, 0};
-  bool lpfInit = false;
-  uint16_t valid = 0;
+  liveSamplerKick(cutoff, (uint8_t)rate);
+  server.send(200, "application/json", liveJson());
+  g_liveServeUs = micros() - t0;
+}
 
-  for (uint16_t i = 0; i < samples; i++)
+// /api/livefft[?axis=x|y|z|mag][&n=512][&win=hann][&avg=none|lin|exp][&k=8]
+//             [&peak=1][&reset=1][&fmt=u8|u16][&lo=-100][&hi=0][&fmax=][&cid=]
+// Live spectrum of the live ring (background sampler, or the tap of a running
+// recording / stream) as LiveFftHdr + quantised dB rows
+// (live_spectrum.h). Frames of n samples every n/2 are taken from the ring
+// by sample count, so the average does not depend on how often the page
+// asks; each reply folds in the frames that arrived since the last one (at
+// most LIVE_FFT_MAX_STEP). Every viewer (cid, a random number per page; the
+// remote IP without it) has its own average and parameters; changing one
+// of them (or reset=1) restarts that viewer's average and peak hold.
+// A viewer quiet for LIVE_FFT_IDLE_MS gives its slot and memory up; with
+// LIVE_FFT_VIEWERS busy slots a new viewer gets 409.
+static const uint32_t LIVE_FFT_MAX_STEP = 8; // frames per reply
+static const uint8_t LIVE_FFT_VIEWERS = 3;   // ~12 kB each at n=1024
+static const uint32_t LIVE_FFT_IDLE_MS = 10000;
+
+struct LiveFftViewer
+{
+  LiveSpectrum spec;
+  uint32_t cid = 0; // 0 = free slot
+  char axis = 0;
+  uint32_t session = 0;
+  uint32_t pos = 0;     // first sample of the next frame
+  uint32_t skipped = 0; // frames lost to a lapped ring since the reset
+  uint32_t lastMs = 0;
+};
+static LiveFftViewer s_lfft[LIVE_FFT_VIEWERS];
+
+// Slot of viewer cid (a fresh one for a new viewer), nullptr when all busy.
+static LiveFftViewer *liveFftViewer(uint32_t cid, uint32_t now)
+{
+  LiveFftViewer *hit = nullptr, *freeSlot = nullptr;
+  for (LiveFftViewer &v : s_lfft)
   {
-    int16_t axRaw, ayRaw, azRaw;
-    if (!lis.readRawAligned(axRaw, ayRaw, azRaw))
+    if (v.cid && v.cid != cid && now - v.lastMs > LIVE_FFT_IDLE_MS)
     {
-      delayMicroseconds(1200);
-      continue;
+      v.spec.end(); // page closed or stopped
+      v.cid = 0;
     }
+    if (v.cid == cid)
+      hit = &v;
+    else if (!v.cid && !freeSlot)
+      freeSlot = &v;
+  }
+  if (hit)
+    return hit;
+  if (freeSlot)
+  {
+    freeSlot->cid = cid;
+    freeSlot->axis = 0; // forces begin() below
+  }
+  return freeSlot;
+}
 
-    float gx = rawAlignedToG(axRaw, resBits, fs_g);
-    float gy = rawAlignedToG(ayRaw, resBits, fs_g);
-    float gz = rawAlignedToG(azRaw, resBits, fs_g);
-
-    gx = applyCal1(gx, cal.offset_g[0], cal.scale[0]);
-    gy = applyCal1(gy, cal.offset_g[1], cal.scale[1]);
-    gz = applyCal1(gz, cal.offset_g[2], cal.scale[2]);
-
-    float ax = gx * GRAVITY_MPS2;
-    float ay = gy * GRAVITY_MPS2;
-    float az = gz * GRAVITY_MPS2;
+void handleApiLiveFft()
+{
+  if (g_calibratingStatic || g_calibrating6)
+  {
+    server.send(409, "text/plain", "Busy");
+    return;
+  }
 
-    if (!lpfInit)
-    {
-      lpf[0] = ax;
-      lpf[1] = ay;
-      lpf[2] = az;
-      lpfInit = true;
-    }
-    else
+  const String axisArg = server.hasArg("axis") ? server.arg("axis") : String("x");
+  const char axis = axisArg == "x" ? 'x' : axisArg == "y" ? 'y' : axisArg == "z" ? 'z' : axisArg == "mag" ? 'm' : 0;
+  if (!axis)
+  {
+    server.send(400, "text/plain", "Bad axis (x|y|z|mag)");
+    return;
+  }
+  const uint32_t n = server.hasArg("n") ? (uint32_t)server.arg("n").toInt() : 512;
+  if (n < 64 || n > LIVE_RING_N || !fftSizeOk(n))
+  {
+    server.send(400, "text/plain", "Invalid n (64..1024, power of 2)");
+    return;
+  }
+  FftWindow win = FftWindow::Hann;
+  if (server.hasArg("win") && !fftWindowFromName(server.arg("win").c_str(), win))
+  {
+    server.send(400, "text/plain", "Invalid win (rect|hann|hamming|blackman|flattop)");
+    return;
+  }
+  LiveAvg avg = LiveAvg::Exp;
+  if (server.hasArg("avg") && !liveAvgFromName(server.arg("avg").c_str(), avg))
+  {
+    server.send(400, "text/plain", "Invalid avg (none|lin|exp)");
+    return;
+  }
+  const long k = server.hasArg("k") ? server.arg("k").toInt() : 8;
+  if (k < 1 || k > 1000)
+  {
+    server.send(400, "text/plain", "Invalid k (1..1000)");
+    return;
+  }
+  const bool peak = !server.hasArg("peak") || server.arg("peak") != "0";
+  uint8_t cellBytes = 1;
+  if (server.hasArg("fmt"))
+  {
+    const String f = server.arg("fmt");
+    if (f == "u16")
+      cellBytes = 2;
+    else if (f != "u8")
     {
-      lpf[0] += alpha * (ax - lpf[0]);
-      lpf[1] += alpha * (ay - lpf[1]);
-      lpf[2] += alpha * (az - lpf[2]);
+      server.send(400, "text/plain", "Invalid fmt (u8|u16)");
+      return;
     }
-
-    sumAcc[0] += lpf[0];
-    sumAcc[1] += lpf[1];
-    sumAcc[2] += lpf[2];
-
-    vel[0] += lpf[0] * dt;
-    vel[1] += lpf[1] * dt;
-    vel[2] += lpf[2] * dt;
-
-    disp[0] += vel[0] * dt;
-    disp[1] += vel[1] * dt;
-    disp[2] += vel[2] * dt;
-
-    valid++;
-    delayMicroseconds(1200); // attempt to stay close to sensor ODR
   }
-
-  if (g_i2cMutex)
-    xSemaphoreGive(g_i2cMutex);
-
-  if (!valid)
+  const float dbLo = server.hasArg("lo") ? server.arg("lo").toFloat() : -100.0f;
+  const float dbHi = server.hasArg("hi") ? server.arg("hi").toFloat() : 0.0f;
+  if (!(dbHi > dbLo))
   {
-    g_liveLastMs = 0;
-    server.send(200, "application/json", "{\"enabled\":false}");
+    server.send(400, "text/plain", "Invalid lo/hi (dB, lo < hi)");
     return;
   }
 
-  const float invN = 1.0f / (float)valid;
-  for (int i = 0; i < 3; i++)
+  uint32_t cid = server.hasArg("cid") ? (uint32_t)strtoul(server.arg("cid").c_str(), nullptr, 10)
+                                       : (uint32_t)server.client().remoteIP();
+  if (!cid)
+    cid = 1;
+  LiveFftViewer *v = liveFftViewer(cid, millis());
+  if (!v)
   {
-    g_live_acc_mps2[i] = (float)(sumAcc[i] * invN);
-    g_live_vel_mmps[i] = vel[i] * 1000.0f;
-    g_live_disp_mm[i] = disp[i] * 1000.0f;
-    g_live_g[i] = g_live_acc_mps2[i] / GRAVITY_MPS2;
+    server.send(409, "text/plain", "Too many live spectrum viewers");
+    return;
   }
+  v->lastMs = millis();
+  LiveSpectrum &spec = v->spec;
 
-  g_live_mag_acc = sqrtf(g_live_acc_mps2[0] * g_live_acc_mps2[0] +
-                         g_live_acc_mps2[1] * g_live_acc_mps2[1] +
-                         g_live_acc_mps2[2] * g_live_acc_mps2[2]);
-  g_live_mag_vel_mmps = sqrtf(g_live_vel_mmps[0] * g_live_vel_mmps[0] +
-                              g_live_vel_mmps[1] * g_live_vel_mmps[1] +
-                              g_live_vel_mmps[2] * g_live_vel_mmps[2]);
-  g_live_mag_disp_mm = sqrtf(g_live_disp_mm[0] * g_live_disp_mm[0] +
-                             g_live_disp_mm[1] * g_live_disp_mm[1] +
-                             g_live_disp_mm[2] * g_live_disp_mm[2]);
+  liveSamplerKick(g_live_lp_cut_hz, g_liveRateHz);
+  const LiveRingInfo ri = liveSamplerInfo();
+  const uint32_t hop = n / 2;
+  const uint32_t count = liveSamplerCount();
+  bool gap = false;
+  if (n != spec.n() || win != spec.window() || avg != spec.avg() || (uint32_t)k != spec.avgK() ||
+      axis != v->axis || ri.session != v->session || server.arg("reset") == "1")
+  {
+    if (!spec.begin(n, win, avg, (uint32_t)k))
+    {
+      v->cid = 0;
+      server.send(500, "text/plain", "Out of memory");
+      return;
+    }
+    v->axis = axis;
+    v->session = ri.session;
+    v->pos = count > n ? count - n : 0; // newest complete frame first
+    v->skipped = 0;
+  }
+  else if (!spec.done() && count - v->pos > LIVE_RING_N)
+  {
+    // not asked for longer than the ring holds: resume at the newest frame
+    const uint32_t pos = count - n;
+    v->skipped += (pos - v->pos + hop - 1) / hop;
+    v->pos = pos;
+    gap = true;
+  }
 
-  String s = "{";
-  s += "\"enabled\":true,";
-  s += "\"hz\":" + String(LIVE_PREVIEW_HZ) + ",";
-  s += "\"fc\":" + String(cutoff, 1) + ",";
-  s += "\"ax\":" + String(g_live_acc_mps2[0], 3) + ",";
-  s += "\"ay\":" + String(g_live_acc_mps2[1], 3) + ",";
-  s += "\"az\":" + String(g_live_acc_mps2[2], 3) + ",";
-  s += "\"mag\":" + String(g_live_mag_acc, 3) + ",";
-  s += "\"vx_mmps\":" + String(g_live_vel_mmps[0], 2) + ",";
-  s += "\"vy_mmps\":" + String(g_live_vel_mmps[1], 2) + ",";
-  s += "\"vz_mmps\":" + String(g_live_vel_mmps[2], 2) + ",";
-  s += "\"vmag_mmps\":" + String(g_live_mag_vel_mmps, 2) + ",";
-  s += "\"dx_mm\":" + String(g_live_disp_mm[0], 2) + ",";
-  s += "\"dy_mm\":" + String(g_live_disp_mm[1], 2) + ",";
-  s += "\"dz_mm\":" + String(g_live_disp_mm[2], 2) + ",";
-  s += "\"dmag_mm\":" + String(g_live_mag_disp_mm, 2);
-  s += "}";
-  server.send(200, "application/json", s);
+  const uint32_t t0 = micros();
+  static Sample6 raw[64];
+  for (uint32_t f = 0; f < LIVE_FFT_MAX_STEP && !spec.done(); f++)
+  {
+    float *x = spec.input();
+    bool ok = true;
+    for (uint32_t off = 0; ok && off < n; off += 64)
+    {
+      ok = liveSamplerRead(v->pos + off, raw, 64);
+      for (uint32_t i = 0; ok && i < 64; i++)
+      {
+        float g[3];
+        convertSample(raw[i], ri.cc, g);
+        x[off + i] = axis == 'm' ? sqrtf(g[0] * g[0] + g[1] * g[1] + g[2] * g[2]) : g[axis - 'x'];
+      }
+    }
+    if (!ok)
+      break; // frame not complete yet (or lapped: caught up next time)
+    spec.frame();
+    v->pos += hop;
+  }
+  const uint32_t fftUs = micros() - t0;
+
+  uint32_t bins = spec.bins();
+  if (server.hasArg("fmax") && ri.hz > 0)
+  {
+    const float fmax = server.arg("fmax").toFloat();
+    const uint32_t b = fmax > 0 ? (uint32_t)(fmax * n / ri.hz) + 1 : 0;
+    if (b >= 2 && b < bins)
+      bins = b;
+  }
+
+  LiveFftHdr lh{};
+  memcpy(lh.magic, LIVE_FFT_MAGIC, sizeof(lh.magic));
+  lh.hdr_bytes = sizeof(LiveFftHdr);
+  lh.cell_bytes = cellBytes;
+  lh.window = (uint8_t)win;
+  lh.n = (uint16_t)n;
+  lh.bins = (uint16_t)bins;
+  lh.avg = (uint8_t)avg;
+  lh.flags = (peak ? LIVE_FFT_PEAK : 0) | (spec.done() ? LIVE_FFT_DONE : 0) | (gap ? LIVE_FFT_GAP : 0);
+  lh.avg_k = (uint16_t)k;
+  lh.frames = spec.frames();
+  lh.skipped = v->skipped;
+  lh.rate_hz = ri.hz;
+  lh.db_lo = dbLo;
+  lh.db_step = (dbHi - dbLo) / (cellBytes == 1 ? 255.0f : 65535.0f);
+  lh.axis = axis;
+
+  static uint8_t out[sizeof(LiveFftHdr) + 2 * 2 * (LIVE_RING_N / 2 + 1)];
+  size_t len = sizeof(lh);
+  memcpy(out, &lh, sizeof(lh));
+  spec.quantise(out + len, bins, false, cellBytes, lh.db_lo, lh.db_step);
+  len += (size_t)bins * cellBytes;
+  if (peak)
+  {
+    spec.quantise(out + len, bins, true, cellBytes, lh.db_lo, lh.db_step);
+    len += (size_t)bins * cellBytes;
+  }
+
+  server.sendHeader("Cache-Control", "no-store");
+  server.sendHeader("X-Fft-Us", String(fftUs));
+  server.setContentLength(len);
+  server.send(200, "application/octet-stream", "");
+  server.sendContent((const char *)out, len);
 }
 
 void handleApiVersion() { server.send(200, "application/json", versionJson()); }
@@ -1271,7 +1933,7 @@ void handleApiVersion() { server.send(200, "application/json", versionJson()); }
 // ======================= NEW: RESET endpoint =======================
 void handleApiReset()
 {
-  if (g_recording || g_calibratingStatic || g_calibrating6)
+  if (g_recording || g_streaming || g_calibratingStatic || g_calibrating6)
   {
     server.send(409, "text/plain", "Busy");
     return;
@@ -1284,7 +1946,7 @@ void handleApiReset()
 // ======================= NEW: Firmware update handlers =======================
 static void handleUpdateGet()
 {
-  if (g_recording || g_calibratingStatic || g_calibrating6)
+  if (g_recording || g_streaming || g_calibratingStatic || g_calibrating6)
   {
     server.send(409, "text/plain", "Busy");
     return;
@@ -1313,7 +1975,7 @@ void handleUpdatePost()
 
 void handleUpdateUpload()
 {
-  if (g_recording || g_calibratingStatic || g_calibrating6)
+  if (g_recording || g_streaming || g_calibratingStatic || g_calibrating6)
   {
     g_updateLastError = "Busy";
     Update.abort();
@@ -1328,7 +1990,7 @@ void handleUpdateUpload()
 
     Serial.printf("[UPDATE] Start: %s, size=%u\n", up.filename.c_str(), (unsigned)up.totalSize);
 
-    if (g_recording || g_calibratingStatic || g_calibrating6)
+    if (g_recording || g_streaming || g_calibratingStatic || g_calibrating6)
     {
       g_updateLastError = "Busy";
       return;
@@ -1380,6 +2042,41 @@ void handleUpdateUpload()
   }
 }
 
+// One spectrum as a JSON array (bins 1 .. n/2-1), flushed in ~1 kB chunks.
+static void sendSpectrum(String &s, const WelchPsd &w, uint8_t ch, bool psd, float fs,
+                         float &peakHz, float &peakMag)
+{
+  const uint32_t bins = w.n() / 2;
+  const float df = fs / (float)w.n();
+  peakHz = peakMag = 0;
+  s += "[";
+  for (uint32_t i = 1; i < bins; i++)
+  {
+    const float mag = psd ? w.psdAt(i, fs, ch) : w.amplitudeAt(i, ch);
+    if (mag > peakMag)
+    {
+      peakMag = mag;
+      peakHz = i * df;
+    }
+    char num[16];
+    snprintf(num, sizeof(num), psd ? "%.4e" : "%.6f", mag); // g^2/Hz spans decades
+    s += num;
+    if (i + 1 < bins)
+      s += ",";
+    if (s.length() > 1024)
+    {
+      server.sendContent(s);
+      s = "";
+    }
+  }
+  s += "]";
+}
+
+// /api/fft?file=&axis=x|y|z|all[&mag=1][&n=1024][&win=hann][&ov=50][&scale=amp|psd]
+// Welch average over the whole recording (streamed, one segment in RAM):
+// amp = peak g of a sine on the bin, psd = g^2/Hz. axis=all gives X, Y, Z
+// (and |a| with mag=1) from a single pass: one read / convert, shared
+// window, two channels per complex FFT; n up to FFT_ALL_MAX_N.
 void handleApiFFT()
 {
   if (!server.hasArg("file") || !server.hasArg("axis"))
@@ -1397,97 +2094,540 @@ void handleApiFFT()
     return;
   }
 
+  const bool all = server.arg("axis") == "all";
   char axis = server.arg("axis")[0]; // x y z
   int axisIdx = (axis == 'x') ? 0 : (axis == 'y') ? 1
                                 : (axis == 'z')   ? 2
                                                   : -1;
-  if (axisIdx < 0)
+  if (axisIdx < 0 && !all)
   {
     server.send(400, "text/plain", "Bad axis");
     return;
   }
 
-  File f = LittleFS.open(path, "r");
-  FileHeaderV3 h{};
-  f.read((uint8_t *)&h, sizeof(h));
+  uint32_t n = server.hasArg("n") ? (uint32_t)server.arg("n").toInt() : FFT_N;
+  if (n < 64 || !fftSizeOk(n) || (all && n > FFT_ALL_MAX_N))
+  {
+    server.send(400, "text/plain", all ? "Invalid n (64..2048 with axis=all, power of 2)"
+                                       : "Invalid n (64..4096, power of 2)");
+    return;
+  }
+  FftWindow win = FftWindow::Hann;
+  if (server.hasArg("win") && !fftWindowFromName(server.arg("win").c_str(), win))
+  {
+    server.send(400, "text/plain", "Invalid win (rect|hann|hamming|blackman|flattop)");
+    return;
+  }
+  const int ovPct = server.hasArg("ov") ? server.arg("ov").toInt() : FFT_OVERLAP_PCT;
+  if (ovPct < 0 || ovPct > 90)
+  {
+    server.send(400, "text/plain", "Invalid ov (0..90 %)");
+    return;
+  }
+  const bool psd = server.hasArg("scale") && server.arg("scale") == "psd";
+  const bool withMag = all && server.arg("mag") == "1";
 
-  uint32_t maxSamples = min((uint32_t)FFT_N, h.samples);
-  if (maxSamples < 16)
+  RecReader rd;
+  if (!rd.open(path))
+  {
+    server.send(400, "text/plain", rd.error());
+    return;
+  }
+  const FileHeaderV3 &h = rd.header();
+
+  // short files: the largest segment that fits once
+  while (n > 64 && n > rd.samples())
+    n >>= 1;
+  if (rd.samples() < n)
   {
-    f.close();
     server.send(400, "text/plain", "Too few samples");
     return;
   }
 
-  static double vReal[FFT_N];
-  static double vImag[FFT_N];
+  WelchPsd welch;
+  if (!welch.begin(n, win, n * (uint32_t)ovPct / 100, all ? (withMag ? 4 : 3) : 1))
+  {
+    server.send(500, "text/plain", "Out of memory");
+    return;
+  }
+
+  // block read + batch convert straight into the estimator
+  const uint32_t t0 = millis();
+  const ConvCoeffs cc = convCoeffsFromHeader(h);
+  static Sample6 blk[ANALYZE_BLOCK];
+  static float gx[ANALYZE_BLOCK], gy[ANALYZE_BLOCK], gz[ANALYZE_BLOCK], gm[ANALYZE_BLOCK];
+  const float *chans[4] = {gx, gy, gz, gm};
+  size_t got;
+  uint32_t blocks = 0;
+  while ((got = rd.read(blk, ANALYZE_BLOCK)) > 0)
+  {
+    if (all)
+    {
+      convertSamples(blk, got, h.res_bits, h.fs_g, cc, gx, gy, gz);
+      if (withMag)
+        for (size_t k = 0; k < got; k++)
+          gm[k] = sqrtf(gx[k] * gx[k] + gy[k] * gy[k] + gz[k] * gz[k]);
+      welch.push(chans, got);
+    }
+    else
+    {
+      convertSamples(blk, got, h.res_bits, h.fs_g, cc,
+                     axisIdx == 0 ? gx : nullptr, axisIdx == 1 ? gx : nullptr, axisIdx == 2 ? gx : nullptr);
+      welch.push(gx, got);
+    }
+    if ((++blocks & 0x0F) == 0)
+      delay(0); // watchdog friendly
+  }
+  rd.close();
+  const uint32_t computeMs = millis() - t0;
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json");
 
-  memset(vImag, 0, sizeof(vImag));
+  String s = "{";
+  s += "\"axis\":\"";
+  s += all ? String("all") : String(axis);
+  s += "\",\"rate_hz\":";
+  s += h.rate_hz;
+  s += ",\"df\":";
+  s += String((float)h.rate_hz / (float)n, 6);
+  s += ",\"n\":";
+  s += n;
+  s += ",\"window\":\"";
+  s += fftWindowName(win);
+  s += "\",\"overlap\":";
+  s += ovPct;
+  s += ",\"segments\":";
+  s += welch.segments();
+  s += ",\"enbw\":";
+  s += String(welch.enbw(), 3);
+  s += ",\"scale\":\"";
+  s += psd ? "psd_g2_hz" : "amp_g";
+  s += "\",\"ms\":";
+  s += computeMs;
+
+  // Dominant frequency per spectrum
+  static const char *const names[4] = {"x", "y", "z", "mag"};
+  float peakHz[4], peakMag[4];
+  s += ",\"fft\":";
+  if (all)
+    s += "{";
+  for (uint8_t c = 0; c < welch.channels(); c++)
+  {
+    if (all)
+    {
+      s += c ? ",\"" : "\"";
+      s += names[c];
+      s += "\":";
+    }
+    sendSpectrum(s, welch, c, psd, h.rate_hz, peakHz[c], peakMag[c]);
+  }
+  if (all)
+    s += "}";
 
-  Sample6 s;
-  for (uint32_t i = 0; i < maxSamples; i++)
+  for (uint8_t pass = 0; pass < 2; pass++)
   {
-    if (f.read((uint8_t *)&s, sizeof(s)) != sizeof(s))
-      break;
+    s += pass ? ",\"peak_mag\":" : ",\"peak_hz\":";
+    if (all)
+      s += "{";
+    for (uint8_t c = 0; c < welch.channels(); c++)
+    {
+      if (all)
+      {
+        s += c ? ",\"" : "\"";
+        s += names[c];
+        s += "\":";
+      }
+      char num[16];
+      if (pass)
+        snprintf(num, sizeof(num), psd ? "%.4e" : "%.6f", peakMag[c]);
+      else
+        snprintf(num, sizeof(num), "%.3f", peakHz[c]);
+      s += num;
+    }
+    if (all)
+      s += "}";
+  }
+  s += "}";
+  server.sendContent(s);
+}
 
-    int16_t raw =
-        axisIdx == 0 ? s.ax : axisIdx == 1 ? s.ay
-                                           : s.az;
+// /api/stft?file=&axis=x|y|z|mag[&n=512][&hop=][&win=hann][&fmt=u8|u16]
+//          [&lo=-100][&hi=0][&fmax=]
+// Spectrogram as StftHdr + rows of quantised dB cells (stft.h). One frame
+// buffer whatever the file length; rows go out as they are computed.
+// Default hop gives about STFT_TARGET_FRAMES rows (never below n/4); fmax
+// trims the columns to 0 .. fmax Hz.
+void handleApiSTFT()
+{
+  if (!server.hasArg("file"))
+  {
+    server.send(400, "text/plain", "Missing file");
+    return;
+  }
 
-    float g = rawAlignedToG(raw, h.res_bits, h.fs_g);
-    g = applyCal1(g, h.cal_offset_g[axisIdx], h.cal_scale[axisIdx]);
+  String path = server.arg("file");
+  if (!path.startsWith("/"))
+    path = "/" + path;
+  if (!isSafeAccelFile(path) || !LittleFS.exists(path))
+  {
+    server.send(404, "text/plain", "Bad file");
+    return;
+  }
 
-    vReal[i] = g;
+  const String axisArg = server.hasArg("axis") ? server.arg("axis") : String("x");
+  const int axisIdx = axisArg == "x" ? 0 : axisArg == "y" ? 1 : axisArg == "z" ? 2 : axisArg == "mag" ? 3 : -1;
+  if (axisIdx < 0)
+  {
+    server.send(400, "text/plain", "Bad axis (x|y|z|mag)");
+    return;
+  }
+  const uint32_t n = server.hasArg("n") ? (uint32_t)server.arg("n").toInt() : STFT_N;
+  if (n < 64 || !fftSizeOk(n))
+  {
+    server.send(400, "text/plain", "Invalid n (64..4096, power of 2)");
+    return;
+  }
+  FftWindow win = FftWindow::Hann;
+  if (server.hasArg("win") && !fftWindowFromName(server.arg("win").c_str(), win))
+  {
+    server.send(400, "text/plain", "Invalid win (rect|hann|hamming|blackman|flattop)");
+    return;
+  }
+  uint8_t cellBytes = 1;
+  if (server.hasArg("fmt"))
+  {
+    const String f = server.arg("fmt");
+    if (f == "u16")
+      cellBytes = 2;
+    else if (f != "u8")
+    {
+      server.send(400, "text/plain", "Invalid fmt (u8|u16)");
+      return;
+    }
+  }
+  const float dbLo = server.hasArg("lo") ? server.arg("lo").toFloat() : -100.0f;
+  const float dbHi = server.hasArg("hi") ? server.arg("hi").toFloat() : 0.0f;
+  if (!(dbHi > dbLo))
+  {
+    server.send(400, "text/plain", "Invalid lo/hi (dB, lo < hi)");
+    return;
+  }
+
+  RecReader rd;
+  if (!rd.open(path))
+  {
+    server.send(400, "text/plain", rd.error());
+    return;
+  }
+  const FileHeaderV3 &h = rd.header();
+  if (rd.samples() < n)
+  {
+    server.send(400, "text/plain", "Too few samples");
+    return;
   }
-  f.close();
 
-  arduinoFFT FFT(vReal, vImag, maxSamples, h.rate_hz);
-  FFT.Windowing(FFT_WINDOW, FFT_FORWARD);
-  FFT.Compute(FFT_FORWARD);
-  FFT.ComplexToMagnitude();
+  uint32_t hop;
+  if (server.hasArg("hop"))
+    hop = (uint32_t)server.arg("hop").toInt();
+  else
+  {
+    hop = (rd.samples() - n) / (STFT_TARGET_FRAMES - 1) + 1;
+    if (hop < n / 4)
+      hop = n / 4;
+  }
+  const uint32_t frames = stftFrames(rd.samples(), n, hop);
+  if (hop < 1 || frames > STFT_MAX_FRAMES)
+  {
+    server.send(400, "text/plain", "Invalid hop (1.., at most 4096 frames)");
+    return;
+  }
 
-  uint32_t bins = maxSamples / 2;
-  double df = (double)h.rate_hz / (double)maxSamples;
+  uint32_t bins = n / 2 + 1;
+  if (server.hasArg("fmax"))
+  {
+    const float fmax = server.arg("fmax").toFloat();
+    const uint32_t b = fmax > 0 ? (uint32_t)(fmax * n / h.rate_hz) + 1 : 0;
+    if (b >= 2 && b < bins)
+      bins = b;
+  }
+
+  StftFrames stft;
+  if (!stft.begin(n, hop, win, bins, cellBytes, dbLo, dbHi))
+  {
+    server.send(500, "text/plain", "Out of memory");
+    return;
+  }
 
-  // Dominant frequency
-  double peakMag = 0;
-  double peakHz = 0;
+  StftHdr sh{};
+  memcpy(sh.magic, STFT_MAGIC, sizeof(sh.magic));
+  sh.hdr_bytes = sizeof(StftHdr);
+  sh.cell_bytes = cellBytes;
+  sh.window = (uint8_t)win;
+  sh.n = (uint16_t)n;
+  sh.bins = (uint16_t)bins;
+  sh.hop = hop;
+  sh.frames = frames;
+  sh.rate_hz = h.rate_hz;
+  sh.db_lo = stft.dbLo();
+  sh.db_step = stft.dbStep();
+  sh.axis = axisIdx == 3 ? 'm' : (char)('x' + axisIdx);
 
   server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-  server.send(200, "application/json");
+  server.sendHeader("Cache-Control", "no-store");
+  server.send(200, "application/octet-stream");
+
+  static uint8_t out[STFT_SEND_BYTES];
+  size_t outLen = 0;
+  memcpy(out, &sh, sizeof(sh));
+  outLen = sizeof(sh);
+
+  const ConvCoeffs cc = convCoeffsFromHeader(h);
+  static Sample6 blk[ANALYZE_BLOCK];
+  static float gx[ANALYZE_BLOCK], gy[ANALYZE_BLOCK], gz[ANALYZE_BLOCK];
+  size_t got;
+  uint32_t blocks = 0;
+  while (stft.frames() < frames && (got = rd.read(blk, ANALYZE_BLOCK)) > 0)
+  {
+    if (axisIdx == 3)
+    {
+      convertSamples(blk, got, h.res_bits, h.fs_g, cc, gx, gy, gz);
+      for (size_t k = 0; k < got; k++)
+        gx[k] = sqrtf(gx[k] * gx[k] + gy[k] * gy[k] + gz[k] * gz[k]);
+    }
+    else
+      convertSamples(blk, got, h.res_bits, h.fs_g, cc,
+                     axisIdx == 0 ? gx : nullptr, axisIdx == 1 ? gx : nullptr, axisIdx == 2 ? gx : nullptr);
 
-  server.sendContent("{");
-  server.sendContent("\"axis\":\"");
-  server.sendContent(String(axis));
-  server.sendContent("\",\"rate_hz\":");
-  server.sendContent(String(h.rate_hz));
-  server.sendContent(",\"df\":");
-  server.sendContent(String(df, 6));
-  server.sendContent(",\"fft\":[");
+    for (size_t off = 0; off < got;)
+    {
+      off += stft.push(gx + off, got - off);
+      if (!stft.frameReady())
+        continue;
+      if (outLen + stft.rowBytes() > sizeof(out))
+      {
+        server.sendContent((const char *)out, outLen);
+        outLen = 0;
+      }
+      if (stft.rowBytes() > sizeof(out))
+        server.sendContent((const char *)stft.row(), stft.rowBytes());
+      else
+      {
+        memcpy(out + outLen, stft.row(), stft.rowBytes());
+        outLen += stft.rowBytes();
+      }
+    }
+    if ((++blocks & 0x0F) == 0)
+      delay(0); // watchdog friendly
+  }
+  rd.close();
+  if (outLen)
+    server.sendContent((const char *)out, outLen);
+  server.sendContent("");
+}
 
-  for (uint32_t i = 1; i < bins; i++)
+// /api/envelope?file=&axis=x|y|z[&lo=][&hi=][&fmax=200][&n=1024][&win=hann]
+//              [&shaft=][&bpfo=][&bpfi=][&bsf=][&ftf=][&harm=3][&slip=1]
+// Envelope spectrum for bearing diagnostics (envelope.h): band-pass lo..hi
+// around a resonance (default rate/4 .. 0.45 rate), rectify + low-pass,
+// decimate to ~2.56 fmax, Welch. Streams the file block by block; RAM is
+// the Welch state only. Each defect frequency given (Hz) gets its first
+// harm harmonics matched within +-slip % (amplitude g, found Hz).
+void handleApiEnvelope()
+{
+  if (!server.hasArg("file"))
   {
-    double mag = vReal[i];
-    double hz = i * df;
+    server.send(400, "text/plain", "Missing file");
+    return;
+  }
 
-    if (mag > peakMag)
+  String path = server.arg("file");
+  if (!path.startsWith("/"))
+    path = "/" + path;
+  if (!isSafeAccelFile(path) || !LittleFS.exists(path))
+  {
+    server.send(404, "text/plain", "Bad file");
+    return;
+  }
+
+  const String axisArg = server.hasArg("axis") ? server.arg("axis") : String("x");
+  const int axisIdx = axisArg == "x" ? 0 : axisArg == "y" ? 1 : axisArg == "z" ? 2 : -1;
+  if (axisIdx < 0)
+  {
+    server.send(400, "text/plain", "Bad axis (x|y|z)");
+    return;
+  }
+  uint32_t n = server.hasArg("n") ? (uint32_t)server.arg("n").toInt() : FFT_N;
+  if (n < 64 || !fftSizeOk(n))
+  {
+    server.send(400, "text/plain", "Invalid n (64..4096, power of 2)");
+    return;
+  }
+  FftWindow win = FftWindow::Hann;
+  if (server.hasArg("win") && !fftWindowFromName(server.arg("win").c_str(), win))
+  {
+    server.send(400, "text/plain", "Invalid win (rect|hann|hamming|blackman|flattop)");
+    return;
+  }
+  int harm = server.hasArg("harm") ? server.arg("harm").toInt() : 3;
+  if (harm < 1 || harm > 10)
+  {
+    server.send(400, "text/plain", "Invalid harm (1..10)");
+    return;
+  }
+  const float slipPct = server.hasArg("slip") ? server.arg("slip").toFloat() : 1.0f;
+
+  RecReader rd;
+  if (!rd.open(path))
+  {
+    server.send(400, "text/plain", rd.error());
+    return;
+  }
+  const FileHeaderV3 &h = rd.header();
+  const float fs = h.rate_hz;
+  const float lo = server.hasArg("lo") ? server.arg("lo").toFloat() : fs / 4;
+  const float hi = server.hasArg("hi") ? server.arg("hi").toFloat() : 0.45f * fs;
+  float fmax = server.hasArg("fmax") ? server.arg("fmax").toFloat() : 200.0f;
+  if (fmax > lo / 2 && !server.hasArg("fmax"))
+    fmax = lo / 2;
+  EnvelopeDemod env;
+  if (!env.begin(fs, lo, hi, fmax))
+  {
+    server.send(400, "text/plain", "Invalid band (0 < fmax < lo < hi <= rate/2)");
+    return;
+  }
+
+  // envelope samples the file gives: the segment must fit at least once
+  const uint32_t envSamples = rd.samples() / env.decim();
+  while (n > 64 && n > envSamples)
+    n >>= 1;
+  if (envSamples < n)
+  {
+    server.send(400, "text/plain", "Too few samples");
+    return;
+  }
+  WelchPsd welch;
+  if (!welch.begin(n, win, n / 2))
+  {
+    server.send(500, "text/plain", "Out of memory");
+    return;
+  }
+
+  const uint32_t t0 = millis();
+  const ConvCoeffs cc = convCoeffsFromHeader(h);
+  static Sample6 blk[ANALYZE_BLOCK];
+  static float gx[ANALYZE_BLOCK], ge[ANALYZE_BLOCK + 1];
+  double envSum = 0, envSq = 0;
+  uint32_t envN = 0;
+  size_t got;
+  uint32_t blocks = 0;
+  while ((got = rd.read(blk, ANALYZE_BLOCK)) > 0)
+  {
+    convertSamples(blk, got, h.res_bits, h.fs_g, cc,
+                   axisIdx == 0 ? gx : nullptr, axisIdx == 1 ? gx : nullptr, axisIdx == 2 ? gx : nullptr);
+    const size_t m = env.push(gx, got, ge);
+    for (size_t k = 0; k < m; k++)
     {
-      peakMag = mag;
-      peakHz = hz;
+      envSum += ge[k];
+      envSq += (double)ge[k] * ge[k];
     }
+    envN += m;
+    welch.push(ge, m);
+    if ((++blocks & 0x0F) == 0)
+      delay(0); // watchdog friendly
+  }
+  rd.close();
+  const uint32_t computeMs = millis() - t0;
+  if (!welch.segments())
+  {
+    server.send(400, "text/plain", "Too few samples");
+    return;
+  }
 
-    server.sendContent(String(mag, 6));
-    if (i + 1 < bins)
-      server.sendContent(",");
+  const float rate = env.rate();
+  const float df = rate / (float)n;
+  const float envMean = envN ? (float)(envSum / envN) : 0.0f;
+  const float envRms = envN ? (float)sqrt(envSq / envN - (double)envMean * envMean) : 0.0f; // AC part
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json");
+
+  String s = "{";
+  s += "\"axis\":\"";
+  s += axisArg;
+  s += "\",\"rate_hz\":";
+  s += h.rate_hz;
+  s += ",\"band_hz\":[" + String(lo, 1) + "," + String(hi, 1) + "]";
+  s += ",\"fmax\":" + String(fmax, 1);
+  s += ",\"decim\":" + String(env.decim());
+  s += ",\"env_rate_hz\":" + String(rate, 3);
+  s += ",\"df\":" + String(df, 6);
+  s += ",\"n\":" + String(n);
+  s += ",\"window\":\"" + String(fftWindowName(win)) + "\"";
+  s += ",\"segments\":" + String(welch.segments());
+  s += ",\"env_mean_g\":" + String(envMean, 6);
+  s += ",\"env_rms_g\":" + String(envRms, 6);
+  s += ",\"ms\":" + String(computeMs);
+
+  // spectrum up to fmax (amplitude, g)
+  const uint32_t last = (uint32_t)(fmax / df) < n / 2 ? (uint32_t)(fmax / df) : n / 2 - 1;
+  float peakHz = 0, peakAmp = 0;
+  s += ",\"spectrum\":[";
+  for (uint32_t k = 1; k <= last; k++)
+  {
+    const float a = welch.amplitudeAt(k);
+    if (a > peakAmp)
+    {
+      peakAmp = a;
+      peakHz = k * df;
+    }
+    char num[16];
+    snprintf(num, sizeof(num), "%.6f", a);
+    s += num;
+    if (k < last)
+      s += ",";
+    if (s.length() > 1024)
+    {
+      server.sendContent(s);
+      s = "";
+    }
   }
+  s += "]";
+  s += ",\"peak_hz\":" + String(peakHz, 3);
+  s += ",\"peak_amp\":" + String(peakAmp, 6);
 
-  server.sendContent("],");
-  server.sendContent("\"peak_hz\":");
-  server.sendContent(String(peakHz, 3));
-  server.sendContent(",");
-  server.sendContent("\"peak_mag\":");
-  server.sendContent(String(peakMag, 6));
-  server.sendContent("}");
+  // matched harmonics of the defect / shaft frequencies the caller gave
+  static const char *const defects[] = {"shaft", "bpfo", "bpfi", "bsf", "ftf"};
+  s += ",\"defects\":{";
+  bool firstDefect = true;
+  for (const char *name : defects)
+  {
+    const float f = server.hasArg(name) ? server.arg(name).toFloat() : 0.0f;
+    if (f <= 0)
+      continue;
+    s += firstDefect ? "\"" : ",\"";
+    firstDefect = false;
+    s += name;
+    s += "\":{\"hz\":" + String(f, 3) + ",\"amp\":[";
+    String at = "";
+    for (int k = 1; k <= harm; k++)
+    {
+      float atHz = 0;
+      const float a = k * f < rate / 2 ? envelopeLineAt(welch, rate, k * f, k * f * slipPct / 100.0f, atHz) : 0.0f;
+      char num[16];
+      snprintf(num, sizeof(num), "%.6f", a);
+      s += num;
+      at += String(atHz, 3);
+      if (k < harm)
+      {
+        s += ",";
+        at += ",";
+      }
+    }
+    s += "],\"at_hz\":[" + at + "]}";
+  }
+  s += "}}";
+  server.sendContent(s);
 }
 
 // ======================= Route registration =======================
@@ -1502,6 +2642,7 @@ void registerRoutes()
 
   server.on("/api/start", handleApiStart);
   server.on("/api/stop", handleApiStop);
+  server.on("/api/stream", handleApiStream);
 
   server.on("/download", handleDownload);
   server.on("/download_csv", handleDownloadCSV);
@@ -1511,6 +2652,7 @@ void registerRoutes()
   server.on("/api/calibrate6", handleApiCalibrate6);
 
   server.on("/api/live", handleApiLive);
+  server.on("/api/livefft", handleApiLiveFft);
 
   server.on("/api/reset", handleApiReset);
   server.on("/update", HTTP_GET, handleUpdateGet);
@@ -1519,6 +2661,8 @@ void registerRoutes()
   server.on("/api/version", handleApiVersion);
   server.on("/api/analyze", handleApiAnalyze);
   server.on("/api/fft", handleApiFFT);
+  server.on("/api/stft", handleApiSTFT);
+  server.on("/api/envelope", handleApiEnvelope);
 }
 
 // ======================= CSV exporter (senin V3’tekiyle aynı) =======================
@@ -1544,26 +2688,13 @@ void handleDownloadCSV()
     return;
   }
 
-  File f = LittleFS.open(path, "r");
-  if (!f)
-  {
-    server.send(500, "text/plain", "Open failed");
-    return;
-  }
-  if (f.size() < (int)sizeof(FileHeaderV3))
-  {
-    f.close();
-    server.send(400, "text/plain", "Bad file");
-    return;
-  }
-
-  FileHeaderV3 h{};
-  if (f.read((uint8_t *)&h, sizeof(h)) != sizeof(h))
+  RecReader rd;
+  if (!rd.open(path))
   {
-    f.close();
-    server.send(400, "text/plain", "Read header failed");
+    server.send(400, "text/plain", rd.error());
     return;
   }
+  const FileHeaderV3 &h = rd.header();
 
   String basename = path;
   if (basename.startsWith("/"))
@@ -1587,6 +2718,7 @@ void handleDownloadCSV()
   hdr += "# fs_g=" + String(h.fs_g) + "\n";
   hdr += "# res_bits=" + String(h.res_bits) + "\n";
   hdr += "# q_bits=" + String(h.q_bits) + "\n";
+  hdr += "# version=" + String(h.version) + "\n";
   hdr += "t_ms,ax_raw,ay_raw,az_raw\n";
   hdr += "# fs_g=" + String(h.fs_g) + "\n";
   hdr += "# res_bits=" + String(h.res_bits) + "\n";
@@ -1599,31 +2731,36 @@ void handleDownloadCSV()
   uint32_t t_ms = 0;
 
   char line[96];
-  Sample6 s;
+  static Sample6 blk[ANALYZE_BLOCK];
   String chunk;
   chunk.reserve(2048);
 
-  while (f.read((uint8_t *)&s, sizeof(s)) == sizeof(s))
+  size_t got;
+  while ((got = rd.read(blk, ANALYZE_BLOCK)) > 0)
   {
-    int n = snprintf(line, sizeof(line), "%lu,%d,%d,%d\n",
-                     (unsigned long)t_ms, (int)s.ax, (int)s.ay, (int)s.az);
-    if (n > 0)
-      chunk += String(line);
+    for (size_t k = 0; k < got; k++)
+    {
+      const Sample6 &s = blk[k];
+      int n = snprintf(line, sizeof(line), "%lu,%d,%d,%d\n",
+                       (unsigned long)t_ms, (int)s.ax, (int)s.ay, (int)s.az);
+      if (n > 0)
+        chunk += String(line);
 
-    t_ms += dt_ms;
+      t_ms += dt_ms;
 
-    if (chunk.length() > 1800)
-    {
-      server.sendContent(chunk);
-      chunk = "";
-      delay(0);
+      if (chunk.length() > 1800)
+      {
+        server.sendContent(chunk);
+        chunk = "";
+        delay(0);
+      }
     }
   }
 
   if (chunk.length())
     server.sendContent(chunk);
   server.sendContent("");
-  f.close();
+  rd.close();
 }
 
 
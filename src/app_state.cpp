@@ -5,9 +5,8 @@ WebServer server(80);
 String g_updateLastError = "";
 size_t g_updateExpected = 0;
 
-SemaphoreHandle_t g_i2cMutex = nullptr;
-
 volatile bool g_recording = false;
+volatile bool g_streaming = false;
 volatile bool g_stopRequested = false;
 
 volatile bool g_calibratingStatic = false;
@@ -17,9 +16,38 @@ volatile int g_calibStep = -1; // 0..5
 RecConfig g_cfg{};
 volatile uint32_t g_samplesWritten = 0;
 volatile uint32_t g_maxBacklog = 0;
+volatile uint32_t g_fifoOverruns = 0;
+volatile uint32_t g_acqWakeups = 0;
+volatile uint32_t g_acqTimeouts = 0;
+volatile uint32_t g_firstSampleUs = 0;
 volatile uint32_t g_elapsedMs = 0;
+volatile uint32_t g_ringHighWater = 0;
+volatile uint32_t g_ringDropped = 0;
+volatile uint32_t g_wrMaxUs = 0;
+volatile uint32_t g_wrStalls = 0;
+volatile uint32_t g_wrStallMs = 0;
+volatile uint32_t g_wrBytes = 0;
+volatile uint32_t g_wrBps = 0;
+volatile uint32_t g_wrRawBytes = 0;
+volatile uint32_t g_encMaxUs = 0;
+uint16_t g_repairedFiles = 0;
+volatile uint32_t g_segCount = 0;
+volatile uint32_t g_segSwitchLastUs = 0;
+volatile uint32_t g_segSwitchMaxUs = 0;
+volatile uint32_t g_segDropped = 0;
+volatile uint32_t g_decMaxUs = 0;
+volatile uint32_t g_decBusyUs = 0;
+volatile uint32_t g_retDeleted = 0;
+volatile uint32_t g_retFreedKB = 0;
+RecHealth g_health{};
+volatile uint32_t g_stFrames = 0;
+volatile uint32_t g_stDropped = 0;
+volatile uint32_t g_stBytes = 0;
+volatile uint32_t g_stBps = 0;
+volatile uint32_t g_stSendMaxUs = 0;
+volatile uint32_t g_stStalls = 0;
+volatile uint32_t g_stRingHighWater = 0;
 
-TaskHandle_t g_recTask = nullptr;
 String g_currentFile = ""; // "/accelYYMMDDHHMMSS.dat"
 String g_uiTimestamp = ""; // "YYMMDDHHMMSS"
 
@@ -37,6 +65,14 @@ float g_live_mag_acc = 0;
 float g_live_mag_vel_mmps = 0;
 float g_live_mag_disp_mm = 0;
 volatile bool g_calDirty = true; // calibration changed -> reload NVS
+uint32_t g_liveSetupUs = 0;
+uint32_t g_liveTxSaved = 0;
+portMUX_TYPE g_liveMux = portMUX_INITIALIZER_UNLOCKED;
+uint8_t g_liveRateHz = 4;
+float g_liveCpuPct = 0;
+uint32_t g_liveWindowN = 0;
+uint32_t g_liveOverruns = 0;
+uint32_t g_liveServeUs = 0;
 
 bool g_apMode = false;
 String g_apSsid = "";
@@ -4,28 +4,9 @@
 #include <WebServer.h>
 
 #include "LIS2DW12_ESP32.h"
-
-#pragma pack(push, 1)
-struct FileHeaderV3
-{
-  char magic[8];     // "LIS2DW12"
-  uint16_t version;  // 3
-  uint16_t rate_hz;  // selected
-  uint16_t record_s; // selected
-  uint32_t samples;  // actually written
-  uint8_t fs_g;      // 2/4/8/16
-  uint8_t res_bits;  // 12/14
-  uint8_t q_bits;    // 0/10/12/14
-  uint8_t reserved0;
-  float cal_offset_g[3];
-  float cal_scale[3];
-};
-
-struct Sample6
-{
-  int16_t ax, ay, az; // aligned raw
-};
-#pragma pack(pop)
+#include "acq_source.h"
+#include "rec_format.h"
+#include "rec_trailer.h"
 
 struct RecConfig
 {
@@ -33,7 +14,16 @@ struct RecConfig
   uint16_t sec = 60;
   uint8_t fs_g = 2;
   uint8_t qBits = 0;
+  uint8_t fileVersion = 4; // 3 = raw Sample6, 4 = compressed blocks
+  uint8_t codec = REC_CODEC_DELTA_RICE; // V4 block codec (PACK* with qBits 12 / 10)
+  bool continuous = false;  // rotate segments until stopped (sec unused)
+  uint16_t segSec = 60;     // continuous: segment length
+  uint32_t segKB = 0;       // continuous: optional segment size cap
+  uint32_t minFreeKB = 0;   // retention quota, 0 = keep everything
+  uint8_t decMain = 0;      // main file stores the /decMain stream (0 = full rate)
+  uint8_t decSides = 0;     // OR of factors (2|4|8|16) stored as _d<M> companions
   LIS2DW12::Mode mode = LIS2DW12::Mode::HighPerf; // LP/HP
+  AcqSource acq = AcqSource::Timer;                // recording wake-up source
 };
 
 extern WebServer server;
@@ -41,9 +31,8 @@ extern WebServer server;
 extern String g_updateLastError;
 extern size_t g_updateExpected;
 
-extern SemaphoreHandle_t g_i2cMutex;
-
 extern volatile bool g_recording;
+extern volatile bool g_streaming; // live TCP stream session (no flash)
 extern volatile bool g_stopRequested;
 
 extern volatile bool g_calibratingStatic;
@@ -53,9 +42,38 @@ extern volatile int g_calibStep; // 0..5
 extern RecConfig g_cfg;
 extern volatile uint32_t g_samplesWritten;
 extern volatile uint32_t g_maxBacklog;
+extern volatile uint32_t g_fifoOverruns;
+extern volatile uint32_t g_acqWakeups;
+extern volatile uint32_t g_acqTimeouts; // waits that ended without a wake-up
+extern volatile uint32_t g_firstSampleUs; // sensor job submit -> first sample
 extern volatile uint32_t g_elapsedMs;
+extern volatile uint32_t g_ringHighWater; // writer ring: most blocks queued at once
+extern volatile uint32_t g_ringDropped;   // blocks lost because the ring was full
+extern volatile uint32_t g_wrMaxUs;       // slowest single block write
+extern volatile uint32_t g_wrStalls;      // writes slower than REC_STALL_US
+extern volatile uint32_t g_wrStallMs;     // total time spent in those
+extern volatile uint32_t g_wrBytes;       // bytes written this session
+extern volatile uint32_t g_wrBps;         // flash throughput while writing (bytes/s)
+extern volatile uint32_t g_wrRawBytes;    // Sample6 bytes handed to the writer
+extern volatile uint32_t g_encMaxUs;      // slowest V4 block encode
+extern uint16_t g_repairedFiles;          // interrupted recordings fixed at boot
+extern volatile uint32_t g_segCount;        // segments opened this session
+extern volatile uint32_t g_segSwitchLastUs; // last rotation: close + open
+extern volatile uint32_t g_segSwitchMaxUs;
+extern volatile uint32_t g_segDropped;      // samples lost across rotations
+extern volatile uint32_t g_decMaxUs;        // slowest block through all decimators
+extern volatile uint32_t g_decBusyUs;       // decimation time this session
+extern volatile uint32_t g_retDeleted;      // files removed by retention (since boot)
+extern volatile uint32_t g_retFreedKB;
+extern RecHealth g_health;                  // current session, written by the acquisition loop
+extern volatile uint32_t g_stFrames;        // stream: frames sent
+extern volatile uint32_t g_stDropped;       // stream: blocks dropped (ring full)
+extern volatile uint32_t g_stBytes;
+extern volatile uint32_t g_stBps;           // stream: sustained bytes/s since connect
+extern volatile uint32_t g_stSendMaxUs;     // stream: slowest frame write
+extern volatile uint32_t g_stStalls;        // stream: writes slower than STREAM_SEND_STALL_US
+extern volatile uint32_t g_stRingHighWater;
 
-extern TaskHandle_t g_recTask;
 extern String g_currentFile; // "/accelYYMMDDHHMMSS.dat"
 extern String g_uiTimestamp; // "YYMMDDHHMMSS"
 
@@ -67,12 +85,20 @@ extern const uint16_t LIVE_PREVIEW_HZ;
 extern float g_live_lp_cut_hz; // default low-pass cutoff for preview
 extern const float GRAVITY_MPS2;
 extern float g_live_acc_mps2[3];
-extern float g_live_vel_mmps[3];
-extern float g_live_disp_mm[3];
+extern float g_live_vel_mmps[3]; // velocity RMS, 10 Hz .. LIVE_PREVIEW_HZ / 2.56
+extern float g_live_disp_mm[3];  // displacement peak-to-peak, same band
 extern float g_live_mag_acc;
 extern float g_live_mag_vel_mmps;
 extern float g_live_mag_disp_mm;
 extern volatile bool g_calDirty; // calibration changed -> reload NVS
+extern uint32_t g_liveSetupUs;    // driver setup time of the last live capture
+extern uint32_t g_liveTxSaved;    // bus transactions skipped by the CTRL shadow
+extern portMUX_TYPE g_liveMux;     // guards the g_live_* values (sampler writes, handlers copy)
+extern uint8_t g_liveRateHz;       // live values published per second
+extern float g_liveCpuPct;         // sampler busy time (bus included) per wall time
+extern uint32_t g_liveWindowN;     // samples behind the published values
+extern uint32_t g_liveOverruns;    // sampler: FIFO overruns since it started
+extern uint32_t g_liveServeUs;     // /api/live: time of the last answer
 
 extern bool g_apMode;
 extern String g_apSsid;
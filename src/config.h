@@ -10,5 +10,11 @@
 #define BUILD_HASH "nogit"
 #endif
 
+// LIS2DW12 INT1 -> ESP32 GPIO. -1 = not wired (recording falls back to the
+// hw_timer wake-up source). e.g. -D LIS_INT1_PIN=19
+#ifndef LIS_INT1_PIN
+#define LIS_INT1_PIN -1
+#endif
+
 extern const char *WIFI_SSID;
 extern const char *WIFI_PASS;
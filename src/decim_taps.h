@@ -0,0 +1,72 @@
+#pragma once
+
+// Generated by tools/fir_design.cpp - do not edit by hand.
+// Q15 anti-alias FIR taps for the decimation stage, DC gain exactly 1.
+// Kaiser beta 6.20, 20 taps per phase; passband 0.4 fs_out, stopband 0.6 fs_out.
+#include <stdint.h>
+
+static const uint16_t DECIM_TAPS_PER_PHASE = 20;
+
+// /2: passband ripple 0.008 dB, stopband -60.1 dB
+static const int16_t DECIM_TAPS_2[40] = {
+    -5, -11, 21, 35, -54, -81, 116, 161, -218, -290, 380, 493,
+    -637, -821, 1066, 1407, -1922, -2816, 4835, 14725, 14725, 4835, -2816, -1922,
+    1407, 1066, -821, -637, 493, 380, -290, -218, 161, 116, -81, -54,
+    35, 21, -11, -5};
+
+// /4: passband ripple 0.007 dB, stopband -63.4 dB
+static const int16_t DECIM_TAPS_4[80] = {
+    -1, -5, -7, -4, 5, 17, 22, 11, -14, -42, -51, -25,
+    30, 86, 101, 49, -56, -157, -181, -86, 98, 270, 307, 144,
+    -164, -448, -508, -239, 272, 749, 859, 411, -480, -1372, -1658, -855,
+    1115, 3812, 6399, 7980, 7980, 6399, 3812, 1115, -855, -1658, -1372, -480,
+    411, 859, 749, 272, -239, -508, -448, -164, 144, 307, 270, 98,
+    -86, -181, -157, -56, 49, 101, 86, 30, -25, -51, -42, -14,
+    11, 22, 17, 5, -4, -7, -5, -1};
+
+// /8: passband ripple 0.009 dB, stopband -62.7 dB
+static const int16_t DECIM_TAPS_8[160] = {
+    0, -1, -2, -3, -4, -4, -3, -1, 1, 4, 8, 10,
+    11, 11, 8, 3, -4, -11, -19, -24, -27, -25, -18, -7,
+    8, 23, 38, 48, 52, 48, 35, 13, -14, -43, -69, -88,
+    -94, -85, -61, -23, 24, 74, 119, 149, 159, 144, 102, 38,
+    -41, -123, -196, -247, -262, -237, -169, -63, 67, 204, 327, 412,
+    441, 401, 288, 109, -118, -363, -592, -763, -838, -786, -586, -232,
+    265, 875, 1556, 2253, 2907, 3460, 3860, 4075, 4075, 3860, 3460, 2907,
+    2253, 1556, 875, 265, -232, -586, -786, -838, -763, -592, -363, -118,
+    109, 288, 401, 441, 412, 327, 204, 67, -63, -169, -237, -262,
+    -247, -196, -123, -41, 38, 102, 144, 159, 149, 119, 74, 24,
+    -23, -61, -85, -94, -88, -69, -43, -14, 13, 35, 48, 52,
+    48, 38, 23, 8, -7, -18, -25, -27, -24, -19, -11, -4,
+    3, 8, 11, 11, 10, 8, 4, 1, -1, -3, -4, -4,
+    -3, -2, -1, 0};
+
+// /16: passband ripple 0.005 dB, stopband -64.2 dB
+static const int16_t DECIM_TAPS_16[320] = {
+    0, 0, 0, -1, -1, -1, -1, -2, -2, -2, -2, -2,
+    -2, -1, -1, 0, 0, 1, 2, 3, 4, 4, 5, 5,
+    6, 6, 6, 5, 5, 4, 2, 1, -1, -3, -5, -7,
+    -9, -10, -12, -13, -13, -13, -13, -12, -10, -8, -5, -2,
+    2, 6, 10, 14, 17, 21, 23, 25, 26, 26, 25, 23,
+    20, 15, 10, 3, -4, -11, -18, -25, -32, -38, -42, -46,
+    -47, -47, -45, -41, -34, -26, -17, -6, 6, 19, 31, 43,
+    55, 64, 72, 77, 80, 79, 75, 68, 58, 44, 28, 10,
+    -10, -31, -52, -72, -90, -106, -119, -127, -131, -130, -124, -112,
+    -95, -73, -46, -16, 17, 51, 85, 119, 150, 176, 198, 213,
+    220, 219, 209, 190, 162, 125, 80, 28, -29, -89, -151, -212,
+    -269, -321, -364, -396, -415, -419, -406, -375, -325, -256, -167, -60,
+    64, 204, 357, 520, 691, 866, 1040, 1212, 1376, 1529, 1667, 1788,
+    1888, 1966, 2018, 2043, 2043, 2018, 1966, 1888, 1788, 1667, 1529, 1376,
+    1212, 1040, 866, 691, 520, 357, 204, 64, -60, -167, -256, -325,
+    -375, -406, -419, -415, -396, -364, -321, -269, -212, -151, -89, -29,
+    28, 80, 125, 162, 190, 209, 219, 220, 213, 198, 176, 150,
+    119, 85, 51, 17, -16, -46, -73, -95, -112, -124, -130, -131,
+    -127, -119, -106, -90, -72, -52, -31, -10, 10, 28, 44, 58,
+    68, 75, 79, 80, 77, 72, 64, 55, 43, 31, 19, 6,
+    -6, -17, -26, -34, -41, -45, -47, -47, -46, -42, -38, -32,
+    -25, -18, -11, -4, 3, 10, 15, 20, 23, 25, 26, 26,
+    25, 23, 21, 17, 14, 10, 6, 2, -2, -5, -8, -10,
+    -12, -13, -13, -13, -13, -12, -10, -9, -7, -5, -3, -1,
+    1, 2, 4, 5, 5, 6, 6, 6, 5, 5, 4, 4,
+    3, 2, 1, 0, 0, -1, -1, -2, -2, -2, -2, -2,
+    -2, -1, -1, -1, -1, 0, 0, 0};
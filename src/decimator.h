@@ -0,0 +1,171 @@
+#pragma once
+
+// Decimation stage: anti-alias FIR + downsample by 2, 4, 8 or 16, fixed
+// point (Q15 taps from decim_taps.h, int32 accumulators). Only every M-th
+// output is evaluated, straight from a linear history window - the same
+// L/M multiply-adds per input sample as a polyphase bank, without the
+// commutator bookkeeping.
+//
+// Timing: the history starts primed with the first sample (no step from
+// the gravity offset) and the group delay (exactly DECIM_TAPS_PER_PHASE/2
+// outputs for every factor) is dropped at the start and flushed at the end,
+// so output m lines up with input m*M (+ half an input sample) and N inputs
+// give ceil(N / M) outputs.
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "decim_taps.h"
+#include "rec_format.h"
+
+static const uint8_t DECIM_FACTORS[] = {2, 4, 8, 16};
+static const uint8_t DECIM_DELAY_OUT = DECIM_TAPS_PER_PHASE / 2;
+
+inline const int16_t *decimTaps(uint8_t factor, uint16_t &len)
+{
+  len = (uint16_t)(DECIM_TAPS_PER_PHASE * factor);
+  switch (factor)
+  {
+  case 2:
+    return DECIM_TAPS_2;
+  case 4:
+    return DECIM_TAPS_4;
+  case 8:
+    return DECIM_TAPS_8;
+  case 16:
+    return DECIM_TAPS_16;
+  default:
+    len = 0;
+    return nullptr;
+  }
+}
+
+inline bool decimFactorOk(uint8_t factor)
+{
+  uint16_t len;
+  return decimTaps(factor, len) != nullptr;
+}
+
+class RecDecimator
+{
+public:
+  RecDecimator() = default;
+  RecDecimator(const RecDecimator &) = delete;
+  RecDecimator &operator=(const RecDecimator &) = delete;
+  ~RecDecimator() { end(); }
+
+  // Allocates 3 * 2L int16 of history (L = 20 * factor).
+  bool begin(uint8_t factor)
+  {
+    end();
+    _taps = decimTaps(factor, _len);
+    if (!_taps)
+      return false;
+    _hist = (int16_t *)malloc(3 * 2 * _len * sizeof(int16_t));
+    if (!_hist)
+      return false;
+    _factor = factor;
+    _pos = 0;
+    _countdown = 1;
+    _skip = DECIM_DELAY_OUT;
+    _primed = false;
+    return true;
+  }
+
+  void end()
+  {
+    free(_hist);
+    _hist = nullptr;
+    _factor = 0;
+  }
+
+  uint8_t factor() const { return _factor; }
+
+  // Returns outputs written; out must hold n / factor + 1.
+  size_t push(const Sample6 *in, size_t n, Sample6 *out)
+  {
+    if (!_hist || !n)
+      return 0;
+    if (!_primed)
+      prime(in[0]);
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+      add(in[i]);
+      if (--_countdown)
+        continue;
+      _countdown = _factor;
+      if (_skip)
+      {
+        _skip--;
+        continue;
+      }
+      out[k].ax = dot(0);
+      out[k].ay = dot(1);
+      out[k].az = dot(2);
+      k++;
+    }
+    return k;
+  }
+
+  // End of stream: holds the last sample to push out what the group delay
+  // kept back. out must hold DECIM_DELAY_OUT.
+  size_t flush(Sample6 *out)
+  {
+    if (!_hist || !_primed)
+      return 0;
+    const size_t hold = _pos ? _pos - 1 : _len - 1;
+    const Sample6 last = {_hist[hold], _hist[2 * _len + hold], _hist[4 * _len + hold]};
+    size_t k = 0;
+    for (uint16_t i = 0; i < DECIM_DELAY_OUT * _factor; i++)
+      k += push(&last, 1, out + k);
+    return k;
+  }
+
+private:
+  // Axis a lives at _hist[a * 2L ..]; every sample is written twice (pos and
+  // pos + L) so the newest L samples are always contiguous at _hist[pos ..].
+  void add(const Sample6 &s)
+  {
+    int16_t *h = _hist + _pos;
+    h[0] = h[_len] = s.ax;
+    h += 2 * _len;
+    h[0] = h[_len] = s.ay;
+    h += 2 * _len;
+    h[0] = h[_len] = s.az;
+    if (++_pos == _len)
+      _pos = 0;
+  }
+
+  void prime(const Sample6 &s)
+  {
+    for (uint16_t i = 0; i < _len; i++)
+      add(s);
+    _primed = true;
+  }
+
+  // Taps are symmetric, so oldest-first history against taps in order is
+  // the convolution.
+  int16_t dot(int axis) const
+  {
+    const int16_t *x = _hist + axis * 2 * _len + _pos;
+    int32_t acc = 1 << 14; // round to nearest
+    for (uint16_t i = 0; i < _len; i++)
+      acc += (int32_t)_taps[i] * x[i];
+    acc >>= 15;
+    if (acc > INT16_MAX)
+      acc = INT16_MAX;
+    if (acc < INT16_MIN)
+      acc = INT16_MIN;
+    return (int16_t)acc;
+  }
+
+  const int16_t *_taps = nullptr;
+  int16_t *_hist = nullptr;
+  uint16_t _len = 0;
+  uint16_t _pos = 0;
+  uint8_t _factor = 0;
+  uint8_t _countdown = 1;
+  uint8_t _skip = 0;
+  bool _primed = false;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+// Envelope (demodulation) analysis for rolling-element bearings: impacts
+// from a defect ring a structural resonance, so the fault rate shows up as
+// modulation of a high-frequency band rather than as a line of its own.
+//   x -> band-pass lo .. hi (4th order Butterworth high-pass, 4th order
+//        low-pass unless hi is at Nyquist)
+//     -> full-wave rectify -> 4th order low-pass at fmax -> * pi/2
+//     -> keep every D-th sample (D = fs / (2.56 fmax))
+// The pi/2 makes the output the envelope amplitude in g (a rectified sine
+// of amplitude A averages 2A/pi), so a line at f_mod of the envelope
+// spectrum reads A * m for A (1 + m cos) modulation. Fixed state, any
+// length of input; the envelope spectrum itself is a WelchPsd fed with the
+// decimated output.
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iir_svf.h"
+#include "welch_psd.h"
+
+class EnvelopeDemod
+{
+public:
+  // false if the bands do not fit: lo < hi <= fs/2, fmax < lo.
+  bool begin(float fs, float lo, float hi, float fmax)
+  {
+    _ok = false;
+    if (fs <= 0 || lo <= 0 || hi <= lo || hi > 0.5f * fs || fmax <= 0 || fmax >= lo)
+      return false;
+    _bandLp = hi < 0.45f * fs;
+    _hp[0].setup(true, lo, fs, 0.5411961f);
+    _hp[1].setup(true, lo, fs, 1.3065630f);
+    _lp[0].setup(false, _bandLp ? hi : 0.25f * fs, fs, 0.5411961f);
+    _lp[1].setup(false, _bandLp ? hi : 0.25f * fs, fs, 1.3065630f);
+    _env[0].setup(false, fmax, fs, 0.5411961f);
+    _env[1].setup(false, fmax, fs, 1.3065630f);
+    _decim = (uint32_t)(fs / (2.56f * fmax));
+    if (_decim < 1)
+      _decim = 1;
+    _rate = fs / (float)_decim;
+    // band-pass and envelope low-pass ring for a few periods of their corners
+    _skip = (uint32_t)(fs * (3.0f / lo + 3.0f / fmax));
+    _phase = 0;
+    _n = 0;
+    _ok = true;
+    return true;
+  }
+
+  bool ok() const { return _ok; }
+  uint32_t decim() const { return _decim; }
+  float rate() const { return _rate; }
+
+  // out must hold k / decim() + 1 samples; returns how many were written.
+  size_t push(const float *x, size_t k, float *out)
+  {
+    if (!_ok)
+      return 0;
+    size_t m = 0;
+    for (size_t i = 0; i < k; i++)
+    {
+      if (!_n)
+      {
+        _hp[0].prime(x[0]);
+        _hp[1].prime(0);
+        for (SvfSection &s : _lp)
+          s.prime(0);
+        for (SvfSection &s : _env)
+          s.prime(0);
+      }
+      float b = _hp[1].run(_hp[0].run(x[i]));
+      if (_bandLp)
+        b = _lp[1].run(_lp[0].run(b));
+      const float e = _env[1].run(_env[0].run(fabsf(b)));
+      _n++;
+      if (_n <= _skip)
+        continue;
+      if (++_phase < _decim)
+        continue;
+      _phase = 0;
+      out[m++] = e * 1.5707963f;
+    }
+    return m;
+  }
+
+private:
+  SvfSection _hp[2], _lp[2], _env[2];
+  bool _bandLp = false;
+  bool _ok = false;
+  uint32_t _decim = 1;
+  uint32_t _phase = 0;
+  uint32_t _skip = 0;
+  uint32_t _n = 0;
+  float _rate = 0;
+};
+
+// Amplitude of the strongest line of envelope spectrum w (sampled at rate)
+// within +-tol Hz (at least one bin) of f; its bin frequency goes to atHz.
+// The tolerance absorbs the slip of defect harmonics against the nominal
+// rate. Power is summed over the peak bin +-2 and divided by the window's
+// ENBW, so a line between bins reads the same as one on a bin (the peak
+// bin alone would be up to 15 % low with Hann).
+inline float envelopeLineAt(const WelchPsd &w, float rate, float f, float tol, float &atHz)
+{
+  atHz = 0;
+  const float df = rate / (float)w.n();
+  if (!w.segments() || df <= 0 || f <= 0)
+    return 0;
+  if (tol < df)
+    tol = df;
+  const int32_t last = (int32_t)w.bins() - 2;
+  int32_t k0 = (int32_t)floorf((f - tol) / df), k1 = (int32_t)ceilf((f + tol) / df);
+  if (k0 < 1)
+    k0 = 1;
+  if (k1 > last)
+    k1 = last;
+  if (k0 > k1)
+    return 0;
+  int32_t kp = k0;
+  for (int32_t k = k0 + 1; k <= k1; k++)
+    if (w.amplitudeAt(k) > w.amplitudeAt(kp))
+      kp = k;
+  atHz = kp * df;
+  double p = 0;
+  for (int32_t k = kp - 2; k <= kp + 2; k++)
+    if (k >= 1 && k <= last)
+      p += (double)w.amplitudeAt(k) * w.amplitudeAt(k);
+  return (float)sqrt(p / w.enbw());
+}
@@ -0,0 +1,322 @@
+#include "event_push.h"
+
+#include <LittleFS.h>
+#include <WiFi.h>
+
+#include "live_sampler.h"
+
+static WiFiServer s_server(EVENTS_PORT);
+static TaskHandle_t s_task = nullptr;
+
+struct Viewer
+{
+  WiFiClient c;
+  bool used = false;
+  uint8_t rate = 0;      // live frames per second, 0 = status only
+  uint32_t nextLiveMs = 0;
+  uint32_t liveMs = 0;   // publication (g_liveLastMs) last sent
+};
+static Viewer s_viewers[EVENTS_MAX_VIEWERS];
+static volatile uint8_t s_viewerN = 0;
+
+// Connections whose request is still arriving; read as far as it has come
+// on every tick, so a slow or silent client never stalls the task.
+struct Pending
+{
+  WiFiClient c;
+  bool used = false;
+  uint32_t sinceMs = 0;
+  char line[96];         // request line (truncated)
+  uint8_t lineLen = 0;
+  bool lineDone = false;
+  bool blankSoFar = true; // current header line is empty (bar '\r')
+};
+static Pending s_pending[EVENTS_MAX_PENDING];
+
+// LittleFS figures for the status events: usedBytes() walks the file
+// system, so it is refreshed now and then, not on every status tick.
+static uint32_t s_fsUsed = 0, s_fsTotal = 0, s_fsMs = 0;
+static bool s_fsValid = false, s_fsRec = false;
+
+// What status events describe; the last sent copy gives the deltas.
+struct EvStatus
+{
+  bool rec, st, calStatic, cal6;
+  int calibStep;
+  uint32_t samples, elapsedMs, ringDropped;
+  uint8_t viewers;
+  uint32_t fsUsed, fsTotal;
+};
+static EvStatus s_sent;
+static bool s_sentValid = false;
+
+static EvStatus statusNow()
+{
+  EvStatus s;
+  s.rec = g_recording;
+  s.st = g_streaming;
+  s.calStatic = g_calibratingStatic;
+  s.cal6 = g_calibrating6;
+  s.calibStep = g_calibStep;
+  s.samples = g_samplesWritten;
+  s.elapsedMs = g_elapsedMs;
+  s.ringDropped = g_ringDropped;
+  s.viewers = s_viewerN;
+  s.fsUsed = s_fsUsed;
+  s.fsTotal = s_fsTotal;
+  return s;
+}
+
+// Fields of a that differ from b (all of them when full), as JSON.
+static String statusJson(const EvStatus &a, const EvStatus &b, bool full)
+{
+  String s = "{";
+  auto add = [&](bool changed, const char *key, const String &v)
+  {
+    if (!full && !changed)
+      return;
+    if (s.length() > 1)
+      s += ",";
+    s += "\"" + String(key) + "\":" + v;
+  };
+  add(a.rec != b.rec, "rec", a.rec ? "true" : "false");
+  add(a.st != b.st, "st", a.st ? "true" : "false");
+  add(a.calStatic != b.calStatic, "cal_static", a.calStatic ? "true" : "false");
+  add(a.cal6 != b.cal6, "cal6", a.cal6 ? "true" : "false");
+  add(a.calibStep != b.calibStep, "calib_step", String(a.calibStep));
+  add(a.samples != b.samples, "samples", String(a.samples));
+  add(a.elapsedMs != b.elapsedMs, "elapsed_ms", String(a.elapsedMs));
+  add(a.ringDropped != b.ringDropped, "ring_dropped", String(a.ringDropped));
+  add(a.viewers != b.viewers, "viewers", String(a.viewers));
+  add(a.fsUsed != b.fsUsed, "fs_used", String(a.fsUsed));
+  add(a.fsTotal != b.fsTotal, "fs_total", String(a.fsTotal));
+  s += "}";
+  return s;
+}
+
+static void drop(Viewer &v)
+{
+  v.c.stop();
+  v.used = false;
+  s_viewerN--;
+}
+
+static void sendTo(Viewer &v, const String &ev)
+{
+  if (v.c.write((const uint8_t *)ev.c_str(), ev.length()) != ev.length())
+    drop(v);
+}
+
+static void refreshFs(uint32_t now)
+{
+  const bool rec = g_recording;
+  const uint32_t every = rec ? EVENTS_FS_REC_MS : EVENTS_FS_IDLE_MS;
+  if (s_fsValid && rec == s_fsRec && now - s_fsMs < every)
+    return;
+  s_fsTotal = (uint32_t)LittleFS.totalBytes();
+  s_fsUsed = (uint32_t)LittleFS.usedBytes();
+  s_fsMs = now;
+  s_fsRec = rec;
+  s_fsValid = true;
+}
+
+// Complete request: answers and keeps the connection, or closes it.
+static void admit(WiFiClient &c, const String &line)
+{
+  if (!line.startsWith("GET /events"))
+  {
+    c.print("HTTP/1.1 404 Not Found\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n");
+    c.stop();
+    return;
+  }
+  Viewer *v = nullptr;
+  for (Viewer &x : s_viewers)
+    if (!x.used)
+    {
+      v = &x;
+      break;
+    }
+  if (!v)
+  {
+    c.print("HTTP/1.1 503 Service Unavailable\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n");
+    c.stop();
+    return;
+  }
+
+  long rate = LIVE_RATE_DEFAULT;
+  const int q = line.indexOf("rate=");
+  if (q >= 0)
+    rate = line.substring(q + 5).toInt();
+  if (rate < 0 || rate > LIVE_RATE_MAX)
+    rate = LIVE_RATE_DEFAULT;
+
+  c.setNoDelay(true); // events are small and should not wait for more
+  c.print("HTTP/1.1 200 OK\r\n"
+          "Content-Type: text/event-stream\r\n"
+          "Cache-Control: no-cache\r\n"
+          "Access-Control-Allow-Origin: *\r\n"
+          "Connection: keep-alive\r\n\r\n"
+          "retry: 2000\n\n");
+  v->c = c;
+  v->used = true;
+  v->rate = (uint8_t)rate;
+  v->nextLiveMs = 0;
+  v->liveMs = 0;
+  s_viewerN++;
+  // everything once, so the page starts from a full picture
+  refreshFs(millis());
+  sendTo(*v, "event: status\ndata: " + statusJson(statusNow(), statusNow(), true) + "\n\n");
+}
+
+static void acceptNew(uint32_t now)
+{
+  WiFiClient c = s_server.available();
+  if (!c)
+    return;
+  for (Pending &p : s_pending)
+    if (!p.used)
+    {
+      p.c = c;
+      p.used = true;
+      p.sinceMs = now;
+      p.lineLen = 0;
+      p.lineDone = false;
+      p.blankSoFar = true;
+      return;
+    }
+  c.print("HTTP/1.1 503 Service Unavailable\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n");
+  c.stop();
+}
+
+// Whatever has arrived of each pending request; admits it once the blank
+// line after the headers is in, drops it after EVENTS_HEADER_MS.
+static void pollPending(uint32_t now)
+{
+  for (Pending &p : s_pending)
+  {
+    if (!p.used)
+      continue;
+    bool complete = false;
+    uint8_t buf[64];
+    int avail;
+    while (!complete && (avail = p.c.available()) > 0)
+    {
+      const int got = p.c.read(buf, avail < (int)sizeof(buf) ? avail : (int)sizeof(buf));
+      if (got <= 0)
+        break;
+      for (int i = 0; i < got && !complete; i++)
+      {
+        const char ch = (char)buf[i];
+        if (!p.lineDone)
+        {
+          if (ch == '\n')
+            p.lineDone = true;
+          else if (ch != '\r' && p.lineLen < sizeof(p.line) - 1)
+            p.line[p.lineLen++] = ch;
+          continue;
+        }
+        if (ch == '\n')
+        {
+          complete = p.blankSoFar;
+          p.blankSoFar = true;
+        }
+        else if (ch != '\r')
+          p.blankSoFar = false;
+      }
+    }
+    if (complete)
+    {
+      p.line[p.lineLen] = 0;
+      p.used = false;
+      admit(p.c, String(p.line));
+      p.c = WiFiClient(); // the viewer (if admitted) holds its own copy
+    }
+    else if (!p.c.connected() || now - p.sinceMs > EVENTS_HEADER_MS)
+    {
+      p.c.stop();
+      p.used = false;
+    }
+  }
+}
+
+static void eventTask(void * /*arg*/)
+{
+  uint32_t lastStatusMs = 0, lastPingMs = 0;
+  for (;;)
+  {
+    vTaskDelay(pdMS_TO_TICKS(EVENTS_TICK_MS));
+    uint32_t now = millis();
+    acceptNew(now);
+    pollPending(now);
+    for (Viewer &v : s_viewers)
+      if (v.used && !v.c.connected())
+        drop(v);
+    if (!s_viewerN)
+    {
+      s_sentValid = false;
+      continue;
+    }
+    now = millis();
+
+    // ---- status deltas, one frame for everybody ----
+    if (now - lastStatusMs >= EVENTS_STATUS_MS)
+    {
+      lastStatusMs = now;
+      refreshFs(now);
+      const EvStatus st = statusNow();
+      const String d = statusJson(st, s_sent, !s_sentValid);
+      s_sent = st;
+      s_sentValid = true;
+      if (d.length() > 2)
+      {
+        const String ev = "event: status\ndata: " + d + "\n\n";
+        for (Viewer &v : s_viewers)
+          if (v.used)
+            sendTo(v, ev);
+      }
+    }
+
+    // ---- live: one sampler for all viewers, one frame per publication ----
+    uint8_t rate = 0;
+    for (const Viewer &v : s_viewers)
+      if (v.used && v.rate > rate)
+        rate = v.rate;
+    if (rate && !(g_calibratingStatic || g_calibrating6))
+    {
+      liveSamplerKick(g_live_lp_cut_hz, rate);
+      uint32_t pubMs;
+      portENTER_CRITICAL(&g_liveMux);
+      pubMs = g_liveLastMs;
+      portEXIT_CRITICAL(&g_liveMux);
+      String ev;
+      for (Viewer &v : s_viewers)
+      {
+        if (!v.used || !v.rate || !pubMs || pubMs == v.liveMs || (int32_t)(now - v.nextLiveMs) < 0)
+          continue;
+        if (!ev.length())
+          ev = "event: live\ndata: " + liveJson() + "\n\n";
+        v.liveMs = pubMs;
+        v.nextLiveMs = now + 1000u / v.rate;
+        sendTo(v, ev);
+      }
+    }
+
+    if (now - lastPingMs >= EVENTS_KEEPALIVE_MS)
+    {
+      lastPingMs = now;
+      for (Viewer &v : s_viewers)
+        if (v.used)
+          sendTo(v, String(": ping\n\n"));
+    }
+  }
+}
+
+bool eventPushStart()
+{
+  if (s_task)
+    return true;
+  s_server.begin();
+  return xTaskCreatePinnedToCore(eventTask, "events", 6144, nullptr, 1, &s_task, 0) == pdPASS;
+}
+
+uint8_t eventPushViewers() { return s_viewerN; }
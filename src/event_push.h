@@ -0,0 +1,32 @@
+#pragma once
+
+#include "app_state.h"
+
+// Server-sent events on EVENTS_PORT, for the UI instead of polling
+// /api/info and /api/live:
+//   GET /events[?rate=0..20]   (EventSource, any origin)
+//   event: status  data: JSON of the fields that changed since the last
+//                  status event (a new viewer gets all of them first):
+//                  rec, st, cal_static, cal6, calib_step, samples,
+//                  elapsed_ms, ring_dropped, viewers, fs_used, fs_total
+//                  (LittleFS bytes; refreshed every EVENTS_FS_REC_MS while
+//                  recording, EVENTS_FS_IDLE_MS otherwise and on rec changes)
+//   event: live    data: the latest live sampler publication, /api/live
+//                  keys, at most `rate` per second per viewer
+// One task (core 0) serves up to EVENTS_MAX_VIEWERS: every frame is built
+// once per publication and written to each viewer, and the live sampler is
+// kept running for all of them together, so viewers cost no sensor reads.
+// Requests are read without blocking: up to EVENTS_MAX_PENDING connections
+// collect their headers across ticks and are dropped after EVENTS_HEADER_MS.
+static const uint16_t EVENTS_PORT = 81;
+static const uint8_t EVENTS_MAX_VIEWERS = 4;
+static const uint32_t EVENTS_TICK_MS = 50;       // accept / push period
+static const uint32_t EVENTS_STATUS_MS = 250;    // status deltas at most this often
+static const uint32_t EVENTS_KEEPALIVE_MS = 15000; // comment line: finds dead viewers
+static const uint8_t EVENTS_MAX_PENDING = 2;
+static const uint32_t EVENTS_HEADER_MS = 1000;   // whole request within this
+static const uint32_t EVENTS_FS_REC_MS = 3000;
+static const uint32_t EVENTS_FS_IDLE_MS = 30000;
+
+bool eventPushStart();
+uint8_t eventPushViewers();
@@ -0,0 +1,201 @@
+#pragma once
+
+// In-house float32 FFT: the Xtensa FPU only does single precision, so the
+// double based arduinoFFT runs in software emulation there.
+//  - twiddles: one quarter-wave sine table for FFT_MAX_N, built by the
+//    compiler (constexpr, lives in flash); smaller sizes stride through it
+//  - complex FFT: bit reversal, then radix-4 butterflies (two radix-2
+//    stages fused, 3 complex multiplies instead of 4), one radix-2 stage
+//    first when log2(n) is odd
+//  - real FFT of N via one N/2 complex FFT plus a split pass
+#include <stddef.h>
+#include <stdint.h>
+
+static const uint32_t FFT_MAX_N = 4096;
+
+// ---- compile-time twiddles ----
+// Taylor series in double; only ever evaluated on [0, pi/4]
+constexpr double fftConstSinSeries(double x)
+{
+  double term = x, sum = x;
+  for (int k = 1; k < 12; k++)
+  {
+    term *= -x * x / (double)((2 * k) * (2 * k + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double fftConstCosSeries(double x)
+{
+  double term = 1, sum = 1;
+  for (int k = 1; k < 12; k++)
+  {
+    term *= -x * x / (double)((2 * k - 1) * (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+// 0 <= x <= pi/2
+constexpr double fftConstSin(double x)
+{
+  return x <= 0.78539816339744830962 ? fftConstSinSeries(x) : fftConstCosSeries(1.57079632679489661923 - x);
+}
+
+// sin(2*pi*i / FFT_MAX_N), i = 0 .. FFT_MAX_N / 4
+struct FftSinTable
+{
+  float v[FFT_MAX_N / 4 + 1];
+  constexpr FftSinTable() : v()
+  {
+    for (uint32_t i = 0; i <= FFT_MAX_N / 4; i++)
+      v[i] = (float)fftConstSin(6.28318530717958647692 * (double)i / (double)FFT_MAX_N);
+  }
+};
+inline constexpr FftSinTable FFT_SIN{};
+
+// cos / sin of 2*pi*k / FFT_MAX_N, k in [0, FFT_MAX_N)
+inline void fftTwiddle(uint32_t k, float &c, float &s)
+{
+  const uint32_t Q = FFT_MAX_N / 4;
+  const float *t = FFT_SIN.v;
+  switch (k / Q)
+  {
+  case 0:
+    s = t[k];
+    c = t[Q - k];
+    break;
+  case 1:
+    s = t[2 * Q - k];
+    c = -t[k - Q];
+    break;
+  case 2:
+    s = -t[k - 2 * Q];
+    c = -t[3 * Q - k];
+    break;
+  default:
+    s = -t[4 * Q - k];
+    c = t[k - 3 * Q];
+    break;
+  }
+}
+
+inline bool fftSizeOk(uint32_t n) { return n >= 2 && n <= FFT_MAX_N && (n & (n - 1)) == 0; }
+
+inline void fftBitReverse(float *z, uint32_t n)
+{
+  for (uint32_t i = 0, j = 0; i < n; i++)
+  {
+    if (i < j)
+    {
+      float t = z[2 * i];
+      z[2 * i] = z[2 * j];
+      z[2 * j] = t;
+      t = z[2 * i + 1];
+      z[2 * i + 1] = z[2 * j + 1];
+      z[2 * j + 1] = t;
+    }
+    uint32_t bit = n >> 1;
+    while (j & bit)
+    {
+      j ^= bit;
+      bit >>= 1;
+    }
+    j |= bit;
+  }
+}
+
+// Forward, in place, unscaled. z: n complex values as re, im pairs.
+inline bool fftComplex(float *z, uint32_t n)
+{
+  if (!fftSizeOk(n))
+    return false;
+  fftBitReverse(z, n);
+
+  uint32_t log2n = 0;
+  while ((1u << log2n) < n)
+    log2n++;
+
+  uint32_t h = 1;
+  if (log2n & 1)
+  {
+    for (uint32_t g = 0; g < 2 * n; g += 4)
+    {
+      const float ar = z[g], ai = z[g + 1], br = z[g + 2], bi = z[g + 3];
+      z[g] = ar + br;
+      z[g + 1] = ai + bi;
+      z[g + 2] = ar - br;
+      z[g + 3] = ai - bi;
+    }
+    h = 2;
+  }
+
+  // Two radix-2 stages (spans h and 2h) per pass. With w = W_4h^j:
+  //   a = x0 + w^2 x1, b = x0 - w^2 x1, c = w x2 + w^3 x3, d = w x2 - w^3 x3
+  //   y0 = a + c, y1 = b - i d, y2 = a - c, y3 = b + i d
+  for (; h < n; h *= 4)
+  {
+    const uint32_t stride = FFT_MAX_N / (4 * h);
+    for (uint32_t j = 0; j < h; j++)
+    {
+      float c1, s1, c2, s2, c3, s3;
+      fftTwiddle(j * stride, c1, s1);
+      fftTwiddle(2 * j * stride, c2, s2);
+      fftTwiddle(3 * j * stride, c3, s3);
+      for (uint32_t g = j; g < n; g += 4 * h)
+      {
+        float *p0 = z + 2 * g, *p1 = p0 + 2 * h, *p2 = p1 + 2 * h, *p3 = p2 + 2 * h;
+        // (re + i im) * (c - i s)
+        const float t1r = p1[0] * c2 + p1[1] * s2, t1i = p1[1] * c2 - p1[0] * s2;
+        const float t2r = p2[0] * c1 + p2[1] * s1, t2i = p2[1] * c1 - p2[0] * s1;
+        const float t3r = p3[0] * c3 + p3[1] * s3, t3i = p3[1] * c3 - p3[0] * s3;
+        const float ar = p0[0] + t1r, ai = p0[1] + t1i;
+        const float br = p0[0] - t1r, bi = p0[1] - t1i;
+        const float cr = t2r + t3r, ci = t2i + t3i;
+        const float dr = t2r - t3r, di = t2i - t3i;
+        p0[0] = ar + cr;
+        p0[1] = ai + ci;
+        p2[0] = ar - cr;
+        p2[1] = ai - ci;
+        p1[0] = br + di;
+        p1[1] = bi - dr;
+        p3[0] = br - di;
+        p3[1] = bi + dr;
+      }
+    }
+  }
+  return true;
+}
+
+// Forward FFT of n real samples (n >= 4), in place, unscaled. Packed result:
+// x[0] = X[0], x[1] = X[n/2] (both real), x[2k], x[2k+1] = Re, Im X[k]
+// for 0 < k < n/2.
+inline bool fftReal(float *x, uint32_t n)
+{
+  if (n < 4 || !fftSizeOk(n) || !fftComplex(x, n / 2))
+    return false;
+  const uint32_t half = n / 2;
+  const uint32_t stride = FFT_MAX_N / n;
+
+  const float z0r = x[0], z0i = x[1];
+  x[0] = z0r + z0i;
+  x[1] = z0r - z0i;
+
+  // Z = FFT(even + i odd): E = (Z[k] + conj Z[h-k]) / 2, O = (Z[k] - conj Z[h-k]) / 2i
+  // X[k] = E + W^k O, X[h-k] = conj(E - W^k O)
+  for (uint32_t k = 1; k <= half / 2; k++)
+  {
+    float *a = x + 2 * k, *b = x + 2 * (half - k);
+    const float er = 0.5f * (a[0] + b[0]), ei = 0.5f * (a[1] - b[1]);
+    const float orr = 0.5f * (a[1] + b[1]), oi = -0.5f * (a[0] - b[0]);
+    float c, s;
+    fftTwiddle(k * stride, c, s);
+    const float tr = orr * c + oi * s, ti = oi * c - orr * s;
+    a[0] = er + tr;
+    a[1] = ei + ti;
+    b[0] = er - tr;
+    b[1] = ti - ei;
+  }
+  return true;
+}
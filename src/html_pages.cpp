@@ -220,8 +220,32 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
         <option value="180">180</option>
       </select>
 
+      <label for="q" style="margin-top:10px">Stored resolution</label>
+      <select id="q">
+        <option value="0" selected>Full (compressed)</option>
+        <option value="12">12 bit packed (4.5 B/sample)</option>
+        <option value="10">10 bit packed (4 B/sample)</option>
+      </select>
+
+      <label for="dec" style="margin-top:10px">Decimated copies</label>
+      <select id="dec">
+        <option value="" selected>Off</option>
+        <option value="4">+ ÷4 file (_d4)</option>
+        <option value="4,16">+ ÷4 and ÷16 files</option>
+        <option value="4|0">Only ÷4 (no full-rate file)</option>
+      </select>
+
+      <label for="cont" style="margin-top:10px">Continuous</label>
+      <select id="cont">
+        <option value="0" selected>Off (single file)</option>
+        <option value="60">60 s segments</option>
+        <option value="300">5 min segments</option>
+        <option value="900">15 min segments</option>
+      </select>
+
       <div class="small" style="margin-top:10px">
-        Dosya adı browser saatinden alınır: accelYYMMDDHHMMSS.dat
+        Dosya adı browser saatinden alınır: accelYYMMDDHHMMSS.dat<br>
+        Continuous: STOP'a kadar accelYYMMDDHHMMSS_NN.dat segmentleri, doluluk artınca en eski dosyalar silinir.
       </div>
     </div>
 
@@ -234,6 +258,7 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
       <div class="btns" style="margin-top:12px">
         <button onclick="startRec()">START</button>
         <button onclick="stopRec()">STOP</button>
+        <button onclick="startStream()">STREAM (TCP)</button>
         <button onclick="downloadBin()">DOWNLOAD</button>
         <button onclick="downloadCsv()">DOWNLOAD CSV</button>
         <button onclick="deleteSel()">DELETE</button>
@@ -250,10 +275,49 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
     </div>
 
     <div class="card">
-      <h2>Live (1s preview @800 Hz)</h2>
+      <h2>Live (rolling 1 s)</h2>
       <canvas id="chart" width="420" height="160" style="width:100%;height:160px;border:1px solid #eee;border-radius:10px;background:#fff"></canvas>
       <pre id="live">acc: -, vel: -, disp: -</pre>
-      <div class="small">Kayıt veya kalibrasyon sırasında live kapalıdır.</div>
+      <div class="small">Kalibrasyon sırasında live kapalıdır; kayıt sırasında kaydın kendi örnekleri gösterilir.</div>
+    </div>
+
+    <div class="card">
+      <h2>Live spectrum</h2>
+      <select id="lfAxis">
+        <option value="x">X</option>
+        <option value="y">Y</option>
+        <option value="z">Z</option>
+        <option value="mag">|a|</option>
+      </select>
+      <select id="lfN">
+        <option value="256">N 256</option>
+        <option value="512" selected>N 512</option>
+        <option value="1024">N 1024</option>
+      </select>
+      <select id="lfWin">
+        <option value="hann" selected>Hann</option>
+        <option value="flattop">Flat top</option>
+        <option value="blackman">Blackman</option>
+        <option value="rect">Rect</option>
+      </select>
+      <select id="lfAvg">
+        <option value="none">no avg</option>
+        <option value="lin">linear</option>
+        <option value="exp" selected>exp</option>
+      </select>
+      <select id="lfK">
+        <option value="4">k 4</option>
+        <option value="8" selected>k 8</option>
+        <option value="16">k 16</option>
+        <option value="64">k 64</option>
+      </select>
+      <label class="small"><input id="lfPeak" type="checkbox" checked> peak hold</label>
+      <div class="btns" style="margin-top:8px">
+        <button onclick="liveFftToggle()" id="lfBtn">START</button>
+        <button onclick="liveFftReset=true">RESET</button>
+      </div>
+      <canvas id="lfChart" width="420" height="200" style="width:100%;height:200px;border:1px solid #eee;border-radius:10px;background:#fff"></canvas>
+      <pre id="lfInfo">-</pre>
     </div>
 
     <div class="card" style="flex-basis:100%">
@@ -268,6 +332,21 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
         <option value="x">X</option>
         <option value="y">Y</option>
         <option value="z">Z</option>
+        <option value="all">X+Y+Z</option>
+        <option value="all&mag=1">X+Y+Z+|a|</option>
+        </select>
+        <select id="fftN">
+        <option value="512">N 512</option>
+        <option value="1024" selected>N 1024</option>
+        <option value="2048">N 2048</option>
+        <option value="4096">N 4096</option>
+        </select>
+        <select id="fftWin">
+        <option value="hann" selected>Hann</option>
+        <option value="hamming">Hamming</option>
+        <option value="blackman">Blackman</option>
+        <option value="flattop">Flat top</option>
+        <option value="rect">Rect</option>
         </select>
         <button onclick="runFFT()">FFT</button>
 
@@ -276,6 +355,51 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
 
         <pre id="fftInfo">-</pre>
 
+        <h2>Spectrogram (STFT)</h2>
+        <select id="stftAxis">
+        <option value="x">X</option>
+        <option value="y">Y</option>
+        <option value="z">Z</option>
+        <option value="mag">|a|</option>
+        </select>
+        <select id="stftN">
+        <option value="256">N 256</option>
+        <option value="512" selected>N 512</option>
+        <option value="1024">N 1024</option>
+        <option value="2048">N 2048</option>
+        </select>
+        <select id="stftRange">
+        <option value="-100,0" selected>-100..0 dB</option>
+        <option value="-80,-20">-80..-20 dB</option>
+        <option value="-120,-40">-120..-40 dB</option>
+        </select>
+        <button onclick="runSTFT()">SPECTROGRAM</button>
+
+        <canvas id="stftChart" width="980" height="320"
+        style="width:100%;height:320px;border:1px solid #eee;border-radius:10px;background:#000"></canvas>
+
+        <pre id="stftInfo">-</pre>
+
+        <h2>Envelope spectrum (bearings)</h2>
+        <select id="envAxis">
+        <option value="x">X</option>
+        <option value="y">Y</option>
+        <option value="z">Z</option>
+        </select>
+        <input id="envLo" type="number" placeholder="band lo Hz" style="width:110px">
+        <input id="envHi" type="number" placeholder="band hi Hz" style="width:110px">
+        <input id="envShaft" type="number" step="0.01" placeholder="shaft Hz" style="width:90px">
+        <input id="envBpfo" type="number" step="0.01" placeholder="BPFO Hz" style="width:90px">
+        <input id="envBpfi" type="number" step="0.01" placeholder="BPFI Hz" style="width:90px">
+        <input id="envBsf" type="number" step="0.01" placeholder="BSF Hz" style="width:90px">
+        <input id="envFtf" type="number" step="0.01" placeholder="FTF Hz" style="width:90px">
+        <button onclick="runEnvelope()">ENVELOPE</button>
+
+        <canvas id="envChart" width="980" height="320"
+        style="width:100%;height:320px;border:1px solid #eee;border-radius:10px"></canvas>
+
+        <pre id="envInfo">-</pre>
+
 
       <div class="small" id="anaMeta">Select a file and press ANALYZE.</div>
 
@@ -460,18 +584,24 @@ async function refreshFiles(selectName=""){
   for(const f of files){
     const opt = document.createElement("option");
     opt.value = f.name;
-    opt.textContent = `${prettyName(f.name)}  (${f.size} B)`;
+    const clip = f.feat ? f.feat.clip.reduce((a,b)=>a+b, 0) : 0;
+    opt.textContent = `${prettyName(f.name)}  (${f.size} B${f.version === 4 ? ", x" + f.ratio : ""}`
+      + `${f.feat ? ", kurt " + Math.max(...f.feat.kurt).toFixed(1) : ""}${clip ? ", CLIP " + clip : ""})`;
     sel.appendChild(opt);
     if (f.name === current) keep = current;
   }
   if (keep) sel.value = keep;
 }
 
+function renderFsInfo(used, total){
+  const fmt = (x)=> x < 1024*1024 ? (x/1024).toFixed(1)+" KB" : (x/1024/1024).toFixed(2)+" MB";
+  document.getElementById("fsinfo").textContent =
+    `FS: used ${fmt(used)} / total ${fmt(total)} (free ${fmt(Math.max(total - used, 0))})`;
+}
+
 async function refreshFsInfo(){
   const j = await getJson("/api/fsinfo");
-  const el = document.getElementById("fsinfo");
-  const fmt = (x)=> x < 1024*1024 ? (x/1024).toFixed(1)+" KB" : (x/1024/1024).toFixed(2)+" MB";
-  el.textContent = `FS: used ${fmt(j.used)} / total ${fmt(j.total)} (free ${fmt(j.free)})`;
+  renderFsInfo(j.used, j.total);
 }
 
 async function refreshInfo(){
@@ -483,12 +613,20 @@ async function refreshInfo(){
   if (j.calibrating6) flags.push("CAL(6POS:"+j.calibPose+")");
 
   st.innerHTML =
-    (j.recording ? "<span class='warn'>RECORDING</span>" : "<span class='ok'>IDLE</span>")
+    (j.recording ? "<span class='warn'>RECORDING</span>" : j.streaming ? "<span class='warn'>STREAMING</span>" : "<span class='ok'>IDLE</span>")
     + " | mode: " + (j.mode || "-")
     + " | currentFile: " + (j.currentFile || "-")
     + " | samples: " + j.samples
     + " | elapsed: " + Math.round(j.elapsedMs/1000) + " s"
     + " | maxBacklog: " + j.maxBacklog
+    + " | fifoOvr: " + j.fifoOverruns
+    + " | ring: " + j.ringHighWater + "/" + j.ringBlocks + " drop " + j.ringDropped
+    + " | flash: " + Math.round(j.wrBps/1024) + " kB/s, max " + (j.wrMaxUs/1000).toFixed(1) + " ms"
+    + (j.continuous ? (" | seg: " + j.segCount + ", switch " + (j.segSwitchMaxUs/1000).toFixed(1) + " ms, lost " + j.segDropped) : "")
+    + (j.health ? (" | health: " + (j.health.clean ? "<span class='ok'>clean</span>" : "<span class='warn'>i2c " + j.health.i2cErrors + " skip " + j.health.skippedTicks + " dup " + j.health.duplicates + "</span>") + ", jitter max " + j.health.jitterMaxUs + " µs") : "")
+    + (j.streaming ? (" | stream: " + Math.round(j.stBps/1024) + " kB/s, frames " + j.stFrames + " drop " + j.stDropped) : "")
+    + ((j.decMain || j.decSides) ? (" | dec: " + j.decCpuPct + "% cpu, max " + j.decMaxUs + " µs/block") : "")
+    + (j.retDeleted ? (" | retention: -" + j.retDeleted + " files") : "")
     + (flags.length ? (" | <span class='warn'>" + flags.join(" ") + "</span>") : "");
 
   document.getElementById("info").textContent = JSON.stringify(j, null, 2);
@@ -502,14 +640,18 @@ async function refreshInfo(){
 }
 
 async function refreshLive(){
-  const j = await getJson("/api/live");
+  renderLive(await getJson("/api/live"));
+}
+
+function renderLive(j){
   if(j.enabled === false) return;
-  if(typeof j.ax !== "number") return;
+  if(typeof j.ax !== "number" || !j.ready) return;
 
-  const accLine = `ACC (m/s²)  X:${j.ax.toFixed(3)}  Y:${j.ay.toFixed(3)}  Z:${j.az.toFixed(3)}  MAG:${j.mag.toFixed(3)}`;
-  const velLine = `VEL (mm/s)  X:${j.vx_mmps.toFixed(2)}  Y:${j.vy_mmps.toFixed(2)}  Z:${j.vz_mmps.toFixed(2)}  MAG:${j.vmag_mmps.toFixed(2)}`;
-  const dispLine = `DISP (mm)   X:${j.dx_mm.toFixed(2)}  Y:${j.dy_mm.toFixed(2)}  Z:${j.dz_mm.toFixed(2)}  MAG:${j.dmag_mm.toFixed(2)}`;
-  document.getElementById("live").textContent = `${accLine}\n${velLine}\n${dispLine}`;
+  const accLine = `ACC (m/s²)              X:${j.ax.toFixed(3)}  Y:${j.ay.toFixed(3)}  Z:${j.az.toFixed(3)}  MAG:${j.mag.toFixed(3)}`;
+  const velLine = `VEL RMS (mm/s, 10 Hz+)  X:${j.vx_mmps.toFixed(2)}  Y:${j.vy_mmps.toFixed(2)}  Z:${j.vz_mmps.toFixed(2)}  MAG:${j.vmag_mmps.toFixed(2)}`;
+  const dispLine = `DISP p-p (mm)           X:${j.dx_mm.toFixed(2)}  Y:${j.dy_mm.toFixed(2)}  Z:${j.dz_mm.toFixed(2)}  MAG:${j.dmag_mm.toFixed(2)}`;
+  const bgLine = `${j.source} @${j.hz} Hz: ${j.rate}/s over ${j.window_ms} ms, age ${j.age_ms} ms, cpu ${j.cpu_pct.toFixed(1)} %, reply ${j.serve_us} µs`;
+  document.getElementById("live").textContent = `${accLine}\n${velLine}\n${dispLine}\n${bgLine}`;
 
   const gx = j.ax / GRAVITY;
   const gy = j.ay / GRAVITY;
@@ -522,9 +664,16 @@ async function startRec(){
   const hz = document.getElementById("hz").value;
   const fs = document.getElementById("fs").value;
   const sec = document.getElementById("sec").value;
+  const cont = document.getElementById("cont").value;
   const ts = tsYYMMDDHHMMSS();
 
-  const r = await getText(`/api/start?hz=${esc(hz)}&fs=${esc(fs)}&sec=${esc(sec)}&ts=${esc(ts)}`);
+  let url = `/api/start?hz=${esc(hz)}&fs=${esc(fs)}&sec=${esc(sec)}&ts=${esc(ts)}`;
+  if (cont !== "0") url += `&cont=1&seg=${esc(cont)}`;
+  const q = document.getElementById("q").value;
+  if (q !== "0") url += `&q=${esc(q)}`;
+  const dec = document.getElementById("dec").value.split("|");
+  if (dec[0]) url += `&dec=${esc(dec[0])}` + (dec[1] === "0" ? "&full=0" : "");
+  const r = await getText(url);
   if(!r.ok) alert(r.text);
   else toast("STARTED");
 
@@ -533,6 +682,15 @@ async function startRec(){
   await refreshFsInfo();
 }
 
+async function startStream(){
+  const hz = document.getElementById("hz").value;
+  const fs = document.getElementById("fs").value;
+  const r = await getText(`/api/stream?hz=${esc(hz)}&fs=${esc(fs)}`);
+  if(!r.ok) alert(r.text);
+  else toast(r.text + " (tools/stream_recv)");
+  await refreshInfo();
+}
+
 async function stopRec(){
   const r = await getText("/api/stop");
   if(!r.ok) alert(r.text);
@@ -603,14 +761,25 @@ async function runFFT(){
   const axis = document.getElementById("fftAxis").value;
   if(!file) return alert("Select file");
 
-  const j = await getJson(`/api/fft?file=${esc(file)}&axis=${axis}`);
-  drawFFT(j.fft, j.df);
+  const n = document.getElementById("fftN").value;
+  const win = document.getElementById("fftWin").value;
+  const j = await getJson(`/api/fft?file=${esc(file)}&axis=${axis}&n=${n}&win=${win}`);
+  const welch = `\nWelch: N ${j.n}, ${j.window}, ${j.overlap}% overlap, ${j.segments} segments, ${j.ms} ms`;
+  if (j.axis === "all") {
+    const keys = ["x","y","z","mag"].filter(k => j.fft[k]);
+    drawFFT(keys.map(k => j.fft[k]), j.df);
+    document.getElementById("fftInfo").textContent =
+      keys.map(k => `${k.toUpperCase()}: peak ${j.peak_hz[k].toFixed(2)} Hz, ${j.peak_mag[k].toFixed(4)} g`).join("\n")
+      + welch;
+    return;
+  }
+  drawFFT([j.fft], j.df);
   document.getElementById("fftInfo").textContent =
-    `Axis: ${j.axis}\nPeak: ${j.peak_hz.toFixed(2)} Hz\nMagnitude: ${j.peak_mag.toFixed(4)}`;
+    `Axis: ${j.axis}\nPeak: ${j.peak_hz.toFixed(2)} Hz\nAmplitude: ${j.peak_mag.toFixed(4)} g` + welch;
 }
 
-function drawFFT(arr, df){
-    const c = document.getElementById("fftChart");
+function drawFFT(series, df, canvasId = "fftChart"){
+    const c = document.getElementById(canvasId);
     const ctx = c.getContext("2d");
     ctx.clearRect(0,0,c.width,c.height);
 
@@ -618,20 +787,24 @@ function drawFFT(arr, df){
     const mL=50,mR=10,mT=10,mB=30;
     const pw=w-mL-mR,ph=h-mT-mB;
 
-    let max=Math.max(...arr);
+    let max=Math.max(...series.map(a => Math.max(...a)));
     if(max<=0) max=1;
 
     ctx.strokeStyle="#ccc";
     ctx.strokeRect(mL,mT,pw,ph);
 
-    ctx.beginPath();
-    ctx.strokeStyle="#36c";
-    for(let i=0;i<arr.length;i++){
-        const x=mL+(i/(arr.length-1))*pw;
-        const y=mT+(1-arr[i]/max)*ph;
-        if(i===0) ctx.moveTo(x,y); else ctx.lineTo(x,y);
-    }
-    ctx.stroke();
+    const colors=["#c33","#3a3","#36c","#888"];
+    series.forEach((arr, s) => {
+      ctx.beginPath();
+      ctx.strokeStyle=series.length > 1 ? colors[s] : "#36c";
+      for(let i=0;i<arr.length;i++){
+          const x=mL+(i/(arr.length-1))*pw;
+          const y=mT+(1-arr[i]/max)*ph;
+          if(i===0) ctx.moveTo(x,y); else ctx.lineTo(x,y);
+      }
+      ctx.stroke();
+    });
+    const arr=series[0];
 
     ctx.fillStyle="#666";
     ctx.fillText(`0 Hz`,mL,h-8);
@@ -639,6 +812,149 @@ function drawFFT(arr, df){
     }
 
 
+async function runEnvelope(){
+  const file = document.getElementById("fileSel").value;
+  if(!file) return alert("Select file");
+  let q = `/api/envelope?file=${esc(file)}&axis=${document.getElementById("envAxis").value}`;
+  const opt = {lo:"envLo", hi:"envHi", shaft:"envShaft", bpfo:"envBpfo", bpfi:"envBpfi", bsf:"envBsf", ftf:"envFtf"};
+  for (const [k, id] of Object.entries(opt)) {
+    const v = document.getElementById(id).value;
+    if (v) q += `&${k}=${v}`;
+  }
+  const j = await getJson(q);
+  drawFFT([j.spectrum], j.df, "envChart");
+  let txt = `Band ${j.band_hz[0]}..${j.band_hz[1]} Hz, envelope ${j.env_rate_hz.toFixed(1)} Hz (/${j.decim}), ` +
+    `N ${j.n}, ${j.segments} segments, ${j.ms} ms\nEnvelope rms ${j.env_rms_g.toFixed(4)} g, ` +
+    `peak ${j.peak_amp.toFixed(4)} g at ${j.peak_hz.toFixed(2)} Hz`;
+  for (const [k, d] of Object.entries(j.defects))
+    txt += `\n${k.toUpperCase()} ${d.hz} Hz: ` + d.amp.map((a, i) => `${i + 1}x ${a.toFixed(4)} g`).join(", ");
+  document.getElementById("envInfo").textContent = txt;
+}
+
+// /api/stft: 36-byte header + frames x bins quantised dB cells (src/stft.h)
+async function runSTFT(){
+  const file = document.getElementById("fileSel").value;
+  if(!file) return alert("Select file");
+  const axis = document.getElementById("stftAxis").value;
+  const n = document.getElementById("stftN").value;
+  const [lo, hi] = document.getElementById("stftRange").value.split(",");
+  const t0 = performance.now();
+  const r = await fetch(`/api/stft?file=${esc(file)}&axis=${axis}&n=${n}&lo=${lo}&hi=${hi}`);
+  if(!r.ok){ alert(await r.text()); return; }
+  const buf = await r.arrayBuffer();
+  const dv = new DataView(buf);
+  if(buf.byteLength < 36 || String.fromCharCode(...new Uint8Array(buf, 0, 4)) !== "STFT")
+    return alert("Bad spectrogram data");
+  const hdrBytes = dv.getUint16(4, true), cell = dv.getUint8(6);
+  const N = dv.getUint16(8, true), bins = dv.getUint16(10, true);
+  const hop = dv.getUint32(12, true);
+  const rate = dv.getFloat32(20, true), dbLo = dv.getFloat32(24, true), dbStep = dv.getFloat32(28, true);
+  const frames = Math.floor((buf.byteLength - hdrBytes) / (bins * cell));
+  if(!frames) return alert("No frames");
+  const maxCell = cell === 1 ? 255 : 65535;
+  const cells = cell === 1 ? new Uint8Array(buf, hdrBytes, frames * bins)
+                           : new Uint16Array(buf.slice(hdrBytes, hdrBytes + frames * bins * 2));
+
+  // one pixel per cell (time right, frequency up), then scaled onto the chart
+  const img = new ImageData(frames, bins);
+  for(let f=0; f<frames; f++)
+    for(let k=0; k<bins; k++){
+      const v = cells[f * bins + k] / maxCell;
+      const p = ((bins - 1 - k) * frames + f) * 4;
+      img.data[p]   = 255 * Math.min(1, Math.max(0, 1.5 - Math.abs(4 * v - 3)));
+      img.data[p+1] = 255 * Math.min(1, Math.max(0, 1.5 - Math.abs(4 * v - 2)));
+      img.data[p+2] = 255 * Math.min(1, Math.max(0, 1.5 - Math.abs(4 * v - 1)));
+      img.data[p+3] = 255;
+    }
+  const off = document.createElement("canvas");
+  off.width = frames; off.height = bins;
+  off.getContext("2d").putImageData(img, 0, 0);
+
+  const c = document.getElementById("stftChart");
+  const ctx = c.getContext("2d");
+  const mL=50,mB=20;
+  ctx.fillStyle="#fff";
+  ctx.fillRect(0,0,c.width,c.height);
+  ctx.imageSmoothingEnabled = false;
+  ctx.drawImage(off, mL, 0, c.width - mL, c.height - mB);
+  const secs = ((frames - 1) * hop + N) / rate;
+  ctx.fillStyle="#666";
+  ctx.fillText(`${((bins - 1) * rate / N).toFixed(0)} Hz`, 4, 12);
+  ctx.fillText(`0 Hz`, 4, c.height - mB);
+  ctx.fillText(`0 s`, mL, c.height - 6);
+  ctx.fillText(`${secs.toFixed(1)} s`, c.width - 60, c.height - 6);
+
+  document.getElementById("stftInfo").textContent =
+    `Frames: ${frames} x ${bins} bins, N ${N}, hop ${hop} (${(hop / rate * 1000).toFixed(1)} ms), ` +
+    `df ${(rate / N).toFixed(2)} Hz\nColour: ${dbLo.toFixed(0)} .. ${(dbLo + dbStep * maxCell).toFixed(0)} dB re 1 g, ` +
+    `${buf.byteLength} bytes in ${(performance.now() - t0).toFixed(0)} ms`;
+}
+
+// /api/livefft: 40-byte header + average row (+ peak hold row), quantised dB
+// cells (src/live_spectrum.h); fetched a few times a second while running
+let liveFftOn = false, liveFftReset = false, liveFftBusy = false;
+const liveFftCid = 1 + Math.floor(Math.random() * 0xFFFFFFFE); // own average per page
+function liveFftToggle(){
+  liveFftOn = !liveFftOn;
+  liveFftReset = true;
+  document.getElementById("lfBtn").textContent = liveFftOn ? "STOP" : "START";
+}
+
+async function refreshLiveFft(){
+  if(!liveFftOn || liveFftBusy) return;
+  liveFftBusy = true;
+  try {
+    const v = (id)=> document.getElementById(id).value;
+    const peak = document.getElementById("lfPeak").checked ? 1 : 0;
+    let q = `/api/livefft?axis=${v("lfAxis")}&n=${v("lfN")}&win=${v("lfWin")}&avg=${v("lfAvg")}&k=${v("lfK")}&peak=${peak}&cid=${liveFftCid}`;
+    if (liveFftReset) { q += "&reset=1"; liveFftReset = false; }
+    const r = await fetch(q);
+    if(!r.ok){ document.getElementById("lfInfo").textContent = await r.text(); return; }
+    const buf = await r.arrayBuffer();
+    const dv = new DataView(buf);
+    if(buf.byteLength < 40 || String.fromCharCode(...new Uint8Array(buf, 0, 4)) !== "LFFT") return;
+    const hdrBytes = dv.getUint16(4, true), cell = dv.getUint8(6);
+    const N = dv.getUint16(8, true), bins = dv.getUint16(10, true), flags = dv.getUint8(13);
+    const frames = dv.getUint32(16, true), skipped = dv.getUint32(20, true);
+    const rate = dv.getFloat32(24, true), dbLo = dv.getFloat32(28, true), dbStep = dv.getFloat32(32, true);
+    const row = (i)=> cell === 1 ? new Uint8Array(buf, hdrBytes + i * bins, bins)
+                                 : new Uint16Array(buf.slice(hdrBytes + i * bins * 2, hdrBytes + (i + 1) * bins * 2));
+    const maxCell = cell === 1 ? 255 : 65535;
+
+    const c = document.getElementById("lfChart");
+    const ctx = c.getContext("2d");
+    const mL=34,mB=16,pw=c.width-mL,ph=c.height-mB;
+    ctx.clearRect(0,0,c.width,c.height);
+    ctx.strokeStyle="#ccc";
+    ctx.strokeRect(mL,0,pw,ph);
+    const plot = (cells, color)=>{
+      ctx.beginPath();
+      ctx.strokeStyle=color;
+      for(let k=0;k<bins;k++){
+        const x=mL+k/(bins-1)*pw, y=(1-cells[k]/maxCell)*ph;
+        if(k===0) ctx.moveTo(x,y); else ctx.lineTo(x,y);
+      }
+      ctx.stroke();
+    };
+    if (flags & 1) plot(row(1), "#bbb");
+    const avg = row(0);
+    plot(avg, "#36c");
+    ctx.fillStyle="#666";
+    ctx.fillText(`${(dbLo + dbStep * maxCell).toFixed(0)}`, 2, 10);
+    ctx.fillText(`${dbLo.toFixed(0)} dB`, 2, ph);
+    ctx.fillText(`0 Hz`, mL, c.height - 4);
+    ctx.fillText(`${((bins - 1) * rate / N).toFixed(0)} Hz`, c.width - 50, c.height - 4);
+
+    let best = 1;
+    for(let k=2;k<bins;k++) if(avg[k] > avg[best]) best = k;
+    document.getElementById("lfInfo").textContent =
+      `frames ${frames}${flags & 2 ? " (done)" : ""}${skipped ? ", skipped " + skipped : ""}, df ${(rate / N).toFixed(2)} Hz, ` +
+      `fft ${r.headers.get("X-Fft-Us")} µs\npeak ${(best * rate / N).toFixed(2)} Hz, ${(dbLo + avg[best] * dbStep).toFixed(1)} dB re 1 g`;
+  } finally {
+    liveFftBusy = false;
+  }
+}
+
 function clearAnalysis(){
   document.getElementById("stats").textContent = "-";
   document.getElementById("anaMeta").textContent = "Select a file and press ANALYZE.";
@@ -726,7 +1042,7 @@ async function analyzeSelected(){
     toast("Analyzing on device...");
     document.getElementById("anaMeta").textContent = "Analyzing on device...";
 
-    const j = await getJson(`/api/analyze?file=${esc(file)}`);
+    const j = await getJson(`/api/analyze?file=${esc(file)}&sev=1`);
 
     // chart
     drawBigChart(j.ax, j.ay, j.az, j.eff_hz || j.rate_hz || 1);
@@ -744,7 +1060,17 @@ q_bits: ${j.q_bits}
 
 X: min=${j.min[0].toFixed(4)} g  max=${j.max[0].toFixed(4)} g  rms=${j.rms[0].toFixed(4)} g
 Y: min=${j.min[1].toFixed(4)} g  max=${j.max[1].toFixed(4)} g  rms=${j.rms[1].toFixed(4)} g
-Z: min=${j.min[2].toFixed(4)} g  max=${j.max[2].toFixed(4)} g  rms=${j.rms[2].toFixed(4)} g`;
+Z: min=${j.min[2].toFixed(4)} g  max=${j.max[2].toFixed(4)} g  rms=${j.rms[2].toFixed(4)} g`
+      + (j.severity ? `
+
+Severity ${j.severity.band_hz[0]}..${j.severity.band_hz[1].toFixed(0)} Hz (ISO ${j.severity.iso}):
+vel rms  X=${j.severity.vel_rms_mms[0].toFixed(2)}  Y=${j.severity.vel_rms_mms[1].toFixed(2)}  Z=${j.severity.vel_rms_mms[2].toFixed(2)} mm/s
+disp p-p X=${j.severity.disp_pp_um[0].toFixed(1)}  Y=${j.severity.disp_pp_um[1].toFixed(1)}  Z=${j.severity.disp_pp_um[2].toFixed(1)} um
+zone ${j.severity.zone} (X/Y/Z ${j.severity.zones.split("").join("/")}, limits ${j.severity.limits_mms.join(" / ")} mm/s)` : "")
+      + (j.features ? `
+
+Features (stored at record time):
+` + ["X","Y","Z"].map((n,a)=> `${n}: mean=${j.features.mean[a].toFixed(4)}  std=${j.features.std[a].toFixed(4)}  peak=${j.features.peak[a].toFixed(4)}  p-p=${j.features.pp[a].toFixed(4)} g  crest=${j.features.crest[a].toFixed(2)}  skew=${j.features.skew[a].toFixed(2)}  kurt=${j.features.kurt[a].toFixed(2)}  clip=${j.features.clip[a]}`).join("\n") : "");
 
     document.getElementById("stats").textContent = stats;
     document.getElementById("anaMeta").textContent =
@@ -759,12 +1085,40 @@ Z: min=${j.min[2].toFixed(4)} g  max=${j.max[2].toFixed(4)} g  rms=${j.rms[2].to
 }
 
 
-setInterval(refreshInfo, 1000);
-setInterval(()=>refreshFiles(), 2000);
-setInterval(refreshFsInfo, 3000);
-setInterval(refreshLive, 1000);
+// Server push (port 81): live values and status changes arrive as events;
+// polling only fills in while the event stream is down.
+let evOk = false, infoDirty = false, infoTick = 0, fsUsed = 0, fsTotal = 0;
+function startEvents(){
+  if (!window.EventSource) return;
+  const es = new EventSource(`http://${location.hostname}:81/events?rate=4`);
+  es.onopen = ()=>{ evOk = true; };
+  es.onerror = ()=>{ evOk = false; };   // the browser reconnects by itself
+  es.addEventListener("live", (e)=> renderLive(JSON.parse(e.data)));
+  es.addEventListener("status", (e)=>{
+    const d = JSON.parse(e.data);
+    if ("fs_used" in d || "fs_total" in d) {
+      if ("fs_used" in d) fsUsed = d.fs_used;
+      if ("fs_total" in d) fsTotal = d.fs_total;
+      renderFsInfo(fsUsed, fsTotal);
+    }
+    if ("rec" in d || "st" in d || "cal_static" in d || "cal6" in d || "calib_step" in d) refreshInfo();
+    else infoDirty = true;
+  });
+}
 
-refreshInfo(); refreshFiles(); refreshFsInfo(); refreshLive(); drawChart();
+setInterval(()=>{
+  // with events: detail refresh only when something moved, or every 5 s
+  if (!evOk || infoDirty || ++infoTick % 5 === 0) { infoDirty = false; refreshInfo(); }
+}, 1000);
+setInterval(()=>{ if (!evOk) refreshFiles(); }, 2000);
+setInterval(()=>{ if (!evOk) refreshFsInfo(); }, 3000);
+// The live spectrum stays a request: each page has its own parameters and
+// average (cid slots in /api/livefft), computed on demand by the web
+// server, and the timer does nothing unless the spectrum is switched on.
+setInterval(()=>{ if (!document.hidden) refreshLiveFft(); }, 250);
+setInterval(()=>{ if (!evOk) refreshLive(); }, 1000);
+
+refreshInfo(); refreshFiles(); refreshFsInfo(); refreshLive(); drawChart(); startEvents();
 </script>
 </body>
 </html>
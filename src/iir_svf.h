@@ -0,0 +1,42 @@
+#pragma once
+
+// 2nd order high- or low-pass section (quality q, 0.7071 = Butterworth) as
+// a trapezoidal state variable filter: the bilinear-transform response of
+// a biquad, but the states hold integrals instead of near-cancelling sums,
+// so a 2 Hz corner at 1.6 kHz stays clean in float (a direct form biquad
+// leaves a wandering DC error of tens of ug there).
+#include <math.h>
+
+struct SvfSection
+{
+  float g = 0, k = 1, a1 = 1, a2 = 0, a3 = 0;
+  float ic1 = 0, ic2 = 0;
+  bool high = true;
+
+  void setup(bool highPass, float f, float fs, float q)
+  {
+    high = highPass;
+    g = tanf((float)M_PI * f / fs);
+    k = 1.0f / q;
+    a1 = 1.0f / (1.0f + g * (g + k));
+    a2 = g * a1;
+    a3 = g * a2;
+  }
+
+  // State as if x had been applied forever.
+  void prime(float x)
+  {
+    ic1 = 0;
+    ic2 = x;
+  }
+
+  float run(float x)
+  {
+    const float v3 = x - ic2;
+    const float v1 = a1 * ic1 + a2 * v3; // band
+    const float v2 = ic2 + a2 * ic1 + a3 * v3; // low
+    ic1 = 2.0f * v1 - ic1;
+    ic2 = 2.0f * v2 - ic2;
+    return high ? x - k * v1 - v2 : v2;
+  }
+};
@@ -0,0 +1,399 @@
+#include "live_sampler.h"
+
+#include "sensor_service.h"
+#include "vib_severity.h"
+
+static volatile bool s_running = false;
+static volatile uint32_t s_kickMs = 0;
+static volatile float s_cutoff = 200.0f;
+static volatile uint8_t s_rate = LIVE_RATE_DEFAULT;
+
+// newest LIVE_RING_N raw samples; s_head counts every sample written
+static Sample6 s_ring[LIVE_RING_N];
+static volatile uint32_t s_head = 0;
+static LiveRingInfo s_info{};
+
+// One publication interval of the rolling window.
+struct LiveSlot
+{
+  uint32_t n;             // samples
+  uint32_t used;          // samples past the severity settle time
+  double acc[3];          // sum of low-passed acceleration (m/s^2)
+  double ss[3];           // velocity sum of squares
+  float dMin[3], dMax[3]; // displacement (um)
+};
+static const uint8_t LIVE_SLOTS = LIVE_RATE_MAX * LIVE_WINDOW_MS / 1000;
+static LiveSlot s_slots[LIVE_SLOTS];
+static uint8_t s_slotPos = 0;
+static uint8_t s_slotsFilled = 0;
+
+// Feed state. There is one producer at a time, the sampler job or the tap
+// of a capture, and both run on the sensor service task.
+static VibSeverity s_sev;
+static bool s_sevOk = false;
+static LiveSlot s_cur;
+static ConvCoeffs s_cc;
+static float s_hz = LIVE_PREVIEW_HZ;
+static float s_lpf[3];
+static bool s_lpfInit = false;
+static uint32_t s_busyUs = 0; // producer time since the last publication
+static uint32_t s_wall0 = 0;
+
+// capture tap
+static volatile bool s_tap = false;     // a capture owns the sensor and feeds the ring
+static volatile bool s_tapIdle = false; // nobody watching: the tap costs nothing
+static ConvCoeffs s_tapCc;
+static float s_tapHz = 0;
+static volatile uint8_t s_source = 0; // LiveSource of the ring contents
+
+static bool sensorWanted()
+{
+  return g_recording || g_streaming || g_calibratingStatic || g_calibrating6 || sensorJobPending();
+}
+
+static bool watched() { return millis() - s_kickMs < LIVE_IDLE_MS; }
+
+// Closes the running slot and publishes the window of the newest slots.
+static void publish(LiveSlot &cur, VibSeverity &sev, float cpuPct)
+{
+  cur.used = sev.used();
+  for (uint8_t a = 0; a < 3; a++)
+  {
+    cur.ss[a] = sev.velSumSq(a);
+    cur.dMin[a] = sev.dispMinUm(a);
+    cur.dMax[a] = sev.dispMaxUm(a);
+  }
+  sev.clearStats();
+  s_slots[s_slotPos] = cur;
+  s_slotPos = (s_slotPos + 1) % LIVE_SLOTS;
+  if (s_slotsFilled < LIVE_SLOTS)
+    s_slotsFilled++;
+  memset(&cur, 0, sizeof(cur));
+
+  uint32_t k = (LIVE_WINDOW_MS * s_rate + 999) / 1000;
+  if (k > s_slotsFilled)
+    k = s_slotsFilled;
+  LiveSlot w{};
+  for (uint8_t a = 0; a < 3; a++)
+  {
+    w.dMin[a] = INFINITY;
+    w.dMax[a] = -INFINITY;
+  }
+  for (uint32_t i = 0; i < k; i++)
+  {
+    const LiveSlot &s = s_slots[(s_slotPos + LIVE_SLOTS - 1 - i) % LIVE_SLOTS];
+    w.n += s.n;
+    w.used += s.used;
+    for (uint8_t a = 0; a < 3; a++)
+    {
+      w.acc[a] += s.acc[a];
+      w.ss[a] += s.ss[a];
+      if (s.used && s.dMin[a] < w.dMin[a])
+        w.dMin[a] = s.dMin[a];
+      if (s.used && s.dMax[a] > w.dMax[a])
+        w.dMax[a] = s.dMax[a];
+    }
+  }
+  if (!w.n)
+    return;
+
+  float acc[3], vel[3], disp[3];
+  for (uint8_t a = 0; a < 3; a++)
+  {
+    acc[a] = (float)(w.acc[a] / w.n);
+    vel[a] = w.used ? (float)sqrt(w.ss[a] / w.used) : 0.0f;
+    disp[a] = w.used ? (w.dMax[a] - w.dMin[a]) / 1000.0f : 0.0f;
+  }
+  const float mag = sqrtf(acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2]);
+  const float vmag = sqrtf(vel[0] * vel[0] + vel[1] * vel[1] + vel[2] * vel[2]);
+  const float dmag = sqrtf(disp[0] * disp[0] + disp[1] * disp[1] + disp[2] * disp[2]);
+
+  portENTER_CRITICAL(&g_liveMux);
+  for (uint8_t a = 0; a < 3; a++)
+  {
+    g_live_acc_mps2[a] = acc[a];
+    g_live_vel_mmps[a] = vel[a];
+    g_live_disp_mm[a] = disp[a];
+    g_live_g[a] = acc[a] / GRAVITY_MPS2;
+  }
+  g_live_mag_acc = mag;
+  g_live_mag_vel_mmps = vmag;
+  g_live_mag_disp_mm = dmag;
+  g_liveWindowN = w.n;
+  g_liveCpuPct = cpuPct;
+  g_liveRateHz = s_rate;
+  g_liveLastMs = millis();
+  portEXIT_CRITICAL(&g_liveMux);
+}
+
+// New session: empty ring and window, filters from scratch.
+static void feedBegin(const ConvCoeffs &cc, float hz, LiveSource src)
+{
+  // band-limited velocity RMS / displacement p-p; filters run for the whole
+  // session, statistics restart per slot. Too slow a rate has no band.
+  s_sevOk = s_sev.begin(hz, 10.0f);
+  memset(&s_cur, 0, sizeof(s_cur));
+  s_slotPos = 0;
+  s_slotsFilled = 0;
+  s_cc = cc;
+  s_hz = hz;
+  s_lpfInit = false;
+  s_busyUs = 0;
+  s_wall0 = micros();
+  portENTER_CRITICAL(&g_liveMux);
+  s_info.cc = cc;
+  s_info.hz = hz;
+  s_info.session++;
+  s_head = 0;
+  s_source = (uint8_t)src;
+  portEXIT_CRITICAL(&g_liveMux);
+}
+
+// Raw samples into the ring, calibrated ones into the running slot.
+static void feed(const Sample6 *s, size_t n)
+{
+  const float dt = 1.0f / s_hz;
+  const float alpha = dt / (1.0f / (2.0f * PI * s_cutoff) + dt); // 1st-order LPF coefficient
+  uint32_t head = s_head;
+  for (size_t i = 0; i < n; i++)
+  {
+    s_ring[head & (LIVE_RING_N - 1)] = s[i];
+    head++;
+
+    float g[3];
+    convertSample(s[i], s_cc, g);
+    for (uint8_t a = 0; a < 3; a++)
+    {
+      const float acc = g[a] * GRAVITY_MPS2;
+      if (!s_lpfInit)
+        s_lpf[a] = acc;
+      else
+        s_lpf[a] += alpha * (acc - s_lpf[a]);
+      s_cur.acc[a] += s_lpf[a];
+    }
+    s_lpfInit = true;
+    if (s_sevOk)
+      s_sev.push(g);
+    s_cur.n++;
+  }
+  s_head = head; // samples are in place before the count moves
+}
+
+// Publishes once the running slot holds 1 / rate seconds of samples.
+static void feedTick()
+{
+  uint32_t slotN = (uint32_t)(s_hz / (float)s_rate);
+  if (slotN < 1)
+    slotN = 1;
+  if (s_cur.n < slotN)
+    return;
+  const uint32_t wall = micros() - s_wall0;
+  publish(s_cur, s_sev, wall ? 100.0f * (float)s_busyUs / (float)wall : 0.0f);
+  s_busyUs = 0;
+  s_wall0 = micros();
+}
+
+// Runs on the sensor service task until the sensor is wanted elsewhere or
+// nobody asked for live values for LIVE_IDLE_MS.
+static void liveSamplerJob(LIS2DW12 &lis, void * /*arg*/)
+{
+  const uint32_t tSetup0 = micros();
+  const uint32_t saved0 = lis.busTransactionsSaved();
+  LIS2DW12::Config cfg;
+  cfg.odr = LIS2DW12::Odr::Hz800_or_200; // LIVE_PREVIEW_HZ
+  cfg.mode = LIS2DW12::Mode::HighPerf;
+  cfg.lpMode = LIS2DW12::LowPowerMode::LP2_14bit;
+  cfg.fs = LIS2DW12::FullScale::G2;
+  cfg.lowNoise = true;
+  cfg.bdu = true;
+  cfg.autoInc = true;
+  if (!lis.applyConfig(cfg) || !lis.setFifo(LIS2DW12::FifoMode::Bypass) ||
+      !lis.setFifo(LIS2DW12::FifoMode::Continuous))
+  {
+    s_running = false;
+    return;
+  }
+  g_liveSetupUs = micros() - tSetup0;
+  g_liveTxSaved = lis.busTransactionsSaved() - saved0;
+
+  // calibration + sensitivity folded once: one multiply-add per axis below
+  const LIS2DW12::Calibration &cal = sensorCalibration();
+  feedBegin(convCoeffs(lis.activeResolutionBits(), 2, cal.offset_g, cal.scale), (float)LIVE_PREVIEW_HZ,
+            LiveSource::Sampler); // +-2 g
+  g_liveOverruns = 0;
+
+  int16_t buf[LIS2DW12::FIFO_DEPTH][3];
+  uint32_t errors = 0;
+
+  while (!sensorWanted() && watched() && errors < 50)
+  {
+    const uint32_t t0 = micros();
+    LIS2DW12::FifoStatus st;
+    if (!lis.readFifoStatus(st) || (st.level && !lis.readFifoBurst(buf, st.level)))
+    {
+      errors++;
+    }
+    else
+    {
+      if (st.overrun)
+        g_liveOverruns++;
+      if (st.level)
+        sensorMarkFirstSample();
+      feed(reinterpret_cast<const Sample6 *>(buf), st.level);
+    }
+    s_busyUs += micros() - t0;
+    feedTick();
+    vTaskDelay(pdMS_TO_TICKS(LIVE_POLL_MS));
+  }
+
+  lis.setFifo(LIS2DW12::FifoMode::Bypass);
+  s_running = false;
+}
+
+void liveTapBegin(const ConvCoeffs &cc, float hz, LiveSource src)
+{
+  s_tapCc = cc;
+  s_tapHz = hz;
+  s_source = (uint8_t)src; // what /api/live reports until the first feed
+  s_tapIdle = true;        // the first watched push starts the session
+  s_tap = true;
+}
+
+void liveTapPush(const Sample6 *s, size_t n)
+{
+  if (!watched())
+  {
+    s_tapIdle = true;
+    return;
+  }
+  const uint32_t t0 = micros();
+  if (s_tapIdle)
+  {
+    feedBegin(s_tapCc, s_tapHz, (LiveSource)s_source);
+    s_tapIdle = false;
+  }
+  feed(s, n);
+  s_busyUs += micros() - t0;
+  feedTick();
+}
+
+void liveTapEnd() { s_tap = false; }
+
+void liveSamplerKick(float cutoffHz, uint8_t rateHz)
+{
+  if (rateHz < 1)
+    rateHz = 1;
+  if (rateHz > LIVE_RATE_MAX)
+    rateHz = LIVE_RATE_MAX;
+  s_cutoff = cutoffHz;
+  s_rate = rateHz;
+  s_kickMs = millis();
+  if (s_running || s_tap) // a capture tap feeds the values meanwhile
+    return;
+  s_running = true;
+  SensorJob job;
+  job.fn = liveSamplerJob;
+  job.clockHz = SENSOR_I2C_FAST_HZ;
+  if (!sensorServiceSubmit(job))
+    s_running = false;
+}
+
+bool liveSamplerRunning() { return s_running || (s_tap && !s_tapIdle); }
+
+size_t liveSamplerTail(Sample6 *dst, size_t n, uint32_t *total)
+{
+  if (n > LIVE_RING_N)
+    n = LIVE_RING_N;
+  for (uint8_t tries = 0; tries < 3; tries++)
+  {
+    const uint32_t head = s_head;
+    const size_t k = head < n ? head : n;
+    for (size_t i = 0; i < k; i++)
+      dst[i] = s_ring[(head - k + i) & (LIVE_RING_N - 1)];
+    // the writer may have lapped the oldest copied samples meanwhile
+    if (s_head - (head - k) <= LIVE_RING_N)
+    {
+      if (total)
+        *total = head;
+      return k;
+    }
+  }
+  return 0;
+}
+
+uint32_t liveSamplerCount() { return s_head; }
+
+bool liveSamplerRead(uint32_t from, Sample6 *dst, size_t n)
+{
+  const uint32_t head = s_head;
+  if (n > LIVE_RING_N || head - from < n || head - from > LIVE_RING_N)
+    return false;
+  for (size_t i = 0; i < n; i++)
+    dst[i] = s_ring[(from + i) & (LIVE_RING_N - 1)];
+  // the writer may have lapped the oldest copied samples meanwhile
+  return s_head - from <= LIVE_RING_N;
+}
+
+LiveRingInfo liveSamplerInfo()
+{
+  portENTER_CRITICAL(&g_liveMux);
+  const LiveRingInfo i = s_info;
+  portEXIT_CRITICAL(&g_liveMux);
+  return i;
+}
+
+// Copies the sampler's values under g_liveMux: one consistent publication.
+String liveJson()
+{
+  float acc[3], vel[3], disp[3], mag, vmag, dmag, cpu;
+  uint32_t lastMs, windowN;
+  uint8_t rate;
+  float hz;
+  LiveSource src;
+  portENTER_CRITICAL(&g_liveMux);
+  hz = s_info.hz;
+  src = (LiveSource)s_source;
+  memcpy(acc, g_live_acc_mps2, sizeof(acc));
+  memcpy(vel, g_live_vel_mmps, sizeof(vel));
+  memcpy(disp, g_live_disp_mm, sizeof(disp));
+  mag = g_live_mag_acc;
+  vmag = g_live_mag_vel_mmps;
+  dmag = g_live_mag_disp_mm;
+  cpu = g_liveCpuPct;
+  lastMs = g_liveLastMs;
+  windowN = g_liveWindowN;
+  rate = g_liveRateHz;
+  portEXIT_CRITICAL(&g_liveMux);
+
+  String s = "{";
+  s += "\"enabled\":true,";
+  s += "\"ready\":" + String(lastMs ? "true" : "false") + ",";
+  s += "\"running\":" + String(liveSamplerRunning() ? "true" : "false") + ",";
+  s += "\"source\":\"" + String(liveSourceName(src)) + "\",";
+  s += "\"hz\":" + String(hz, 1) + ",";
+  s += "\"fc\":" + String(g_live_lp_cut_hz, 1) + ",";
+  s += "\"rate\":" + String(rate) + ",";
+  s += "\"window_ms\":" + String(LIVE_WINDOW_MS) + ",";
+  s += "\"window_n\":" + String(windowN) + ",";
+  s += "\"age_ms\":" + String(lastMs ? millis() - lastMs : 0) + ",";
+  s += "\"ax\":" + String(acc[0], 3) + ",";
+  s += "\"ay\":" + String(acc[1], 3) + ",";
+  s += "\"az\":" + String(acc[2], 3) + ",";
+  s += "\"mag\":" + String(mag, 3) + ",";
+  s += "\"vx_mmps\":" + String(vel[0], 2) + ",";
+  s += "\"vy_mmps\":" + String(vel[1], 2) + ",";
+  s += "\"vz_mmps\":" + String(vel[2], 2) + ",";
+  s += "\"vmag_mmps\":" + String(vmag, 2) + ",";
+  s += "\"dx_mm\":" + String(disp[0], 2) + ",";
+  s += "\"dy_mm\":" + String(disp[1], 2) + ",";
+  s += "\"dz_mm\":" + String(disp[2], 2) + ",";
+  s += "\"dmag_mm\":" + String(dmag, 2) + ",";
+  s += "\"cpu_pct\":" + String(cpu, 2) + ",";
+  s += "\"overruns\":" + String(g_liveOverruns) + ",";
+  s += "\"serve_us\":" + String(g_liveServeUs) + ",";
+  s += "\"setup_us\":" + String(g_liveSetupUs) + ",";
+  s += "\"tx_saved\":" + String(g_liveTxSaved) + ",";
+  s += "\"first_sample_us\":" + String((uint32_t)g_firstSampleUs);
+  s += "}";
+  return s;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "app_state.h"
+#include "sample_convert.h"
+
+// Background live preview: an open-ended sensor-service job that runs while
+// nothing else needs the sensor. The FIFO (LIVE_PREVIEW_HZ, +-2 g, 14 bit)
+// is drained every LIVE_POLL_MS into a ring of the newest LIVE_RING_N raw
+// samples, and the g_live_* values are republished `rate` times a second
+// over a rolling window of LIVE_WINDOW_MS (one slot of sums per
+// publication, so nothing is recomputed). /api/live only copies them under
+// g_liveMux. The job returns as soon as another job is queued (recording,
+// calibration, stream) and after LIVE_IDLE_MS without a request; the next
+// request starts it again.
+// While a recording or stream owns the sensor, its capture loop feeds the
+// same ring and publications with the samples it reads anyway (liveTap*):
+// no extra bus traffic, and nothing at all while nobody is watching. The
+// ring needs no lock (one writer, count moved after the data); only the
+// rate-limited publication takes g_liveMux.
+static const size_t LIVE_RING_N = 1024;      // ~1.3 s at 800 Hz, power of two
+static const uint32_t LIVE_POLL_MS = 20;     // 16 samples per drain, the FIFO holds 32
+static const uint32_t LIVE_WINDOW_MS = 1000; // span of the published values
+static const uint32_t LIVE_IDLE_MS = 10000;  // no request for this long: sampler stops
+static const uint8_t LIVE_RATE_DEFAULT = 4;  // publications per second
+static const uint8_t LIVE_RATE_MAX = 20;
+
+static_assert((LIVE_RING_N & (LIVE_RING_N - 1)) == 0, "ring index is masked");
+
+enum class LiveSource : uint8_t
+{
+  Sampler,   // the background job, LIVE_PREVIEW_HZ / +-2 g
+  Recording, // tap of a recording, its rate and range
+  Stream,    // tap of a TCP stream session
+};
+
+inline const char *liveSourceName(LiveSource s)
+{
+  return s == LiveSource::Recording ? "recording" : s == LiveSource::Stream ? "stream" : "sampler";
+}
+
+// Starts the sampler unless it (or a capture tap) runs already, and keeps it
+// alive.
+// cutoffHz: preview low-pass of the acceleration; rateHz: 1 .. LIVE_RATE_MAX.
+void liveSamplerKick(float cutoffHz, uint8_t rateHz);
+bool liveSamplerRunning();
+
+// Newest n (<= LIVE_RING_N) raw samples into dst, oldest first; returns how
+// many were copied (fewer right after a start). total: samples taken since
+// the sampler started, the last copied one included.
+size_t liveSamplerTail(Sample6 *dst, size_t n, uint32_t *total = nullptr);
+
+// Samples taken since the sampler started (the index of the next one).
+uint32_t liveSamplerCount();
+
+// Samples from .. from+n-1 (counted like `total`) into dst; false when they
+// are not all written yet or already overwritten.
+bool liveSamplerRead(uint32_t from, Sample6 *dst, size_t n);
+
+// What the ring holds: g = raw * cc.k + cc.b at hz. session changes whenever
+// a new sampler run starts counting from zero.
+struct LiveRingInfo
+{
+  ConvCoeffs cc;
+  float hz;
+  uint32_t session;
+};
+LiveRingInfo liveSamplerInfo();
+
+// Capture tap, called from the sensor task by a capture that owns the
+// sensor: begin with the conversion and rate of its raw samples, push every
+// burst as read (after quantisation), end when the FIFO is stopped.
+void liveTapBegin(const ConvCoeffs &cc, float hz, LiveSource src);
+void liveTapPush(const Sample6 *s, size_t n);
+void liveTapEnd();
+
+// Latest publication as the /api/live JSON, copied under g_liveMux.
+String liveJson();
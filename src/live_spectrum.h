@@ -0,0 +1,233 @@
+#pragma once
+
+// Running spectrum of a live stream: frames of n samples (the caller fills
+// input() and calls frame()), mean removed, windowed, real FFT
+// (fft_f32.h), power per bin folded into an average and a peak hold.
+//   - None:   the average is the last frame
+//   - Linear: equal weight for the first k frames, then it holds (done())
+//   - Exp:    each frame weighs 1/k (1/frames while fewer than k, so the
+//             start is not biased towards zero)
+// Averaging is on power (RMS averaging), so noise does not cancel out; the
+// peak hold keeps the largest power per bin. Every buffer is allocated in
+// begin(), frame() itself allocates nothing.
+//
+// Wire format of /api/livefft (little endian, no padding):
+//   LiveFftHdr | bins cells of the average | bins cells of the peak hold
+//   (only when flags & LIVE_FFT_PEAK)
+// Cells as in stft.h: dB = db_lo + v * db_step re 1 g peak, frequency of
+// cell k = k * rate_hz / n.
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "welch_psd.h"
+
+enum class LiveAvg : uint8_t
+{
+  None,
+  Linear,
+  Exp,
+};
+
+inline const char *liveAvgName(LiveAvg a)
+{
+  return a == LiveAvg::Linear ? "lin" : a == LiveAvg::Exp ? "exp" : "none";
+}
+
+inline bool liveAvgFromName(const char *s, LiveAvg &out)
+{
+  static const LiveAvg all[] = {LiveAvg::None, LiveAvg::Linear, LiveAvg::Exp};
+  for (LiveAvg a : all)
+    if (strcmp(s, liveAvgName(a)) == 0)
+    {
+      out = a;
+      return true;
+    }
+  return false;
+}
+
+static const char LIVE_FFT_MAGIC[4] = {'L', 'F', 'F', 'T'};
+static const uint8_t LIVE_FFT_PEAK = 0x01; // peak hold row follows
+static const uint8_t LIVE_FFT_DONE = 0x02; // linear average complete
+static const uint8_t LIVE_FFT_GAP = 0x04;  // frames were skipped since the last reply
+
+#pragma pack(push, 1)
+struct LiveFftHdr
+{
+  char magic[4];      // LIVE_FFT_MAGIC
+  uint16_t hdr_bytes; // sizeof(LiveFftHdr): readers skip what they do not know
+  uint8_t cell_bytes; // 1 = uint8, 2 = uint16
+  uint8_t window;     // FftWindow
+  uint16_t n;
+  uint16_t bins;   // cells per row
+  uint8_t avg;     // LiveAvg
+  uint8_t flags;   // LIVE_FFT_*
+  uint16_t avg_k;  // averaging length (frames)
+  uint32_t frames; // frames in the average since the last reset
+  uint32_t skipped; // frames lost to a lapped ring since the last reset
+  float rate_hz;
+  float db_lo;
+  float db_step;
+  char axis; // 'x' 'y' 'z' or 'm' (|a|)
+  uint8_t reserved[3];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(LiveFftHdr) == 40, "wire format");
+
+class LiveSpectrum
+{
+public:
+  LiveSpectrum() = default;
+  LiveSpectrum(const LiveSpectrum &) = delete;
+  LiveSpectrum &operator=(const LiveSpectrum &) = delete;
+  ~LiveSpectrum() { end(); }
+
+  // n: power of two, 16 .. FFT_MAX_N; k >= 1 frames (ignored for None).
+  bool begin(uint32_t n, FftWindow win, LiveAvg avg, uint32_t k)
+  {
+    if (n < 16 || !fftSizeOk(n) || !k)
+      return false;
+    if (n != _n)
+    {
+      end();
+      _in = (float *)malloc(n * sizeof(float));
+      _w = (float *)malloc(n * sizeof(float));
+      _avg = (float *)malloc((n / 2 + 1) * sizeof(float));
+      _peak = (float *)malloc((n / 2 + 1) * sizeof(float));
+      if (!_in || !_w || !_avg || !_peak)
+      {
+        end();
+        return false;
+      }
+      _n = n;
+      _win = (FftWindow)0xFF; // window table below
+    }
+    if (win != _win)
+    {
+      double s1 = 0;
+      for (uint32_t i = 0; i < n; i++)
+      {
+        _w[i] = fftWindowAt(win, i, n);
+        s1 += _w[i];
+      }
+      // |X[k]|^2 -> (peak amplitude)^2 of a sine on bin k
+      _powToAmp2 = (float)(4.0 / (s1 * s1));
+      _win = win;
+    }
+    _mode = avg;
+    _k = k;
+    reset();
+    return true;
+  }
+
+  void end()
+  {
+    free(_in);
+    free(_w);
+    free(_avg);
+    free(_peak);
+    _in = _w = _avg = _peak = nullptr;
+    _n = 0;
+  }
+
+  // Clears the average and the peak hold.
+  void reset()
+  {
+    _frames = 0;
+    if (_n)
+    {
+      memset(_avg, 0, bins() * sizeof(float));
+      memset(_peak, 0, bins() * sizeof(float));
+    }
+  }
+
+  // n samples of the next frame go here; frame() transforms them in place.
+  float *input() { return _in; }
+
+  void frame()
+  {
+    if (!_n || done())
+      return;
+    float mean = 0;
+    for (uint32_t i = 0; i < _n; i++)
+      mean += _in[i];
+    mean /= (float)_n;
+    for (uint32_t i = 0; i < _n; i++)
+      _in[i] = (_in[i] - mean) * _w[i];
+    fftReal(_in, _n);
+
+    _frames++;
+    const float a = _mode == LiveAvg::None                           ? 1.0f
+                    : (_mode == LiveAvg::Linear || _frames < _k) ? 1.0f / (float)_frames
+                                                                     : 1.0f / (float)_k;
+    for (uint32_t k = 0; k < bins(); k++)
+    {
+      float p;
+      if (k == 0)
+        p = _in[0] * _in[0] * 0.25f; // one-sided: DC and Nyquist are not doubled
+      else if (k == _n / 2)
+        p = _in[1] * _in[1] * 0.25f;
+      else
+        p = _in[2 * k] * _in[2 * k] + _in[2 * k + 1] * _in[2 * k + 1];
+      p *= _powToAmp2;
+      _avg[k] += a * (p - _avg[k]);
+      if (p > _peak[k])
+        _peak[k] = p;
+    }
+  }
+
+  uint32_t n() const { return _n; }
+  uint32_t bins() const { return _n / 2 + 1; }
+  uint32_t frames() const { return _frames; }
+  FftWindow window() const { return _win; }
+  LiveAvg avg() const { return _mode; }
+  uint32_t avgK() const { return _k; }
+  // a linear average of k frames is complete and no longer changes
+  bool done() const { return _mode == LiveAvg::Linear && _frames >= _k; }
+
+  // Averaged / peak-held peak amplitude of a sine centred on bin k (units).
+  float amplitudeAt(uint32_t k) const { return _n ? sqrtf(_avg[k]) : 0.0f; }
+  float peakAt(uint32_t k) const { return _n ? sqrtf(_peak[k]) : 0.0f; }
+
+  // First `cells` bins of the average (or the peak hold) as dB cells from
+  // dbLo in steps of dbStep, little endian.
+  void quantise(uint8_t *dst, uint32_t cells, bool peak, uint8_t cellBytes, float dbLo, float dbStep) const
+  {
+    const float *src = peak ? _peak : _avg;
+    const float maxCell = cellBytes == 1 ? 255.0f : 65535.0f;
+    for (uint32_t k = 0; k < cells; k++)
+    {
+      float v = 0;
+      if (src[k] > 0)
+      {
+        v = (10.0f * log10f(src[k]) - dbLo) / dbStep + 0.5f;
+        if (v < 0)
+          v = 0;
+        if (v > maxCell)
+          v = maxCell;
+      }
+      const uint16_t q = (uint16_t)v;
+      if (cellBytes == 1)
+        dst[k] = (uint8_t)q;
+      else
+      {
+        dst[2 * k] = (uint8_t)q;
+        dst[2 * k + 1] = (uint8_t)(q >> 8);
+      }
+    }
+  }
+
+private:
+  float *_in = nullptr;   // frame, then its FFT
+  float *_w = nullptr;    // window
+  float *_avg = nullptr;  // averaged (peak amplitude)^2 per bin
+  float *_peak = nullptr; // largest (peak amplitude)^2 per bin
+  uint32_t _n = 0;
+  uint32_t _k = 1;
+  uint32_t _frames = 0;
+  float _powToAmp2 = 0;
+  FftWindow _win = FftWindow::Hann;
+  LiveAvg _mode = LiveAvg::Exp;
+};
@@ -6,6 +6,9 @@
 #include "api_handlers.h"
 #include "app_state.h"
 #include "config.h"
+#include "event_push.h"
+#include "rec_writer.h"
+#include "sensor_service.h"
 
 static void startWiFiOrAP()
 {
@@ -76,18 +79,21 @@ void setup()
   Wire.begin(21, 22);
   Wire.setClock(400000);
 
-  g_i2cMutex = xSemaphoreCreateMutex();
-  if (!g_i2cMutex)
+  if (!sensorServiceStart())
   {
-    Serial.println("I2C mutex alloc FAIL");
+    Serial.println("Sensor service start FAIL");
     while (1)
       delay(1000);
   }
-  Serial.println("[BOOT] I2C + mutex ready");
+  Serial.println("[BOOT] I2C + sensor service ready");
 
   startWiFiOrAP();
   Serial.println("[BOOT] WiFi/AP init done");
 
+  g_repairedFiles = recRepairInterrupted();
+  if (g_repairedFiles)
+    Serial.printf("[BOOT] %u interrupted recording(s) repaired\n", (unsigned)g_repairedFiles);
+
   rebuildListCache();
   Serial.println("[BOOT] FS list cache built");
   registerRoutes();
@@ -95,6 +101,8 @@ void setup()
 
   server.begin();
   Serial.println("[BOOT] HTTP server started");
+  if (eventPushStart())
+    Serial.printf("[BOOT] Events on port %u\n", (unsigned)EVENTS_PORT);
 
   Serial.println("Web ready:");
   if (!g_apMode)
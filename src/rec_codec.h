@@ -0,0 +1,265 @@
+#pragma once
+
+// V4 block codec: per axis planar, first sample verbatim, then zigzag deltas
+// Rice-coded with one k per axis per block. Falls back to plain int16 when
+// a block would not shrink, so a block never costs more than raw + 9 bytes.
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rec_format.h"
+
+// Quotients >= this are escaped: ESC ones, then the zigzag value in 17 bits.
+static const uint8_t REC_RICE_ESC = 20;
+static const uint8_t REC_ZZ_BITS = 17; // int16 delta -> 17-bit zigzag
+
+// Upper bound of one encoded block (header included).
+inline constexpr size_t recV4MaxBlockBytes(size_t n)
+{
+  return sizeof(RecBlockHdrV4) + 3 * (3 + 2 * (n ? n - 1 : 0));
+}
+
+inline int16_t recAxis(const Sample6 &s, size_t axis) { return axis == 0 ? s.ax : axis == 1 ? s.ay : s.az; }
+inline void recSetAxis(Sample6 &s, size_t axis, int16_t v)
+{
+  if (axis == 0)
+    s.ax = v;
+  else if (axis == 1)
+    s.ay = v;
+  else
+    s.az = v;
+}
+
+inline uint32_t zigzag32(int32_t d) { return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31); }
+inline int32_t unzigzag32(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+class RecBitWriter
+{
+public:
+  RecBitWriter(uint8_t *out) : _out(out) {}
+
+  void put(uint32_t v, uint8_t bits) // bits <= 24
+  {
+    _acc = (_acc << bits) | (v & ((1u << bits) - 1));
+    _n += bits;
+    while (_n >= 8)
+    {
+      _n -= 8;
+      *_out++ = (uint8_t)(_acc >> _n);
+    }
+  }
+  void ones(uint8_t count)
+  {
+    while (count >= 16)
+    {
+      put(0xFFFF, 16);
+      count -= 16;
+    }
+    if (count)
+      put((1u << count) - 1, count);
+  }
+  uint8_t *finish() // pad to a byte
+  {
+    if (_n)
+      put(0, 8 - _n);
+    return _out;
+  }
+
+private:
+  uint8_t *_out;
+  uint32_t _acc = 0;
+  uint8_t _n = 0;
+};
+
+class RecBitReader
+{
+public:
+  RecBitReader(const uint8_t *in, const uint8_t *end) : _in(in), _end(end) {}
+
+  bool get(uint8_t bits, uint32_t &v) // bits <= 24
+  {
+    while (_n < bits)
+    {
+      if (_in >= _end)
+        return false;
+      _acc = (_acc << 8) | *_in++;
+      _n += 8;
+    }
+    _n -= bits;
+    v = (_acc >> _n) & ((1u << bits) - 1);
+    return true;
+  }
+  // Counts leading ones up to limit; consumes the terminating zero if any.
+  bool unary(uint8_t limit, uint8_t &q)
+  {
+    q = 0;
+    uint32_t b;
+    while (q < limit)
+    {
+      if (!get(1, b))
+        return false;
+      if (!b)
+        return true;
+      q++;
+    }
+    return true;
+  }
+  const uint8_t *position() const { return _in; } // after padding bits
+
+private:
+  const uint8_t *_in;
+  const uint8_t *_end;
+  uint32_t _acc = 0;
+  uint8_t _n = 0;
+};
+
+// ---- encoder ----
+inline uint8_t *recEncodeAxis(const Sample6 *s, size_t n, size_t axis, uint8_t *out)
+{
+  int16_t first = recAxis(s[0], axis);
+  memcpy(out, &first, 2);
+  out += 2;
+  if (n < 2)
+  {
+    *out++ = 0;
+    return out;
+  }
+
+  // pass 1: pick k from the mean zigzag delta, then size the Rice stream
+  uint32_t sum = 0;
+  int16_t prev = first;
+  for (size_t i = 1; i < n; i++)
+  {
+    int16_t cur = recAxis(s[i], axis);
+    sum += zigzag32((int32_t)cur - prev);
+    prev = cur;
+  }
+  const uint32_t mean = sum / (uint32_t)(n - 1);
+  uint8_t k = 0;
+  while (k < 16 && (2u << k) <= mean)
+    k++;
+
+  uint32_t bits = 0;
+  prev = first;
+  for (size_t i = 1; i < n; i++)
+  {
+    int16_t cur = recAxis(s[i], axis);
+    uint32_t q = zigzag32((int32_t)cur - prev) >> k;
+    bits += (q < REC_RICE_ESC) ? (q + 1 + k) : (REC_RICE_ESC + REC_ZZ_BITS);
+    prev = cur;
+  }
+
+  if ((bits + 7) / 8 >= 2 * (n - 1))
+  {
+    *out++ = REC_V4_K_RAW;
+    for (size_t i = 1; i < n; i++)
+    {
+      int16_t cur = recAxis(s[i], axis);
+      memcpy(out, &cur, 2);
+      out += 2;
+    }
+    return out;
+  }
+
+  // pass 2: emit
+  *out++ = k;
+  RecBitWriter bw(out);
+  prev = first;
+  for (size_t i = 1; i < n; i++)
+  {
+    int16_t cur = recAxis(s[i], axis);
+    uint32_t zz = zigzag32((int32_t)cur - prev);
+    uint32_t q = zz >> k;
+    if (q < REC_RICE_ESC)
+    {
+      bw.ones((uint8_t)q);
+      bw.put(0, 1);
+      if (k)
+        bw.put(zz, k);
+    }
+    else
+    {
+      bw.ones(REC_RICE_ESC);
+      bw.put(zz, REC_ZZ_BITS);
+    }
+    prev = cur;
+  }
+  return bw.finish();
+}
+
+// Whole block incl. RecBlockHdrV4; out must hold recV4MaxBlockBytes(n).
+inline size_t recEncodeBlockV4(const Sample6 *s, size_t n, uint8_t *out)
+{
+  uint8_t *p = out + sizeof(RecBlockHdrV4);
+  for (size_t axis = 0; axis < 3; axis++)
+    p = recEncodeAxis(s, n, axis, p);
+
+  RecBlockHdrV4 bh;
+  bh.sync = REC_V4_SYNC;
+  bh.n = (uint16_t)n;
+  bh.bytes = (uint16_t)(p - out - sizeof(RecBlockHdrV4));
+  memcpy(out, &bh, sizeof(bh));
+  return (size_t)(p - out);
+}
+
+// ---- decoder ----
+inline const uint8_t *recDecodeAxis(const uint8_t *in, const uint8_t *end, Sample6 *s, size_t n, size_t axis)
+{
+  if (end - in < 3)
+    return nullptr;
+  int16_t prev;
+  memcpy(&prev, in, 2);
+  uint8_t k = in[2];
+  in += 3;
+  recSetAxis(s[0], axis, prev);
+
+  if (k == REC_V4_K_RAW)
+  {
+    if ((size_t)(end - in) < 2 * (n ? n - 1 : 0))
+      return nullptr;
+    for (size_t i = 1; i < n; i++)
+    {
+      int16_t v;
+      memcpy(&v, in, 2);
+      recSetAxis(s[i], axis, v);
+      in += 2;
+    }
+    return in;
+  }
+  if (k > 16)
+    return nullptr;
+
+  RecBitReader br(in, end);
+  for (size_t i = 1; i < n; i++)
+  {
+    uint8_t q;
+    uint32_t zz;
+    if (!br.unary(REC_RICE_ESC, q))
+      return nullptr;
+    if (q == REC_RICE_ESC)
+    {
+      if (!br.get(REC_ZZ_BITS, zz))
+        return nullptr;
+    }
+    else
+    {
+      uint32_t r = 0;
+      if (k && !br.get(k, r))
+        return nullptr;
+      zz = ((uint32_t)q << k) | r;
+    }
+    prev = (int16_t)(prev + unzigzag32(zz));
+    recSetAxis(s[i], axis, prev);
+  }
+  return br.position();
+}
+
+// Payload only (after RecBlockHdrV4); n from that header.
+inline bool recDecodeBlockV4(const uint8_t *payload, size_t bytes, size_t n, Sample6 *out)
+{
+  const uint8_t *p = payload;
+  const uint8_t *end = payload + bytes;
+  for (size_t axis = 0; axis < 3 && p; axis++)
+    p = recDecodeAxis(p, end, out, n, axis);
+  return p == end;
+}
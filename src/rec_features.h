@@ -0,0 +1,167 @@
+#pragma once
+
+// Per-recording features, accumulated by the writer while it stores the
+// samples and appended as the "FEAT" trailer chunk (rec_trailer.h), so
+// /api/analyze and /api/list read them instead of passing over the file.
+//
+// Moments are kept in raw units (aligned raw, as stored) and converted to g
+// with the file's calibration at read time. Each writer block is reduced on
+// its own (exact integer sum for the block mean, float powers of the
+// deviations from it) and merged into the running totals with the pairwise
+// update of Chan / Pebay, i.e. Welford one block at a time: stable for any
+// offset (gravity) and length, and only a handful of double operations per
+// block, not per sample (doubles are software on the ESP32).
+// Clipping: samples at the most negative / most positive code the stored
+// stream can hold (res_bits, minus the low bits q_bits clears). The
+// histogram spans the full scale, -fs_g .. +fs_g before calibration.
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rec_format.h"
+
+static const size_t REC_FEAT_BINS = 32; // fs_g / 16 per bin
+
+#pragma pack(push, 1)
+struct RecFeatureAxis
+{
+  double mean;           // raw
+  double m2, m3, m4;     // sums of (x - mean)^2, ^3, ^4 (raw)
+  int16_t min, max;      // raw
+  uint32_t clipLo;       // samples at clipCode[0]
+  uint32_t clipHi;       // samples at clipCode[1]
+  uint32_t hist[REC_FEAT_BINS];
+};
+
+struct RecFeatures
+{
+  uint32_t n;          // samples
+  int16_t clipCode[2]; // lowest / highest storable code
+  int16_t histLo;      // raw value at the bottom of bin 0
+  uint8_t histShift;   // bin = (raw - histLo) >> histShift
+  uint8_t bins;        // REC_FEAT_BINS
+  RecFeatureAxis axis[3];
+};
+#pragma pack(pop)
+
+// quantShift: low bits cleared in the stored samples (recQuantShift()).
+inline void recFeaturesBegin(RecFeatures &f, uint8_t res_bits, uint8_t quantShift)
+{
+  memset(&f, 0, sizeof(f));
+  const int32_t full = 1L << (res_bits - 1);
+  f.clipCode[0] = (int16_t)-full;
+  f.clipCode[1] = (int16_t)((full - 1) & ~((1L << quantShift) - 1));
+  f.histLo = (int16_t)-full;
+  f.histShift = (uint8_t)(res_bits - 5); // 2^res_bits codes over 32 bins
+  f.bins = REC_FEAT_BINS;
+  for (RecFeatureAxis &a : f.axis)
+  {
+    a.min = INT16_MAX;
+    a.max = INT16_MIN;
+  }
+}
+
+// Folds a block of n samples (n <= 65535) into f.
+inline void recFeaturesAdd(RecFeatures &f, const Sample6 *s, size_t n)
+{
+  if (!n)
+    return;
+  const double na = f.n, nb = (double)n, nt = na + nb;
+  for (int ax = 0; ax < 3; ax++)
+  {
+    RecFeatureAxis &a = f.axis[ax];
+    const int16_t *v = (const int16_t *)s + ax; // Sample6 is packed ax, ay, az
+    // block mean from the exact sum, counts and extremes
+    int32_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+      const int16_t x = v[3 * i];
+      sum += x;
+      if (x < a.min)
+        a.min = x;
+      if (x > a.max)
+        a.max = x;
+      if (x <= f.clipCode[0])
+        a.clipLo++;
+      else if (x >= f.clipCode[1])
+        a.clipHi++;
+      int32_t b = ((int32_t)x - f.histLo) >> f.histShift;
+      if (b < 0)
+        b = 0;
+      if (b >= (int32_t)REC_FEAT_BINS)
+        b = REC_FEAT_BINS - 1;
+      a.hist[b]++;
+    }
+    const float mb = (float)sum / (float)n;
+    float s2 = 0, s3 = 0, s4 = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+      const float d = (float)v[3 * i] - mb;
+      const float d2 = d * d;
+      s2 += d2;
+      s3 += d2 * d;
+      s4 += d2 * d2;
+    }
+    if (!f.n)
+    {
+      a.mean = (double)sum / nb;
+      a.m2 = s2;
+      a.m3 = s3;
+      a.m4 = s4;
+      continue;
+    }
+    // merge (na, a) with (nb, block)
+    const double d = (double)sum / nb - a.mean;
+    const double d2 = d * d;
+    const double m2a = a.m2, m3a = a.m3;
+    a.m4 += s4 + d2 * d2 * na * nb * (na * na - na * nb + nb * nb) / (nt * nt * nt) +
+            6.0 * d2 * (na * na * s2 + nb * nb * m2a) / (nt * nt) + 4.0 * d * (na * s3 - nb * m3a) / nt;
+    a.m3 += s3 + d2 * d * na * nb * (na - nb) / (nt * nt) + 3.0 * d * (na * s2 - nb * m2a) / nt;
+    a.m2 += s2 + d2 * na * nb / nt;
+    a.mean += d * nb / nt;
+  }
+  f.n += (uint32_t)n;
+}
+
+// One axis in calibrated g (g = k * raw + b).
+struct RecFeatureStats
+{
+  float mean, rms, std;
+  float min, max;
+  float peak;  // max |g|, gravity included
+  float pp;    // max - min
+  float crest; // max |g - mean| / std: crest factor of the vibration alone
+  float skew;  // 0 for a symmetric distribution
+  float kurt;  // 3 for Gaussian, 1.5 for a sine; impacts push it up
+  uint32_t clip;
+};
+
+inline RecFeatureStats recFeatureStats(const RecFeatures &f, int ax, float k, float b)
+{
+  RecFeatureStats r{};
+  const RecFeatureAxis &a = f.axis[ax];
+  if (!f.n)
+    return r;
+  const double n = f.n;
+  const double var = a.m2 / n;
+  r.mean = (float)(k * a.mean + b);
+  r.std = (float)(fabs(k) * sqrt(var));
+  r.rms = sqrtf(r.std * r.std + r.mean * r.mean);
+  const float g0 = k * a.min + b, g1 = k * a.max + b;
+  r.min = g0 < g1 ? g0 : g1;
+  r.max = g0 < g1 ? g1 : g0;
+  r.peak = fabsf(r.min) > fabsf(r.max) ? fabsf(r.min) : fabsf(r.max);
+  r.pp = r.max - r.min;
+  const float dev = fabsf(r.max - r.mean) > fabsf(r.min - r.mean) ? fabsf(r.max - r.mean) : fabsf(r.min - r.mean);
+  r.crest = r.std > 0 ? dev / r.std : 0.0f;
+  if (var > 0)
+  {
+    r.skew = (float)(a.m3 / n / (var * sqrt(var)));
+    if (k < 0)
+      r.skew = -r.skew;
+    r.kurt = (float)(a.m4 / n / (var * var));
+  }
+  r.clip = a.clipLo + a.clipHi;
+  return r;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// On-flash recording format.
+#include <stdint.h>
+
+#pragma pack(push, 1)
+struct FileHeaderV3
+{
+  char magic[8];     // "LIS2DW12"
+  uint16_t version;  // 3
+  uint16_t rate_hz;  // selected
+  uint16_t record_s; // selected
+  uint32_t samples;  // actually written
+  uint8_t fs_g;      // 2/4/8/16
+  uint8_t res_bits;  // 12/14
+  uint8_t q_bits;    // 0/10/12/14
+  uint8_t reserved0;
+  float cal_offset_g[3];
+  float cal_scale[3];
+};
+
+struct Sample6
+{
+  int16_t ax, ay, az; // aligned raw
+};
+
+// V4: V3 header (version = 4) + codec fields, followed by compressed blocks:
+//   RecBlockHdrV4 | payload
+// REC_CODEC_DELTA_RICE payload: axis X | axis Y | axis Z, each axis an
+// int16 first sample, uint8 k, then the n-1 zigzag deltas.
+// k <= 16: Rice(k) bitstream (MSB first, padded to a byte);
+// k == REC_V4_K_RAW: n-1 plain int16 values (block did not compress).
+// REC_CODEC_PACK12 / PACK10 payload: samples bit-packed at q_bits per axis
+// (see rec_pack.h); value << (res_bits - q_bits) is the aligned raw.
+struct FileHeaderV4
+{
+  FileHeaderV3 v3;  // v3.version = 4, v3.samples as in V3
+  uint16_t block_n; // samples per full block
+  uint8_t codec;    // REC_CODEC_*
+  uint8_t reserved1;
+};
+
+struct RecBlockHdrV4
+{
+  uint16_t sync;  // REC_V4_SYNC
+  uint16_t n;     // samples in this block (last one may be short)
+  uint16_t bytes; // payload bytes after this header
+};
+#pragma pack(pop)
+
+static const uint16_t REC_V4_SYNC = 0xB14C;
+static const uint8_t REC_CODEC_DELTA_RICE = 1;
+static const uint8_t REC_CODEC_PACK12 = 2; // 3 x 12 bit, 9 bytes per sample pair
+static const uint8_t REC_CODEC_PACK10 = 3; // 3 x 10 bit in one 32-bit word
+static const uint8_t REC_V4_K_RAW = 0xFF;
+static const uint16_t REC_V4_BLOCK_MAX = 256; // decoder buffer size (samples)
+
+inline bool recHeaderOk(const FileHeaderV3 &h)
+{
+  return h.magic[0] == 'L' && h.magic[1] == 'I' && h.magic[2] == 'S' && h.magic[3] == '2' &&
+         h.magic[4] == 'D' && h.magic[5] == 'W' && h.magic[6] == '1' && h.magic[7] == '2' &&
+         (h.version == 3 || h.version == 4);
+}
+
+inline uint32_t recHeaderBytes(uint16_t version)
+{
+  return version == 4 ? sizeof(FileHeaderV4) : sizeof(FileHeaderV3);
+}
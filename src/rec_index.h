@@ -0,0 +1,110 @@
+#pragma once
+
+// Trailing block index of a recording (V3 and V4):
+//   ... sample data ... | RecIndexEntry x entries | RecIndexFooter
+// One entry per REC_INDEX_N samples: where the block starts on flash, raw
+// per-axis min/max/sum/sum-of-squares and a CRC32 of the stored bytes.
+// Written by the writer at close, or appended on first access for files
+// that do not have one (older V3, repaired recordings). Trailer chunks
+// (rec_trailer.h) may sit before or after it.
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rec_format.h"
+
+static const uint16_t REC_INDEX_N = 1024;
+
+#pragma pack(push, 1)
+struct RecIndexEntry
+{
+  uint32_t offset; // file offset of the first stored byte of this block
+  uint16_t n;      // samples (last block may be short)
+  uint16_t reserved;
+  int16_t min[3];
+  int16_t max[3];
+  int32_t sum[3];
+  uint64_t sumsq[3];
+  uint32_t crc; // CRC32 of the stored bytes (raw Sample6 or V4 blocks)
+};
+
+struct RecIndexFooter
+{
+  uint32_t entries;
+  uint32_t samples;      // total indexed samples
+  uint32_t indexOffset;  // file offset of entry 0
+  uint16_t blockN;       // REC_INDEX_N at write time
+  uint16_t entryBytes;   // sizeof(RecIndexEntry)
+  uint32_t crc;          // CRC32 of all entries
+  char magic[8];         // "LISIDX01"
+};
+#pragma pack(pop)
+
+// ---- CRC32 (IEEE, reflected), nibble table: small and fast enough ----
+inline uint32_t recCrc32(uint32_t crc, const void *data, size_t len)
+{
+  static const uint32_t T[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+      0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  const uint8_t *p = (const uint8_t *)data;
+  crc = ~crc;
+  while (len--)
+  {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ T[crc & 0x0F];
+    crc = (crc >> 4) ^ T[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+inline void recIndexBegin(RecIndexEntry &e, uint32_t offset)
+{
+  memset(&e, 0, sizeof(e));
+  e.offset = offset;
+  for (int a = 0; a < 3; a++)
+  {
+    e.min[a] = INT16_MAX;
+    e.max[a] = INT16_MIN;
+  }
+}
+
+inline void recIndexAdd(RecIndexEntry &e, const Sample6 *s, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    const int16_t v[3] = {s[i].ax, s[i].ay, s[i].az};
+    for (int a = 0; a < 3; a++)
+    {
+      if (v[a] < e.min[a])
+        e.min[a] = v[a];
+      if (v[a] > e.max[a])
+        e.max[a] = v[a];
+      e.sum[a] += v[a];
+      e.sumsq[a] += (uint64_t)((int32_t)v[a] * v[a]);
+    }
+  }
+  e.n += (uint16_t)n;
+}
+
+inline void recIndexFooter(RecIndexFooter &f, const RecIndexEntry *e, uint32_t entries, uint32_t indexOffset)
+{
+  memset(&f, 0, sizeof(f));
+  f.entries = entries;
+  for (uint32_t i = 0; i < entries; i++)
+    f.samples += e[i].n;
+  f.indexOffset = indexOffset;
+  f.blockN = REC_INDEX_N;
+  f.entryBytes = sizeof(RecIndexEntry);
+  f.crc = recCrc32(0, e, entries * sizeof(RecIndexEntry));
+  memcpy(f.magic, "LISIDX01", 8);
+}
+
+// Footer sanity against the file it was read from (entries not checked).
+inline bool recIndexFooterOk(const RecIndexFooter &f, uint32_t fileBytes)
+{
+  return memcmp(f.magic, "LISIDX01", 8) == 0 && f.entryBytes == sizeof(RecIndexEntry) &&
+         f.blockN == REC_INDEX_N && f.indexOffset < fileBytes &&
+         (uint64_t)f.indexOffset + (uint64_t)f.entries * sizeof(RecIndexEntry) + sizeof(RecIndexFooter) == fileBytes;
+}
+
+inline uint32_t recIndexEntriesFor(uint32_t samples) { return (samples + REC_INDEX_N - 1) / REC_INDEX_N; }
@@ -0,0 +1,157 @@
+#pragma once
+
+// V4 packed codecs for quantised recordings (q_bits 10 / 12): each axis is
+// stored as a signed q-bit value, value << shift restores the aligned raw
+// (shift = res_bits - q_bits). Word-at-a-time: PACK12 moves a sample pair
+// as one 64-bit word + 1 byte, PACK10 one sample per 32-bit word, so there
+// is no per-bit loop on either side.
+// Also the codec dispatch used by the writer, RecReader and host tools.
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rec_codec.h"
+#include "rec_format.h"
+
+inline bool recCodecOk(uint8_t codec)
+{
+  return codec == REC_CODEC_DELTA_RICE || codec == REC_CODEC_PACK12 || codec == REC_CODEC_PACK10;
+}
+
+// Bits dropped by quantisation; 0 when q_bits is unset or not below res_bits.
+inline uint8_t recQuantShift(const FileHeaderV3 &h)
+{
+  return (h.q_bits && h.q_bits < h.res_bits) ? (uint8_t)(h.res_bits - h.q_bits) : 0;
+}
+
+inline constexpr size_t recPackedBytes(uint8_t codec, size_t n)
+{
+  return codec == REC_CODEC_PACK10 ? 4 * n : (n * 36 + 7) / 8;
+}
+
+static_assert(recPackedBytes(REC_CODEC_PACK12, REC_V4_BLOCK_MAX) + sizeof(RecBlockHdrV4) <=
+                  recV4MaxBlockBytes(REC_V4_BLOCK_MAX),
+              "packed blocks fit the V4 block buffer");
+
+inline uint64_t recLoad64(const uint8_t *p)
+{
+  uint64_t v;
+  memcpy(&v, p, 8); // little endian on both ESP32 and x86
+  return v;
+}
+
+// bits-wide two's complement field -> aligned raw
+inline int16_t recUnq(uint32_t v, uint8_t bits, uint8_t shift)
+{
+  return (int16_t)(((int32_t)(v << (32 - bits)) >> (32 - bits)) * (1 << shift));
+}
+
+// ---- 12 bit ----
+inline uint8_t *recPack12(const Sample6 *s, size_t n, uint8_t shift, uint8_t *out)
+{
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2)
+  {
+    const uint64_t w = (uint64_t)((uint16_t)(s[i].ax >> shift) & 0xFFF) |
+                       (uint64_t)((uint16_t)(s[i].ay >> shift) & 0xFFF) << 12 |
+                       (uint64_t)((uint16_t)(s[i].az >> shift) & 0xFFF) << 24 |
+                       (uint64_t)((uint16_t)(s[i + 1].ax >> shift) & 0xFFF) << 36 |
+                       (uint64_t)((uint16_t)(s[i + 1].ay >> shift) & 0xFFF) << 48 |
+                       (uint64_t)((uint16_t)(s[i + 1].az >> shift) & 0xFFF) << 60;
+    memcpy(out, &w, 8);
+    out[8] = (uint8_t)(((uint16_t)(s[i + 1].az >> shift) & 0xFFF) >> 4);
+    out += 9;
+  }
+  if (i < n) // odd tail: 36 bits in 5 bytes
+  {
+    const uint64_t w = (uint64_t)((uint16_t)(s[i].ax >> shift) & 0xFFF) |
+                       (uint64_t)((uint16_t)(s[i].ay >> shift) & 0xFFF) << 12 |
+                       (uint64_t)((uint16_t)(s[i].az >> shift) & 0xFFF) << 24;
+    memcpy(out, &w, 5);
+    out += 5;
+  }
+  return out;
+}
+
+inline void recUnpack12(const uint8_t *in, size_t n, uint8_t shift, Sample6 *s)
+{
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2)
+  {
+    const uint64_t w = recLoad64(in);
+    s[i].ax = recUnq((uint32_t)w & 0xFFF, 12, shift);
+    s[i].ay = recUnq((uint32_t)(w >> 12) & 0xFFF, 12, shift);
+    s[i].az = recUnq((uint32_t)(w >> 24) & 0xFFF, 12, shift);
+    s[i + 1].ax = recUnq((uint32_t)(w >> 36) & 0xFFF, 12, shift);
+    s[i + 1].ay = recUnq((uint32_t)(w >> 48) & 0xFFF, 12, shift);
+    s[i + 1].az = recUnq((uint32_t)(w >> 60) | ((uint32_t)in[8] << 4), 12, shift);
+    in += 9;
+  }
+  if (i < n)
+  {
+    uint64_t w = 0;
+    memcpy(&w, in, 5);
+    s[i].ax = recUnq((uint32_t)w & 0xFFF, 12, shift);
+    s[i].ay = recUnq((uint32_t)(w >> 12) & 0xFFF, 12, shift);
+    s[i].az = recUnq((uint32_t)(w >> 24) & 0xFFF, 12, shift);
+  }
+}
+
+// ---- 10 bit ----
+inline uint8_t *recPack10(const Sample6 *s, size_t n, uint8_t shift, uint8_t *out)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    const uint32_t w = ((uint32_t)(uint16_t)(s[i].ax >> shift) & 0x3FF) |
+                       ((uint32_t)(uint16_t)(s[i].ay >> shift) & 0x3FF) << 10 |
+                       ((uint32_t)(uint16_t)(s[i].az >> shift) & 0x3FF) << 20;
+    memcpy(out, &w, 4);
+    out += 4;
+  }
+  return out;
+}
+
+inline void recUnpack10(const uint8_t *in, size_t n, uint8_t shift, Sample6 *s)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    uint32_t w;
+    memcpy(&w, in, 4);
+    s[i].ax = recUnq(w & 0x3FF, 10, shift);
+    s[i].ay = recUnq((w >> 10) & 0x3FF, 10, shift);
+    s[i].az = recUnq((w >> 20) & 0x3FF, 10, shift);
+    in += 4;
+  }
+}
+
+// ---- dispatch ----
+// Whole block incl. RecBlockHdrV4; out must hold recV4MaxBlockBytes(n).
+// Packed codecs expect samples already quantised (low shift bits zero).
+inline size_t recEncodeBlock(uint8_t codec, uint8_t shift, const Sample6 *s, size_t n, uint8_t *out)
+{
+  if (codec == REC_CODEC_DELTA_RICE)
+    return recEncodeBlockV4(s, n, out);
+
+  uint8_t *p = out + sizeof(RecBlockHdrV4);
+  p = (codec == REC_CODEC_PACK10) ? recPack10(s, n, shift, p) : recPack12(s, n, shift, p);
+  RecBlockHdrV4 bh;
+  bh.sync = REC_V4_SYNC;
+  bh.n = (uint16_t)n;
+  bh.bytes = (uint16_t)(p - out - sizeof(RecBlockHdrV4));
+  memcpy(out, &bh, sizeof(bh));
+  return (size_t)(p - out);
+}
+
+// Payload only (after RecBlockHdrV4); n from that header.
+inline bool recDecodeBlock(uint8_t codec, uint8_t shift, const uint8_t *payload, size_t bytes, size_t n, Sample6 *out)
+{
+  if (codec == REC_CODEC_DELTA_RICE)
+    return recDecodeBlockV4(payload, bytes, n, out);
+  if (bytes != recPackedBytes(codec, n))
+    return false;
+  if (codec == REC_CODEC_PACK10)
+    recUnpack10(payload, n, shift, out);
+  else
+    recUnpack12(payload, n, shift, out);
+  return true;
+}
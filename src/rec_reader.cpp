@@ -0,0 +1,350 @@
+#include "rec_reader.h"
+
+#include "rec_pack.h"
+#include "rec_writer.h"
+
+bool RecReader::open(const String &path)
+{
+  close();
+  _path = path;
+  _pinned = recReadPin(path);
+  _f = LittleFS.open(path, "r");
+  if (!_f)
+  {
+    _err = "Open failed";
+    return false;
+  }
+  _fileBytes = _f.size();
+
+  if (_fileBytes < sizeof(FileHeaderV3) || _f.read((uint8_t *)&_h.v3, sizeof(FileHeaderV3)) != sizeof(FileHeaderV3))
+  {
+    _err = "Read header failed";
+    close();
+    return false;
+  }
+  if (!recHeaderOk(_h.v3))
+  {
+    _err = "Bad magic";
+    close();
+    return false;
+  }
+
+  const uint32_t hdrBytes = recHeaderBytes(_h.v3.version);
+  if (_h.v3.version == 4)
+  {
+    const size_t tail = sizeof(FileHeaderV4) - sizeof(FileHeaderV3);
+    if (_f.read((uint8_t *)&_h + sizeof(FileHeaderV3), tail) != tail || !recCodecOk(_h.codec))
+    {
+      _err = "Bad V4 header";
+      close();
+      return false;
+    }
+    _blk = (Sample6 *)malloc(REC_V4_BLOCK_MAX * sizeof(Sample6));
+    _enc = (uint8_t *)malloc(recV4MaxBlockBytes(REC_V4_BLOCK_MAX));
+    if (!_blk || !_enc)
+    {
+      _err = "OOM";
+      close();
+      return false;
+    }
+  }
+
+  // trailer: index footer + chunks (index entries are only read by ensureIndex)
+  _tr = recScanTrailer(_fileBytes, hdrBytes, [this](uint32_t off, void *dst, size_t len)
+                       { return _f.seek(off, SeekSet) && _f.read((uint8_t *)dst, len) == len; });
+  _dataEnd = _tr.dataEnd;
+  _trailer = _tr.indexed;
+  _ft = _tr.index;
+  _f.seek(hdrBytes, SeekSet);
+
+  if (_h.v3.version == 4)
+  {
+    // no size-based bound for compressed data: 0 while still recording,
+    // fixed at close or by the boot-time repair
+    _samples = _h.v3.samples;
+  }
+  else
+  {
+    // gerçek sample sayısını dosya boyutuna göre limitliyoruz
+    const uint32_t maxPossible = (_dataEnd > hdrBytes) ? (_dataEnd - hdrBytes) / sizeof(Sample6) : 0;
+    _samples = _h.v3.samples;
+    if (_samples == 0 || _samples > maxPossible)
+      _samples = maxPossible;
+  }
+  _pos = 0;
+  return true;
+}
+
+void RecReader::close()
+{
+  if (_f)
+    _f.close();
+  if (_pinned)
+    recReadUnpin(_path);
+  _pinned = false;
+  free(_blk);
+  free(_enc);
+  free(_idx);
+  _blk = nullptr;
+  _enc = nullptr;
+  _idx = nullptr;
+  _idxN = 0;
+  _blkN = _blkPos = 0;
+}
+
+float RecReader::ratio() const
+{
+  const uint32_t hdrBytes = recHeaderBytes(_h.v3.version);
+  if (_dataEnd <= hdrBytes || _h.v3.version != 4)
+    return 1.0f;
+  return (float)_h.v3.samples * sizeof(Sample6) / (float)(_dataEnd - hdrBytes);
+}
+
+bool RecReader::rewind()
+{
+  _pos = 0;
+  _blkN = _blkPos = 0;
+  return _f.seek(recHeaderBytes(_h.v3.version), SeekSet);
+}
+
+bool RecReader::nextBlock()
+{
+  RecBlockHdrV4 bh;
+  if (_f.position() + sizeof(bh) > _dataEnd)
+    return false;
+  if (_f.read((uint8_t *)&bh, sizeof(bh)) != sizeof(bh))
+    return false;
+  if (bh.sync != REC_V4_SYNC || bh.n == 0 || bh.n > REC_V4_BLOCK_MAX ||
+      bh.bytes > recV4MaxBlockBytes(bh.n))
+    return false;
+  if (_f.read(_enc, bh.bytes) != bh.bytes)
+    return false;
+  if (!recDecodeBlock(_h.codec, recQuantShift(_h.v3), _enc, bh.bytes, bh.n, _blk))
+    return false;
+  _blkN = bh.n;
+  _blkPos = 0;
+  return true;
+}
+
+size_t RecReader::read(Sample6 *out, size_t max)
+{
+  if (!_f)
+    return 0;
+  if (max > _samples - _pos)
+    max = _samples - _pos;
+
+  if (_h.v3.version != 4)
+  {
+    size_t got = _f.read((uint8_t *)out, max * sizeof(Sample6)) / sizeof(Sample6);
+    _pos += got;
+    return got;
+  }
+
+  size_t got = 0;
+  while (got < max)
+  {
+    if (_blkPos == _blkN && !nextBlock())
+    {
+      _samples = _pos; // truncated / corrupt: stop here
+      break;
+    }
+    size_t take = _blkN - _blkPos;
+    if (take > max - got)
+      take = max - got;
+    memcpy(out + got, _blk + _blkPos, take * sizeof(Sample6));
+    _blkPos += take;
+    _pos += take;
+    got += take;
+  }
+  return got;
+}
+
+// ======================= Block index =======================
+bool RecReader::loadIndex()
+{
+  _idx = (RecIndexEntry *)malloc(_ft.entries * sizeof(RecIndexEntry));
+  if (!_idx)
+    return false;
+  const size_t bytes = _ft.entries * sizeof(RecIndexEntry);
+  _f.seek(_ft.indexOffset, SeekSet);
+  bool ok = _f.read((uint8_t *)_idx, bytes) == bytes && recCrc32(0, _idx, bytes) == _ft.crc;
+  if (!ok)
+  {
+    free(_idx);
+    _idx = nullptr;
+    return false;
+  }
+  _idxN = _ft.entries;
+  return true;
+}
+
+// One pass over the stored bytes, same entries the writer would have made.
+bool RecReader::buildIndex()
+{
+  const uint32_t cap = recIndexEntriesFor(_samples);
+  _idx = (RecIndexEntry *)malloc(cap * sizeof(RecIndexEntry));
+  if (!_idx)
+    return false;
+  _idxN = 0;
+  rewind();
+
+  const bool v4 = (_h.v3.version == 4);
+  static Sample6 raw[REC_V4_BLOCK_MAX]; // V3 chunk buffer
+  RecIndexEntry cur;
+  cur.n = 0;
+  uint32_t done = 0;
+  uint32_t steps = 0;
+  bool ok = true;
+
+  while (done < _samples && ok)
+  {
+    if (cur.n == 0)
+      recIndexBegin(cur, _f.position());
+
+    if (v4)
+    {
+      const uint32_t at = _f.position();
+      ok = nextBlock();
+      if (ok)
+      {
+        // CRC covers the stored block: header + payload, re-read from RAM
+        RecBlockHdrV4 bh;
+        bh.sync = REC_V4_SYNC;
+        bh.n = _blkN;
+        bh.bytes = (uint16_t)(_f.position() - at - sizeof(bh));
+        cur.crc = recCrc32(cur.crc, &bh, sizeof(bh));
+        cur.crc = recCrc32(cur.crc, _enc, bh.bytes);
+        recIndexAdd(cur, _blk, _blkN);
+        done += _blkN;
+        _blkPos = _blkN;
+      }
+    }
+    else
+    {
+      size_t want = REC_INDEX_N - cur.n;
+      if (want > REC_V4_BLOCK_MAX)
+        want = REC_V4_BLOCK_MAX;
+      if (want > _samples - done)
+        want = _samples - done;
+      size_t got = _f.read((uint8_t *)raw, want * sizeof(Sample6)) / sizeof(Sample6);
+      ok = (got == want);
+      cur.crc = recCrc32(cur.crc, raw, got * sizeof(Sample6));
+      recIndexAdd(cur, raw, got);
+      done += got;
+    }
+
+    if (cur.n >= REC_INDEX_N || (done >= _samples && cur.n))
+    {
+      if (_idxN < cap)
+        _idx[_idxN++] = cur;
+      cur.n = 0;
+    }
+    if ((++steps & 0x3F) == 0)
+      delay(0); // watchdog friendly
+  }
+
+  if (!ok || done != _samples)
+  {
+    free(_idx);
+    _idx = nullptr;
+    _idxN = 0;
+    return false;
+  }
+  return true;
+}
+
+bool RecReader::ensureIndex()
+{
+  if (_idx)
+    return rewind();
+  if (_trailer)
+  {
+    bool ok = loadIndex();
+    rewind();
+    if (ok)
+      return true;
+    // damaged trailer: leave the file alone, build in RAM only
+    bool built = buildIndex();
+    rewind();
+    return built;
+  }
+  // only closed recordings: an open one still has samples == 0 on flash
+  if (_h.v3.samples == 0 || _samples == 0)
+    return false;
+  if (!buildIndex())
+  {
+    rewind();
+    return false;
+  }
+
+  // persist: append trailer (after any chunks), then reopen for reading
+  const uint32_t at = _fileBytes;
+  _f.close();
+  File af = LittleFS.open(_path, "a");
+  if (af)
+  {
+    RecIndexFooter ft;
+    recIndexFooter(ft, _idx, _idxN, at);
+    const size_t bytes = _idxN * sizeof(RecIndexEntry);
+    bool ok = af.write((const uint8_t *)_idx, bytes) == bytes &&
+              af.write((const uint8_t *)&ft, sizeof(ft)) == sizeof(ft);
+    af.close();
+    if (ok)
+    {
+      _ft = ft;
+      _trailer = true;
+      _fileBytes = at + bytes + sizeof(ft);
+    }
+  }
+  _f = LittleFS.open(_path, "r");
+  if (!_f)
+    return false;
+  return rewind();
+}
+
+bool RecReader::seekSample(uint32_t s)
+{
+  if (s > _samples)
+    return false;
+  if (_h.v3.version != 4)
+  {
+    _pos = s;
+    return _f.seek(recHeaderBytes(_h.v3.version) + s * sizeof(Sample6), SeekSet);
+  }
+
+  if (!_idx && !ensureIndex())
+    return false;
+  uint32_t e = 0, first = 0;
+  while (e + 1 < _idxN && first + _idx[e].n <= s)
+    first += _idx[e++].n;
+  if (!_idxN || !_f.seek(_idx[e].offset, SeekSet))
+    return false;
+  _pos = first;
+  _blkN = _blkPos = 0;
+
+  // skip inside the index block (at most REC_INDEX_N / block_n decodes)
+  while (_pos < s)
+  {
+    if (_blkPos == _blkN && !nextBlock())
+      return false;
+    uint32_t take = _blkN - _blkPos;
+    if (take > s - _pos)
+      take = s - _pos;
+    _blkPos += take;
+    _pos += take;
+  }
+  return true;
+}
+
+// ======================= Trailer chunks =======================
+bool RecReader::readChunk(const char type[4], void *dst, size_t len)
+{
+  int i = _tr.find(type);
+  if (i < 0 || _tr.chunk[i].bytes != len)
+    return false;
+  const uint32_t pos = _f.position();
+  bool ok = _f.seek(_tr.chunk[i].offset, SeekSet) && _f.read((uint8_t *)dst, len) == len &&
+            recCrc32(0, dst, len) == _tr.chunk[i].crc;
+  _f.seek(pos, SeekSet);
+  return ok;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "rec_features.h"
+#include "rec_format.h"
+#include "rec_index.h"
+#include "rec_trailer.h"
+
+// Sequential sample reader over V3 (raw Sample6) and V4 (compressed blocks)
+// recordings, so analyze / FFT / CSV do not care which format is on flash.
+// Also owns the trailing block index: loads it, or builds and appends it on
+// first use for files that have none.
+class RecReader
+{
+public:
+  ~RecReader() { close(); }
+
+  // false: open failed / not a recording (see error()).
+  bool open(const String &path);
+  void close();
+
+  const FileHeaderV3 &header() const { return _h.v3; }
+  uint16_t version() const { return _h.v3.version; }
+  const char *error() const { return _err; }
+
+  // Samples in the file: header count, capped by what V3 data can hold.
+  uint32_t samples() const { return _samples; }
+  uint32_t fileBytes() const { return _fileBytes; }
+  // Raw Sample6 bytes / stored sample bytes (1.0 for V3).
+  float ratio() const;
+
+  // Next samples in order; 0 at end of data or on a corrupt V4 block.
+  size_t read(Sample6 *out, size_t max);
+
+  // ---- block index ----
+  bool hasIndexTrailer() const { return _trailer; }
+  // Loads the index into RAM; builds and appends it first if the file has
+  // none (closed recordings only). Leaves the read position at sample 0.
+  bool ensureIndex();
+  uint32_t indexEntries() const { return _idxN; }
+  const RecIndexEntry *index() const { return _idx; }
+  // Positions read() at sample s (index needed for V4).
+  bool seekSample(uint32_t s);
+
+  // ---- trailer chunks (rec_trailer.h) ----
+  // Payload of chunk type, CRC checked; false if absent or a different size.
+  // Keeps the read position.
+  bool readChunk(const char type[4], void *dst, size_t len);
+  bool health(RecHealth &h) { return readChunk("HLTH", &h, sizeof(h)); }
+  bool features(RecFeatures &f) { return readChunk("FEAT", &f, sizeof(f)); }
+
+private:
+  bool nextBlock();
+  bool rewind();
+  bool loadIndex();
+  bool buildIndex();
+
+  String _path;
+  bool _pinned = false; // retention keeps its hands off while open
+  File _f;
+  FileHeaderV4 _h{};
+  uint32_t _samples = 0;
+  uint32_t _fileBytes = 0;
+  uint32_t _dataEnd = 0; // first byte after sample data (index trailer or EOF)
+  uint32_t _pos = 0;     // samples handed out so far
+  const char *_err = "";
+
+  // V4 only
+  Sample6 *_blk = nullptr;
+  uint8_t *_enc = nullptr;
+  uint16_t _blkN = 0;
+  uint16_t _blkPos = 0;
+
+  RecTrailer _tr;
+  bool _trailer = false;
+  RecIndexFooter _ft{};
+  RecIndexEntry *_idx = nullptr;
+  uint32_t _idxN = 0;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+// Trailer chunks: small records appended after the sample data, next to the
+// block index (rec_index.h). Each chunk is
+//   payload | RecChunkTail
+// and readers peel chunks and the index off the end of the file in any
+// order; whatever is left in front of them is sample data.
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rec_index.h"
+
+#pragma pack(push, 1)
+struct RecChunkTail
+{
+  uint32_t bytes; // payload size
+  uint32_t crc;   // CRC32 of the payload
+  char type[4];   // e.g. "HLTH"
+  char magic[4];  // "LISC"
+};
+
+// "HLTH": acquisition health of the session (of the segment, when rotating).
+static const size_t REC_JITTER_BINS = 16;
+struct RecHealth
+{
+  uint32_t i2cErrors;    // failed FIFO status / burst reads
+  uint32_t skippedTicks; // wake-ups that never came (acqWait timeouts)
+  uint32_t duplicates;   // repeated sample at a burst boundary, STATUS.DRDY clear
+  uint32_t fifoOverruns; // FIFO full: oldest samples overwritten
+  uint32_t ringDropped;  // blocks the writer / sender had no room for
+  uint32_t wakeups;      // intervals in the histogram
+  uint32_t periodUs;     // expected wake-up interval
+  uint32_t jitterMaxUs;  // worst |interval - periodUs|
+  uint32_t jitter[REC_JITTER_BINS]; // bin 0: < 1 us, bin b: [2^(b-1), 2^b) us, last: open
+};
+#pragma pack(pop)
+
+inline void recHealthAddJitter(RecHealth &h, uint32_t devUs)
+{
+  uint32_t bin = 0;
+  while (devUs >> bin && bin < REC_JITTER_BINS - 1)
+    bin++;
+  h.jitter[bin]++;
+  h.wakeups++;
+  if (devUs > h.jitterMaxUs)
+    h.jitterMaxUs = devUs;
+}
+
+// a - b for counters and histogram (max/period taken from a).
+inline RecHealth recHealthSince(const RecHealth &a, const RecHealth &b)
+{
+  RecHealth d = a;
+  d.i2cErrors -= b.i2cErrors;
+  d.skippedTicks -= b.skippedTicks;
+  d.duplicates -= b.duplicates;
+  d.fifoOverruns -= b.fifoOverruns;
+  d.ringDropped -= b.ringDropped;
+  d.wakeups -= b.wakeups;
+  for (size_t i = 0; i < REC_JITTER_BINS; i++)
+    d.jitter[i] -= b.jitter[i];
+  return d;
+}
+
+inline void recChunkTail(RecChunkTail &t, const char type[4], const void *payload, uint32_t bytes)
+{
+  t.bytes = bytes;
+  t.crc = recCrc32(0, payload, bytes);
+  memcpy(t.type, type, 4);
+  memcpy(t.magic, "LISC", 4);
+}
+
+// ---- scanning ----
+static const size_t REC_TRAILER_MAX_CHUNKS = 4;
+
+struct RecTrailer
+{
+  uint32_t dataEnd = 0; // first byte after sample data
+  bool indexed = false;
+  RecIndexFooter index{};
+  uint8_t chunks = 0;
+  struct
+  {
+    char type[4];
+    uint32_t offset; // payload
+    uint32_t bytes;
+    uint32_t crc;
+  } chunk[REC_TRAILER_MAX_CHUNKS];
+
+  int find(const char type[4]) const
+  {
+    for (uint8_t i = 0; i < chunks; i++)
+      if (memcmp(chunk[i].type, type, 4) == 0)
+        return i;
+    return -1;
+  }
+};
+
+// readAt(offset, dst, len) -> bool. Never goes below hdrBytes.
+template <class ReadAt>
+RecTrailer recScanTrailer(uint32_t fileBytes, uint32_t hdrBytes, ReadAt readAt)
+{
+  RecTrailer tr;
+  uint32_t end = fileBytes;
+  for (;;)
+  {
+    RecChunkTail t;
+    if (tr.chunks < REC_TRAILER_MAX_CHUNKS && end >= hdrBytes + sizeof(t) &&
+        readAt(end - sizeof(t), &t, sizeof(t)) && memcmp(t.magic, "LISC", 4) == 0 &&
+        t.bytes <= end - hdrBytes - sizeof(t))
+    {
+      auto &c = tr.chunk[tr.chunks++];
+      memcpy(c.type, t.type, 4);
+      c.bytes = t.bytes;
+      c.crc = t.crc;
+      c.offset = end - sizeof(t) - t.bytes;
+      end = c.offset;
+      continue;
+    }
+    RecIndexFooter ft;
+    if (!tr.indexed && end >= hdrBytes + sizeof(ft) && readAt(end - sizeof(ft), &ft, sizeof(ft)) &&
+        recIndexFooterOk(ft, end) && ft.indexOffset >= hdrBytes)
+    {
+      tr.indexed = true;
+      tr.index = ft;
+      end = ft.indexOffset;
+      continue;
+    }
+    break;
+  }
+  tr.dataEnd = end;
+  return tr;
+}
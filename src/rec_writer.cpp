@@ -0,0 +1,931 @@
+#include "rec_writer.h"
+
+#include <LittleFS.h>
+#include <new>
+
+#include "decimator.h"
+#include "rec_features.h"
+#include "rec_pack.h"
+#include "rec_index.h"
+#include "rec_trailer.h"
+
+static RecRing s_ring;
+static TaskHandle_t s_task = nullptr;
+static SemaphoreHandle_t s_done = nullptr;
+static File s_file;
+static FileHeaderV4 s_hdr;
+static uint32_t s_hdrBytes = 0;
+static volatile bool s_producerDone = false;
+static volatile bool s_failed = false;
+static uint64_t s_written = 0; // all segments: may pass 2^32 in a continuous session
+
+// Staging buffer = one LittleFS block. The header sits at the front of the
+// first one, so every flash write after it starts on a block boundary.
+static uint8_t s_stage[REC_FS_BLOCK];
+static size_t s_stageFill = 0;
+static uint32_t s_stageSamples = 0; // samples whose last byte sits in s_stage
+static uint32_t s_busyUs = 0;       // time spent inside write()/flush()
+static uint8_t s_enc[recV4MaxBlockBytes(REC_BLOCK_N)];
+static uint32_t s_fileOffset = 0; // bytes staged so far, header included
+
+// Block index, appended as the file trailer at close.
+static RecIndexEntry *s_index = nullptr;
+static uint32_t s_indexCap = 0;
+static uint32_t s_indexCount = 0;
+static RecIndexEntry s_cur;
+
+// Segments (continuous mode)
+static RecSegmentPlan s_plan;
+static uint32_t s_segNo = 0;
+static uint64_t s_segStart = 0; // s_written when the current segment opened
+static RecHealth s_healthAtOpen;  // g_health when the current segment opened
+static RecFeatures s_feat;        // features of the current segment's stored samples
+static uint64_t s_expect = 0;   // capture index the next block should start at
+static bool s_segFresh = false; // next block is the first after a rotation
+static char s_path[48] = "";
+static portMUX_TYPE s_pathMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Decimated streams. Companion files run at <= half rate, so a small
+// stage per file is enough.
+static const size_t REC_SIDE_STAGE = 1024;
+struct RecSide
+{
+  RecDecimator dec;
+  File file;
+  FileHeaderV3 hdr;
+  uint32_t samples = 0; // appended so far (header keeps 0 until close)
+  size_t fill = 0;
+  uint8_t stage[REC_SIDE_STAGE];
+};
+static RecSide *s_side[sizeof(DECIM_FACTORS)] = {};
+static uint8_t s_sideN = 0;
+static RecDecimator s_mainDec; // factor() 0: main file at full rate
+static RecBlock s_decBlock;    // main file: decimated block being filled
+static uint64_t s_decFirst = 0;
+static Sample6 s_decOut[REC_BLOCK_N / 2 + 1];
+static int16_t s_decMask = -1; // stored streams keep the session's q_bits
+
+// ======================= Flash I/O =======================
+static void noteLatency(uint32_t dt)
+{
+  s_busyUs += dt;
+  if (dt > g_wrMaxUs)
+    g_wrMaxUs = dt;
+  if (dt > REC_STALL_US)
+  {
+    g_wrStalls++;
+    g_wrStallMs += dt / 1000;
+  }
+  if (s_busyUs)
+    g_wrBps = (uint32_t)((uint64_t)g_wrBytes * 1000000ULL / s_busyUs);
+}
+
+static bool flushStage()
+{
+  if (!s_stageFill)
+    return true;
+  uint32_t t0 = micros();
+  size_t wrote = s_file.write(s_stage, s_stageFill);
+  noteLatency(micros() - t0);
+  if (wrote != s_stageFill)
+    return false;
+  g_wrBytes += wrote;
+  s_written += s_stageSamples;
+  g_samplesWritten = s_written > UINT32_MAX ? UINT32_MAX : (uint32_t)s_written;
+  s_stageFill = 0;
+  s_stageSamples = 0;
+  return true;
+}
+
+static bool stageBytes(const uint8_t *src, size_t left)
+{
+  while (left)
+  {
+    size_t room = REC_FS_BLOCK - s_stageFill;
+    size_t n = left < room ? left : room;
+    memcpy(s_stage + s_stageFill, src, n);
+    s_stageFill += n;
+    s_fileOffset += n;
+    src += n;
+    left -= n;
+    if (s_stageFill == REC_FS_BLOCK && !flushStage())
+      return false;
+  }
+  return true;
+}
+
+// V3: raw Sample6. V4: one encoded block (Rice or packed) per RecBlock.
+// A block straddling a stage boundary counts as written once all of it is.
+static void indexPush()
+{
+  if (s_cur.n && s_index)
+  {
+    if (s_indexCount < s_indexCap)
+    {
+      s_index[s_indexCount++] = s_cur;
+    }
+    else
+    {
+      // longer than planned: a partial index would lie, so write none
+      free(s_index);
+      s_index = nullptr;
+    }
+  }
+  s_cur.n = 0;
+}
+
+static bool stageBlock(const RecBlock &b)
+{
+  // a gap right after a rotation means samples were lost at the boundary
+  if (s_segFresh && b.first != s_expect)
+    g_segDropped += (uint32_t)(b.first - s_expect);
+  s_segFresh = false;
+  s_expect = b.first + b.n;
+
+  g_wrRawBytes += b.n * sizeof(Sample6);
+  if (s_cur.n == 0)
+    recIndexBegin(s_cur, s_fileOffset);
+
+  const uint8_t *bytes = (const uint8_t *)b.s;
+  size_t len = b.n * sizeof(Sample6);
+  if (s_hdr.v3.version == 4)
+  {
+    uint32_t t0 = micros();
+    len = recEncodeBlock(s_hdr.codec, recQuantShift(s_hdr.v3), b.s, b.n, s_enc);
+    uint32_t dt = micros() - t0;
+    if (dt > g_encMaxUs)
+      g_encMaxUs = dt;
+    bytes = s_enc;
+  }
+  s_cur.crc = recCrc32(s_cur.crc, bytes, len);
+  recIndexAdd(s_cur, b.s, b.n);
+  recFeaturesAdd(s_feat, b.s, b.n);
+  if (s_cur.n >= REC_INDEX_N)
+    indexPush();
+
+  bool ok = stageBytes(bytes, len);
+  s_stageSamples += b.n;
+  return ok;
+}
+
+// Acquisition health of this file as a trailer chunk.
+static bool stageHealth()
+{
+  RecHealth h = recHealthSince(g_health, s_healthAtOpen);
+  RecChunkTail t;
+  recChunkTail(t, "HLTH", &h, sizeof(h));
+  return stageBytes((const uint8_t *)&h, sizeof(h)) && stageBytes((const uint8_t *)&t, sizeof(t));
+}
+
+// Features of the stored samples (rec_features.h) as a trailer chunk.
+static bool stageFeatures()
+{
+  if (!s_feat.n)
+    return true;
+  RecChunkTail t;
+  recChunkTail(t, "FEAT", &s_feat, sizeof(s_feat));
+  return stageBytes((const uint8_t *)&s_feat, sizeof(s_feat)) && stageBytes((const uint8_t *)&t, sizeof(t));
+}
+
+// Entries + footer go through the stage like sample data.
+static bool stageIndex()
+{
+  indexPush();
+  if (!s_index || !s_indexCount)
+    return true;
+  RecIndexFooter ft;
+  recIndexFooter(ft, s_index, s_indexCount, s_fileOffset);
+  return stageBytes((const uint8_t *)s_index, s_indexCount * sizeof(RecIndexEntry)) &&
+         stageBytes((const uint8_t *)&ft, sizeof(ft));
+}
+
+// Makes everything written so far survive a power cut: LittleFS only
+// persists file size/data on sync. Header samples stays 0 until close;
+// recRepairInterrupted() recovers the count from the synced size.
+static void commitFile()
+{
+  uint32_t t0 = micros();
+  s_file.flush();
+  for (uint8_t i = 0; i < s_sideN; i++)
+    s_side[i]->file.flush();
+  noteLatency(micros() - t0);
+}
+
+static void setPath(const String &path)
+{
+  portENTER_CRITICAL(&s_pathMux);
+  snprintf(s_path, sizeof(s_path), "%s", path.c_str());
+  portEXIT_CRITICAL(&s_pathMux);
+}
+
+// Header goes to the front of the (empty) stage; written with the first block.
+static bool openFile(const String &path)
+{
+  s_file = LittleFS.open(path, "w");
+  if (!s_file)
+    return false;
+  setPath(path);
+  s_hdr.v3.samples = 0; // 0 on flash = not closed cleanly
+  memcpy(s_stage, &s_hdr, s_hdrBytes);
+  s_stageFill = s_hdrBytes;
+  s_fileOffset = s_hdrBytes;
+  s_stageSamples = 0;
+  s_segStart = s_written;
+  s_healthAtOpen = g_health;
+  recFeaturesBegin(s_feat, s_hdr.v3.res_bits, recQuantShift(s_hdr.v3));
+  s_indexCount = 0;
+  s_cur.n = 0;
+  return true;
+}
+
+static bool closeFile()
+{
+  bool ok = flushStage(); // all samples on flash before the trailer
+  if (ok && !s_failed)
+    ok = stageIndex() && stageHealth() && stageFeatures() && flushStage();
+  s_hdr.v3.samples = (uint32_t)(s_written - s_segStart);
+  if (ok)
+  {
+    s_file.seek(0, SeekSet);
+    ok = s_file.write((const uint8_t *)&s_hdr, s_hdrBytes) == s_hdrBytes;
+  }
+  s_file.close();
+  return ok;
+}
+
+// ======================= Segments =======================
+static bool rotationDue()
+{
+  if (!s_plan.path)
+    return false;
+  const uint64_t segSamples = s_written + s_stageSamples - s_segStart;
+  if (s_plan.samples && segSamples >= s_plan.samples)
+    return true;
+  return s_plan.bytes && s_fileOffset >= s_plan.bytes;
+}
+
+// Runs between two ring blocks; the producer keeps filling the ring meanwhile.
+static bool rotate(uint64_t firstSample)
+{
+  uint32_t t0 = micros();
+  if (!closeFile())
+    return false;
+  s_segNo++;
+  bool ok = openFile(s_plan.path(s_segNo, firstSample));
+  uint32_t dt = micros() - t0;
+  g_segSwitchLastUs = dt;
+  if (dt > g_segSwitchMaxUs)
+    g_segSwitchMaxUs = dt;
+  g_segCount = s_segNo + 1;
+  s_segFresh = true;
+  recRetentionKick();
+  return ok;
+}
+
+// ======================= Decimation =======================
+String recDecimPath(const String &mainPath, uint8_t factor)
+{
+  String base = mainPath.endsWith(".dat") ? mainPath.substring(0, mainPath.length() - 4) : mainPath;
+  return base + "_d" + String(factor) + ".dat";
+}
+
+static void quantise(Sample6 *s, size_t n)
+{
+  if (s_decMask == -1)
+    return;
+  int16_t *v = &s->ax;
+  for (size_t i = 0; i < n * 3; i++)
+    v[i] &= s_decMask;
+}
+
+// Main file at a decimated rate: outputs are regrouped into whole blocks so
+// index, codecs and V4 block size work unchanged.
+static bool mainAppend(const Sample6 *s, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    if (s_decBlock.n == 0)
+      s_decBlock.first = s_decFirst;
+    s_decBlock.s[s_decBlock.n++] = s[i];
+    if (s_decBlock.n == REC_BLOCK_N)
+    {
+      s_decFirst += REC_BLOCK_N;
+      if (!stageBlock(s_decBlock))
+        return false;
+      s_decBlock.n = 0;
+    }
+  }
+  return true;
+}
+
+static bool sideFlush(RecSide &sd)
+{
+  if (!sd.fill)
+    return true;
+  uint32_t t0 = micros();
+  size_t wrote = sd.file.write(sd.stage, sd.fill);
+  noteLatency(micros() - t0);
+  g_wrBytes += wrote;
+  const bool ok = wrote == sd.fill;
+  sd.fill = 0;
+  return ok;
+}
+
+static bool sideAppend(RecSide &sd, const Sample6 *s, size_t n)
+{
+  const uint8_t *src = (const uint8_t *)s;
+  size_t left = n * sizeof(Sample6);
+  while (left)
+  {
+    size_t room = REC_SIDE_STAGE - sd.fill;
+    size_t k = left < room ? left : room;
+    memcpy(sd.stage + sd.fill, src, k);
+    sd.fill += k;
+    src += k;
+    left -= k;
+    if (sd.fill == REC_SIDE_STAGE && !sideFlush(sd))
+      return false;
+  }
+  sd.samples += n;
+  return true;
+}
+
+static bool openSides(const String &path, const RecDecimPlan &dec)
+{
+  for (uint8_t f : DECIM_FACTORS)
+  {
+    if (!(dec.sides & f))
+      continue;
+    RecSide *sd = new (std::nothrow) RecSide;
+    if (!sd)
+      return false;
+    s_side[s_sideN++] = sd;
+    if (!sd->dec.begin(f))
+      return false;
+    sd->hdr = s_hdr.v3;
+    sd->hdr.version = 3;
+    sd->hdr.rate_hz = dec.inRateHz / f;
+    sd->hdr.samples = 0; // 0 on flash = not closed cleanly, like the main file
+    sd->file = LittleFS.open(recDecimPath(path, f), "w");
+    if (!sd->file || sd->file.write((const uint8_t *)&sd->hdr, sizeof(sd->hdr)) != sizeof(sd->hdr))
+      return false;
+  }
+  return true;
+}
+
+// drain: push out the samples held back by the filter delay first.
+static void closeSides(bool drain)
+{
+  for (uint8_t i = 0; i < s_sideN; i++)
+  {
+    RecSide &sd = *s_side[i];
+    if (sd.file)
+    {
+      bool ok = true;
+      if (drain)
+      {
+        size_t k = sd.dec.flush(s_decOut);
+        quantise(s_decOut, k);
+        ok = sideAppend(sd, s_decOut, k);
+      }
+      ok = sideFlush(sd) && ok;
+      if (ok && drain)
+      {
+        sd.hdr.samples = sd.samples;
+        sd.file.seek(0, SeekSet);
+        sd.file.write((const uint8_t *)&sd.hdr, sizeof(sd.hdr));
+      }
+      sd.file.close();
+    }
+    delete s_side[i];
+    s_side[i] = nullptr;
+  }
+  s_sideN = 0;
+}
+
+static bool finishMainDecimated()
+{
+  size_t k = s_mainDec.flush(s_decOut);
+  quantise(s_decOut, k);
+  if (!mainAppend(s_decOut, k))
+    return false;
+  if (s_decBlock.n && !stageBlock(s_decBlock))
+    return false;
+  s_decBlock.n = 0;
+  return true;
+}
+
+// One ring block through every decimator, then to its files. Only the
+// filter time counts as decimation cost, flash writes are accounted as
+// usual.
+static bool stageInput(const RecBlock &b)
+{
+  if (!s_sideN && !s_mainDec.factor())
+    return stageBlock(b);
+
+  uint32_t busy = 0;
+  bool ok = true;
+  for (uint8_t i = 0; ok && i < s_sideN; i++)
+  {
+    uint32_t t0 = micros();
+    size_t k = s_side[i]->dec.push(b.s, b.n, s_decOut);
+    quantise(s_decOut, k);
+    busy += micros() - t0;
+    ok = sideAppend(*s_side[i], s_decOut, k);
+  }
+  if (ok && s_mainDec.factor())
+  {
+    uint32_t t0 = micros();
+    size_t k = s_mainDec.push(b.s, b.n, s_decOut);
+    quantise(s_decOut, k);
+    busy += micros() - t0;
+    ok = mainAppend(s_decOut, k);
+  }
+  else if (ok)
+  {
+    ok = stageBlock(b);
+  }
+  g_decBusyUs += busy;
+  if (busy > g_decMaxUs)
+    g_decMaxUs = busy;
+  return ok;
+}
+
+// ======================= Writer task =======================
+static void recWriterTask(void * /*arg*/)
+{
+  uint32_t lastCommit = millis();
+  for (;;)
+  {
+    RecBlock *b = s_ring.acquireRead();
+    if (!b)
+    {
+      // producer publishes its last block before raising the flag
+      if (s_producerDone && s_ring.empty())
+        break;
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+      continue;
+    }
+
+    if (!s_failed && rotationDue())
+    {
+      if (!rotate(b->first))
+        s_failed = true;
+      lastCommit = millis();
+    }
+    if (!s_failed && !stageInput(*b))
+      s_failed = true;
+    s_ring.releaseRead(); // after a failure: keep draining so the producer never blocks
+    g_ringHighWater = s_ring.highWater();
+
+    if (!s_failed && millis() - lastCommit >= REC_COMMIT_MS)
+    {
+      commitFile();
+      lastCommit = millis();
+    }
+  }
+
+  if (s_file)
+  {
+    if (s_mainDec.factor() && !s_failed && !finishMainDecimated())
+      s_failed = true;
+    closeFile();
+  }
+  closeSides(!s_failed);
+  s_mainDec.end();
+  free(s_index);
+  s_index = nullptr;
+  xSemaphoreGive(s_done);
+  s_task = nullptr;
+  vTaskDelete(nullptr);
+}
+
+// ======================= Producer API =======================
+bool recWriterStart(const String &path, const FileHeaderV4 &h, const RecSegmentPlan *seg,
+                    const RecDecimPlan *dec)
+{
+  if (s_task || (seg && dec))
+    return false;
+  if (!s_done)
+    s_done = xSemaphoreCreateBinary();
+  if (!s_done)
+    return false;
+
+  s_plan = seg ? *seg : RecSegmentPlan();
+  if (s_plan.samples)
+    s_plan.samples = (s_plan.samples + REC_BLOCK_N - 1) / REC_BLOCK_N * REC_BLOCK_N;
+  s_hdr = h;
+  s_hdrBytes = recHeaderBytes(h.v3.version);
+  s_written = 0;
+  if (!openFile(path))
+    return false;
+
+  const uint8_t shift = recQuantShift(h.v3);
+  s_decMask = shift ? (int16_t)(0xFFFF << shift) : (int16_t)-1;
+  s_decBlock.n = 0;
+  s_decFirst = 0;
+  if (dec && ((dec->main && !s_mainDec.begin(dec->main)) || !openSides(path, *dec)))
+  {
+    closeSides(false);
+    s_mainDec.end();
+    s_file.close();
+    setPath("");
+    return false;
+  }
+
+  s_ring.reset();
+
+  // sized from the configured duration (one segment in continuous mode);
+  // without it the index is built lazily on first access instead
+  s_indexCap = recIndexEntriesFor(s_plan.samples ? s_plan.samples : (uint32_t)h.v3.rate_hz * h.v3.record_s);
+  s_index = (RecIndexEntry *)malloc(s_indexCap * sizeof(RecIndexEntry));
+  if (!s_index)
+    s_indexCap = 0;
+  s_busyUs = 0;
+  s_producerDone = false;
+  s_failed = false;
+  s_segNo = 0;
+  s_expect = 0;
+  s_segFresh = false;
+  g_ringHighWater = 0;
+  g_ringDropped = 0;
+  g_wrMaxUs = 0;
+  g_wrStalls = 0;
+  g_wrStallMs = 0;
+  g_wrBytes = 0;
+  g_wrBps = 0;
+  g_wrRawBytes = 0;
+  g_encMaxUs = 0;
+  g_segCount = 1;
+  g_segSwitchLastUs = 0;
+  g_segSwitchMaxUs = 0;
+  g_segDropped = 0;
+  g_decMaxUs = 0;
+  g_decBusyUs = 0;
+
+  // core 0: acquisition runs on the sensor service task (core 1)
+  if (xTaskCreatePinnedToCore(recWriterTask, "recwriter", 4096, nullptr, 1, &s_task, 0) != pdPASS)
+  {
+    s_file.close();
+    closeSides(false);
+    s_mainDec.end();
+    setPath("");
+    free(s_index);
+    s_index = nullptr;
+    return false;
+  }
+  return true;
+}
+
+RecBlock *recWriterAcquire()
+{
+  RecBlock *b = s_ring.acquireWrite();
+  if (b)
+    b->n = 0;
+  return b;
+}
+
+void recWriterCommit()
+{
+  s_ring.commitWrite();
+  g_ringHighWater = s_ring.highWater();
+  if (s_task)
+    xTaskNotifyGive(s_task);
+}
+
+bool recWriterFailed() { return s_failed; }
+
+uint32_t recWriterFinish()
+{
+  s_producerDone = true;
+  if (s_task)
+    xTaskNotifyGive(s_task);
+  // ring holds at most a few seconds of data; the guard only covers a hung FS
+  xSemaphoreTake(s_done, pdMS_TO_TICKS(30000));
+  return g_samplesWritten;
+}
+
+String recWriterCurrentPath()
+{
+  char p[sizeof(s_path)];
+  portENTER_CRITICAL(&s_pathMux);
+  memcpy(p, s_path, sizeof(p));
+  portEXIT_CRITICAL(&s_pathMux);
+  return String(p);
+}
+
+// ======================= Retention =======================
+static TaskHandle_t s_retTask = nullptr;
+static volatile uint32_t s_retMinFree = 0;
+
+static uint32_t fsFreeBytes()
+{
+  size_t total = LittleFS.totalBytes();
+  size_t used = LittleFS.usedBytes();
+  return (total >= used) ? (uint32_t)(total - used) : 0;
+}
+
+// Readers currently holding a file open; retention leaves them alone.
+static const uint8_t REC_PIN_MAX = 8;
+static char s_pins[REC_PIN_MAX][48];
+static uint8_t s_pinRefs[REC_PIN_MAX];
+static portMUX_TYPE s_pinMux = portMUX_INITIALIZER_UNLOCKED;
+
+bool recReadPin(const String &path)
+{
+  if (path.length() >= sizeof(s_pins[0]))
+    return false;
+  bool ok = false;
+  portENTER_CRITICAL(&s_pinMux);
+  int8_t freeSlot = -1;
+  for (uint8_t i = 0; i < REC_PIN_MAX && !ok; i++)
+  {
+    if (s_pinRefs[i] && strcmp(s_pins[i], path.c_str()) == 0)
+    {
+      s_pinRefs[i]++;
+      ok = true;
+    }
+    else if (!s_pinRefs[i] && freeSlot < 0)
+      freeSlot = i;
+  }
+  if (!ok && freeSlot >= 0)
+  {
+    strcpy(s_pins[freeSlot], path.c_str());
+    s_pinRefs[freeSlot] = 1;
+    ok = true;
+  }
+  portEXIT_CRITICAL(&s_pinMux);
+  return ok;
+}
+
+void recReadUnpin(const String &path)
+{
+  portENTER_CRITICAL(&s_pinMux);
+  for (uint8_t i = 0; i < REC_PIN_MAX; i++)
+    if (s_pinRefs[i] && strcmp(s_pins[i], path.c_str()) == 0)
+    {
+      s_pinRefs[i]--;
+      break;
+    }
+  portEXIT_CRITICAL(&s_pinMux);
+}
+
+static bool pinned(const String &path)
+{
+  bool p = false;
+  portENTER_CRITICAL(&s_pinMux);
+  for (uint8_t i = 0; i < REC_PIN_MAX && !p; i++)
+    p = s_pinRefs[i] && strcmp(s_pins[i], path.c_str()) == 0;
+  portEXIT_CRITICAL(&s_pinMux);
+  return p;
+}
+
+static const uint8_t REC_DECIM_FACTORS[] = {2, 4, 8, 16};
+
+// "/accelX_d4.dat" -> "/accelX.dat"; other names stay as they are.
+static String recordingOf(const String &name)
+{
+  const int d = name.lastIndexOf("_d");
+  const int dot = name.length() - 4;
+  if (d < 0 || d + 2 >= dot)
+    return name;
+  for (int i = d + 2; i < dot; i++)
+    if (name[i] < '0' || name[i] > '9')
+      return name;
+  return name.substring(0, d) + ".dat";
+}
+
+// A recording and its companions go together; none of them may be in use.
+static bool recordingBusy(const String &main)
+{
+  if (main == recWriterCurrentPath() || pinned(main))
+    return true;
+  for (uint8_t m : REC_DECIM_FACTORS)
+    if (pinned(recDecimPath(main, m)))
+      return true;
+  return false;
+}
+
+// Names carry the start time (accelYYMMDDHHMMSS[_NN]), so the smallest one
+// is the oldest recording. Returns the oldest main name after `after`
+// (companions count for their main file) and the bytes of the whole group.
+// One directory walk per deletion, no allocation beyond the names.
+static String oldestRecording(const String &after, uint32_t &size)
+{
+  String best;
+  size = 0;
+  File root = LittleFS.open("/");
+  if (!root || !root.isDirectory())
+    return best;
+  File f = root.openNextFile();
+  while (f)
+  {
+    String name = f.name();
+    if (!name.startsWith("/"))
+      name = "/" + name;
+    if (name.startsWith("/accel") && name.endsWith(".dat"))
+    {
+      const String main = recordingOf(name);
+      if (main > after && (!best.length() || main < best))
+      {
+        best = main;
+        size = 0;
+      }
+      if (main == best)
+        size += f.size();
+    }
+    f.close();
+    f = root.openNextFile();
+    delay(0);
+  }
+  root.close();
+  return best;
+}
+
+static bool removeRecording(const String &main)
+{
+  bool any = false;
+  if (LittleFS.exists(main))
+    any = LittleFS.remove(main);
+  for (uint8_t m : REC_DECIM_FACTORS)
+  {
+    const String side = recDecimPath(main, m);
+    if (LittleFS.exists(side) && LittleFS.remove(side))
+      any = true;
+  }
+  return any;
+}
+
+static void retentionTask(void * /*arg*/)
+{
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    String after; // busy recordings are stepped over, not retried
+    while (s_retMinFree && fsFreeBytes() < s_retMinFree)
+    {
+      uint32_t size;
+      const String victim = oldestRecording(after, size);
+      if (!victim.length())
+        break;
+      after = victim;
+      if (recordingBusy(victim))
+        continue;
+      if (!removeRecording(victim))
+        break;
+      g_retDeleted++;
+      g_retFreedKB += size / 1024;
+      Serial.printf("[REC] retention: removed %s (+companions, %lu B)\n", victim.c_str(), (unsigned long)size);
+      vTaskDelay(1);
+    }
+  }
+}
+
+void recRetentionSetQuota(uint32_t minFreeBytes) { s_retMinFree = minFreeBytes; }
+
+void recRetentionKick()
+{
+  if (!s_retMinFree)
+    return;
+  // priority 0: only runs while the writer (and everything else) is idle
+  if (!s_retTask && xTaskCreatePinnedToCore(retentionTask, "retention", 4096, nullptr, 0, &s_retTask, 0) != pdPASS)
+  {
+    s_retTask = nullptr;
+    return;
+  }
+  xTaskNotifyGive(s_retTask);
+}
+
+// ======================= Boot-time repair =======================
+// V4: walk whole blocks up to the data end; a torn last block is simply
+// not counted.
+static uint32_t countV4Samples(File &f, uint32_t size)
+{
+  uint32_t n = 0;
+  uint32_t pos = sizeof(FileHeaderV4);
+  uint32_t blocks = 0;
+  RecBlockHdrV4 bh;
+  while (pos + sizeof(bh) <= size)
+  {
+    f.seek(pos, SeekSet);
+    if (f.read((uint8_t *)&bh, sizeof(bh)) != sizeof(bh) || bh.sync != REC_V4_SYNC)
+      break;
+    if (pos + sizeof(bh) + bh.bytes > size)
+      break;
+    n += bh.n;
+    pos += sizeof(bh) + bh.bytes;
+    if ((++blocks & 0x3F) == 0)
+      delay(0); // watchdog friendly
+  }
+  return n;
+}
+
+static bool repairOne(const String &path)
+{
+  File f = LittleFS.open(path, "r+");
+  if (!f)
+    return false;
+  FileHeaderV3 h{};
+  const uint32_t size = f.size();
+  bool ok = size >= sizeof(h) && f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+            recHeaderOk(h) && h.samples == 0 && size > recHeaderBytes(h.version);
+  uint32_t onFlash = 0;
+  if (ok)
+  {
+    // index / HLTH / FEAT may already be on flash (cut before the header
+    // rewrite, or a session that stored nothing): only count sample data
+    const uint32_t hdrBytes = recHeaderBytes(h.version);
+    const RecTrailer tr = recScanTrailer(size, hdrBytes, [&f](uint32_t off, void *dst, size_t len)
+                                         { return f.seek(off, SeekSet) && f.read((uint8_t *)dst, len) == len; });
+    onFlash = (h.version == 4) ? countV4Samples(f, tr.dataEnd)
+                               : (tr.dataEnd - hdrBytes) / sizeof(Sample6);
+  }
+  if (ok && onFlash > 0)
+  {
+    h.samples = onFlash;
+    f.seek(0, SeekSet);
+    ok = f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h);
+    if (ok)
+      Serial.printf("[REC] repaired %s: %lu samples\n", path.c_str(), (unsigned long)onFlash);
+  }
+  else
+  {
+    ok = false;
+  }
+  f.close();
+  return ok;
+}
+
+// Up to REC_REPAIR_BATCH candidates named after `after`, smallest names
+// first, so repeated walks cover any number of files.
+static const uint8_t REC_REPAIR_BATCH = 16;
+
+static uint8_t collectRepairBatch(const String &after, String (&todo)[REC_REPAIR_BATCH], bool &more)
+{
+  uint8_t nTodo = 0;
+  more = false;
+  File root = LittleFS.open("/");
+  if (!root || !root.isDirectory())
+    return 0;
+  File f = root.openNextFile();
+  while (f)
+  {
+    String name = f.name();
+    if (!name.startsWith("/"))
+      name = "/" + name;
+    FileHeaderV3 h{};
+    if (name > after && name.startsWith("/accel") && name.endsWith(".dat") && f.size() > sizeof(h) &&
+        f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) && h.samples == 0)
+    {
+      // keep the batch sorted; past a full batch only the smaller names stay
+      uint8_t at = nTodo;
+      while (at > 0 && name < todo[at - 1])
+        at--;
+      if (at < REC_REPAIR_BATCH)
+      {
+        if (nTodo == REC_REPAIR_BATCH)
+          more = true; // the largest one falls out
+        else
+          nTodo++;
+        for (uint8_t i = nTodo - 1; i > at; i--)
+          todo[i] = todo[i - 1];
+        todo[at] = name;
+      }
+      else
+      {
+        more = true;
+      }
+    }
+    f.close();
+    f = root.openNextFile();
+    delay(0);
+  }
+  root.close();
+  return nTodo;
+}
+
+uint16_t recRepairInterrupted()
+{
+  // collect first: rewriting headers while the directory is being walked
+  // is not something to rely on. Batches go by name, so files that stay
+  // at 0 (empty sessions) are not picked up again.
+  String todo[REC_REPAIR_BATCH];
+  String after;
+  uint16_t repaired = 0, candidates = 0;
+  bool more = true;
+  while (more)
+  {
+    const uint8_t nTodo = collectRepairBatch(after, todo, more);
+    if (!nTodo)
+      break;
+    for (uint8_t i = 0; i < nTodo; i++)
+      if (repairOne(todo[i]))
+        repaired++;
+    candidates += nTodo;
+    after = todo[nTodo - 1];
+  }
+  if (candidates > repaired)
+    Serial.printf("[REC] repair: %u of %u files with samples==0 left as they are\n",
+                  (unsigned)(candidates - repaired), (unsigned)candidates);
+  return repaired;
+}
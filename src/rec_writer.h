@@ -0,0 +1,94 @@
+#pragma once
+
+#include "app_state.h"
+#include "rec_index.h"
+#include "spsc_ring.h"
+
+// Flash side of a recording. The acquisition job (sensor service, core 1)
+// fills RecBlocks straight from the FIFO and hands them over through a
+// lock-free SPSC ring; the writer task (core 0) drains the ring to LittleFS,
+// so a flash erase stall only grows the ring instead of stalling the FIFO.
+static const size_t REC_BLOCK_N = 256;    // samples per block (1.5 KB)
+static const size_t REC_RING_BLOCKS = 16; // ~2.5 s of headroom at 1600 Hz
+static const uint32_t REC_STALL_US = 20000; // a single write slower than this is a stall
+static const size_t REC_FS_BLOCK = 4096;     // LittleFS block: unit of every flash write
+static const uint32_t REC_COMMIT_MS = 2000;  // sync file size to flash at least this often
+
+static_assert(REC_BLOCK_N <= REC_V4_BLOCK_MAX, "V4 readers decode one writer block at a time");
+static_assert(REC_INDEX_N % REC_BLOCK_N == 0, "index blocks must start on a writer block");
+
+struct RecBlock
+{
+  uint16_t n;
+  uint64_t first; // capture index of s[0]; blocks lost to a full ring leave a gap
+                  // (64 bit: a continuous session outlives 2^32 samples)
+  uint32_t t_us;  // micros() of the FIFO read that delivered s[0]
+  Sample6 s[REC_BLOCK_N];
+};
+
+typedef SpscRing<RecBlock, REC_RING_BLOCKS> RecRing;
+
+// Continuous sessions: the writer closes the current file and opens the next
+// segment once either limit is reached (0 = unused). Segments always split
+// on a whole RecBlock, so the producer never notices a rotation; it only
+// costs the ring a little headroom while the old file is finalised.
+typedef String (*RecSegmentPathFn)(uint32_t seg, uint64_t firstSample);
+struct RecSegmentPlan
+{
+  uint32_t samples = 0;          // per segment, rounded up to REC_BLOCK_N
+  uint32_t bytes = 0;            // per segment, checked at block boundaries
+  RecSegmentPathFn path = nullptr; // name of segment seg (1, 2, ...)
+};
+
+// Decimated streams (decimator.h), run by the writer task on every block,
+// so the acquisition loop pays nothing. Each factor in sides gets its own
+// V3 file next to the main one (recDecimPath, rate_hz / M). main = M stores
+// the /M stream in the main file instead of the full-rate one; its header
+// rate_hz must already be the decimated rate. Not combined with segments.
+struct RecDecimPlan
+{
+  uint16_t inRateHz = 0; // sensor rate the factors divide
+  uint8_t main = 0;      // 0 = full rate
+  uint8_t sides = 0;     // OR of factors (2|4|8|16)
+};
+// "/accelX.dat" -> "/accelX_d<M>.dat"
+String recDecimPath(const String &mainPath, uint8_t factor);
+
+// Creates the file and spawns the writer, which keeps it open for the whole
+// session. Header samples stays 0 on flash until the file is closed.
+// h.v3.version picks the format: 3 = raw Sample6, 4 = compressed blocks.
+// seg: rotate into further files (see RecSegmentPlan); nullptr = one file.
+// dec: decimated streams (see RecDecimPlan); nullptr = full rate only.
+bool recWriterStart(const String &path, const FileHeaderV4 &h, const RecSegmentPlan *seg = nullptr,
+                    const RecDecimPlan *dec = nullptr);
+
+// ---- producer (acquisition job) ----
+// Next free block (n reset to 0) or nullptr when the ring is full.
+RecBlock *recWriterAcquire();
+void recWriterCommit();
+// Writer gave up after a failed write; acquisition should stop.
+bool recWriterFailed();
+// No more blocks: waits for the ring to drain; returns samples on flash
+// (all segments; held at UINT32_MAX past that).
+uint32_t recWriterFinish();
+// File being written; after the session, the last one written. Safe from
+// any task.
+String recWriterCurrentPath();
+
+// ---- retention ----
+// Background task (core 0, lowest priority): deletes the oldest recording
+// (by name = by start time) together with its _d<M> companions until
+// LittleFS has at least minFreeBytes free. The file being written and files
+// pinned by a reader are never touched. 0 disables it.
+void recRetentionSetQuota(uint32_t minFreeBytes);
+// Runs one pass soon; the writer calls it after every rotation.
+void recRetentionKick();
+// Files being read (RecReader, downloads): pin while open. false when the
+// table is full (the read still works, retention just cannot see it).
+bool recReadPin(const String &path);
+void recReadUnpin(const String &path);
+
+// Boot: recordings (V3/V4) left with samples==0 (power cut / reset mid-session) get
+// their count back from the sample data on flash (trailer chunks excluded).
+// A closed session that stored no samples stays at 0. Returns files fixed.
+uint16_t recRepairInterrupted();
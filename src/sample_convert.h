@@ -0,0 +1,141 @@
+#pragma once
+
+// Batch aligned-raw -> calibrated g conversion.
+//   g = (raw * lsb_g - offset) * scale  ==  raw * k + b
+// with k = lsb_g * scale, b = -offset * scale folded once per file/session,
+// so each value costs one multiply-add (madd.s on the Xtensa FPU; GCC
+// contracts "v * k + b" under the default -ffp-contract=fast).
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rec_format.h"
+
+struct ConvCoeffs
+{
+  float k[3];     // g per LSB, calibration scale folded in
+  float b[3];     // calibration offset folded in (g)
+  float scale[3]; // calibration scale alone (templated kernels add LSB at compile time)
+};
+
+// AN5038 Table 15, as g/LSB (mg / 1000) for right-aligned raw.
+template <uint8_t RES, uint8_t FS>
+struct LsbG
+{
+  static_assert(RES == 12 || RES == 14, "res_bits must be 12 or 14");
+  static_assert(FS == 2 || FS == 4 || FS == 8 || FS == 16, "fs_g must be 2/4/8/16");
+  static constexpr float value = (RES == 12 ? 0.000976f : 0.000244f) * (FS / 2);
+};
+
+inline float lsbToG(uint8_t res_bits, uint8_t fs_g)
+{
+  const float base = (res_bits == 12) ? 0.000976f : 0.000244f;
+  switch (fs_g)
+  {
+  case 4:
+    return base * 2;
+  case 8:
+    return base * 4;
+  case 16:
+    return base * 8;
+  default:
+    return base;
+  }
+}
+
+inline ConvCoeffs convCoeffs(uint8_t res_bits, uint8_t fs_g, const float offset_g[3], const float scale[3])
+{
+  ConvCoeffs c;
+  const float lsb = lsbToG(res_bits, fs_g);
+  for (int i = 0; i < 3; i++)
+  {
+    c.k[i] = lsb * scale[i];
+    c.b[i] = -offset_g[i] * scale[i];
+    c.scale[i] = scale[i];
+  }
+  return c;
+}
+
+inline ConvCoeffs convCoeffsFromHeader(const FileHeaderV3 &h)
+{
+  return convCoeffs(h.res_bits, h.fs_g, h.cal_offset_g, h.cal_scale);
+}
+
+inline void convertSample(const Sample6 &s, const ConvCoeffs &c, float g[3])
+{
+  g[0] = (float)s.ax * c.k[0] + c.b[0];
+  g[1] = (float)s.ay * c.k[1] + c.b[1];
+  g[2] = (float)s.az * c.k[2] + c.b[2];
+}
+
+// Planar output; any of x/y/z may be nullptr to skip that axis.
+template <uint8_t RES, uint8_t FS>
+inline void convertSamplesT(const Sample6 *in, size_t n, const ConvCoeffs &c,
+                            float *x, float *y, float *z)
+{
+  // sensitivity is a compile-time constant here; no switch per call/sample
+  constexpr float lsb = LsbG<RES, FS>::value;
+  const float kx = lsb * c.scale[0], ky = lsb * c.scale[1], kz = lsb * c.scale[2];
+  const float bx = c.b[0], by = c.b[1], bz = c.b[2];
+
+  size_t i = 0;
+  if (x && y && z)
+  {
+    for (; i + 4 <= n; i += 4)
+    {
+      x[i + 0] = (float)in[i + 0].ax * kx + bx;
+      y[i + 0] = (float)in[i + 0].ay * ky + by;
+      z[i + 0] = (float)in[i + 0].az * kz + bz;
+      x[i + 1] = (float)in[i + 1].ax * kx + bx;
+      y[i + 1] = (float)in[i + 1].ay * ky + by;
+      z[i + 1] = (float)in[i + 1].az * kz + bz;
+      x[i + 2] = (float)in[i + 2].ax * kx + bx;
+      y[i + 2] = (float)in[i + 2].ay * ky + by;
+      z[i + 2] = (float)in[i + 2].az * kz + bz;
+      x[i + 3] = (float)in[i + 3].ax * kx + bx;
+      y[i + 3] = (float)in[i + 3].ay * ky + by;
+      z[i + 3] = (float)in[i + 3].az * kz + bz;
+    }
+  }
+  for (; i < n; i++)
+  {
+    if (x)
+      x[i] = (float)in[i].ax * kx + bx;
+    if (y)
+      y[i] = (float)in[i].ay * ky + by;
+    if (z)
+      z[i] = (float)in[i].az * kz + bz;
+  }
+}
+
+// Runtime (res_bits, fs_g) -> specialised kernel, dispatched once per batch.
+inline void convertSamples(const Sample6 *in, size_t n, uint8_t res_bits, uint8_t fs_g,
+                           const ConvCoeffs &c, float *x, float *y, float *z)
+{
+#define CONV_CASE(R, F)                             \
+  if (res_bits == R && fs_g == F)                   \
+  {                                                 \
+    convertSamplesT<R, F>(in, n, c, x, y, z);       \
+    return;                                         \
+  }
+  CONV_CASE(14, 2)
+  CONV_CASE(14, 4)
+  CONV_CASE(14, 8)
+  CONV_CASE(14, 16)
+  CONV_CASE(12, 2)
+  CONV_CASE(12, 4)
+  CONV_CASE(12, 8)
+  CONV_CASE(12, 16)
+#undef CONV_CASE
+  // unknown header combination: generic path with the runtime k
+  for (size_t i = 0; i < n; i++)
+  {
+    float g[3];
+    convertSample(in[i], c, g);
+    if (x)
+      x[i] = g[0];
+    if (y)
+      y[i] = g[1];
+    if (z)
+      z[i] = g[2];
+  }
+}
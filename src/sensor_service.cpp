@@ -0,0 +1,117 @@
+#include "sensor_service.h"
+
+#include <Wire.h>
+
+static QueueHandle_t s_jobs = nullptr;
+static TaskHandle_t s_task = nullptr;
+
+static LIS2DW12 s_lis(Wire, 0x18);
+static bool s_devOk = false;
+static uint32_t s_clockHz = 0;
+
+static LIS2DW12::Calibration s_cal;
+static uint32_t s_jobSubmitUs = 0;
+static bool s_firstMarked = false;
+
+// ======================= Device ownership =======================
+static bool ensureDevice(uint32_t clockHz)
+{
+  if (s_devOk && clockHz == s_clockHz)
+    return true;
+
+  // begin() only on first use / after a failure; otherwise just the clock.
+  if (!s_devOk)
+  {
+    s_devOk = s_lis.begin(-1, -1, clockHz);
+  }
+  else
+  {
+    Wire.setClock(clockHz);
+  }
+  if (s_devOk)
+    s_clockHz = clockHz;
+  return s_devOk;
+}
+
+const LIS2DW12::Calibration &sensorCalibration()
+{
+  if (g_calDirty)
+  {
+    s_lis.clearCalibration();
+    s_lis.loadCalibrationNVS("lis2dw12", "cal");
+    s_cal = s_lis.getCalibration();
+    g_calDirty = false;
+  }
+  return s_cal;
+}
+
+bool sensorSaveCalibration(const LIS2DW12::Calibration &cal)
+{
+  s_lis.setCalibration(cal);
+  bool ok = s_lis.saveCalibrationNVS("lis2dw12", "cal");
+  s_cal = cal;
+  g_calDirty = false;
+  return ok;
+}
+
+void sensorMarkFirstSample()
+{
+  if (s_firstMarked)
+    return;
+  s_firstMarked = true;
+  g_firstSampleUs = micros() - s_jobSubmitUs;
+}
+
+bool sensorJobPending() { return s_jobs && uxQueueMessagesWaiting(s_jobs) > 0; }
+
+// ======================= Service task =======================
+static void sensorServiceTask(void * /*arg*/)
+{
+  SensorJob job;
+  for (;;)
+  {
+    if (xQueueReceive(s_jobs, &job, portMAX_DELAY) != pdTRUE)
+      continue;
+
+    s_jobSubmitUs = job.submitUs;
+    s_firstMarked = false;
+
+    if (!ensureDevice(job.clockHz))
+    {
+      // device missing: job still runs so it can report failure / clear flags
+      s_devOk = false;
+    }
+    else
+    {
+      s_lis.setCalibration(sensorCalibration());
+    }
+
+    if (job.fn)
+      job.fn(s_lis, job.arg);
+
+    // a job that failed on the bus forces begin() again next time
+    if (!s_lis.probe())
+      s_devOk = false;
+
+    if (job.done)
+      xSemaphoreGive(job.done);
+  }
+}
+
+bool sensorServiceStart()
+{
+  if (s_task)
+    return true;
+  s_jobs = xQueueCreate(4, sizeof(SensorJob));
+  if (!s_jobs)
+    return false;
+  return xTaskCreatePinnedToCore(sensorServiceTask, "sensor", 8192, nullptr, 2, &s_task, 1) == pdPASS;
+}
+
+bool sensorServiceSubmit(SensorJob job, TickType_t wait)
+{
+  if (!s_jobs)
+    return false;
+  job.submitUs = micros();
+  return xQueueSend(s_jobs, &job, wait) == pdTRUE;
+}
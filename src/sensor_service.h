@@ -0,0 +1,35 @@
+#pragma once
+
+#include "app_state.h"
+
+// Single owner of the LIS2DW12. Jobs (recording, calibration, live capture)
+// are queued and run one at a time on the service task with the device
+// already begun and calibration held in RAM; nothing else touches the bus.
+typedef void (*SensorJobFn)(LIS2DW12 &lis, void *arg);
+
+// I2C clocks: 400 kHz unless a job needs the FIFO drained fast (capture,
+// live sampler).
+static const uint32_t SENSOR_I2C_HZ = 400000;
+static const uint32_t SENSOR_I2C_FAST_HZ = 1000000;
+
+struct SensorJob
+{
+  SensorJobFn fn = nullptr;
+  void *arg = nullptr;
+  uint32_t clockHz = SENSOR_I2C_HZ;  // I2C clock for this job
+  SemaphoreHandle_t done = nullptr; // optional, given when fn returns
+  uint32_t submitUs = 0;            // stamped by sensorServiceSubmit()
+};
+
+bool sensorServiceStart();
+bool sensorServiceSubmit(SensorJob job, TickType_t wait = 0);
+
+// ---- service-task context only (i.e. inside a SensorJobFn) ----
+// Calibration cached in RAM; reloaded from NVS when g_calDirty is set.
+const LIS2DW12::Calibration &sensorCalibration();
+// Store new calibration in RAM + NVS.
+bool sensorSaveCalibration(const LIS2DW12::Calibration &cal);
+// First sample of the current job is in hand -> g_firstSampleUs.
+void sensorMarkFirstSample();
+// Another job is queued: open-ended jobs (live sampler) return for it.
+bool sensorJobPending();
@@ -0,0 +1,74 @@
+#pragma once
+
+// Lock-free single-producer / single-consumer ring of fixed slots.
+// Slots are filled and drained in place (no copy): the producer gets a free
+// slot with acquireWrite(), fills it and publishes it with commitWrite(); the
+// consumer mirrors that with acquireRead()/releaseRead(). Head and tail are
+// free-running 32-bit counters, each written by one side only.
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+template <class T, size_t N>
+class SpscRing
+{
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+  static constexpr size_t CAPACITY = N;
+
+  // Only while neither side is running.
+  void reset()
+  {
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+    _highWater.store(0, std::memory_order_relaxed);
+  }
+
+  // ---- producer ----
+  T *acquireWrite()
+  {
+    const uint32_t h = _head.load(std::memory_order_relaxed);
+    if (h - _tail.load(std::memory_order_acquire) >= N)
+      return nullptr; // full
+    return &_buf[h & (N - 1)];
+  }
+
+  void commitWrite()
+  {
+    const uint32_t h = _head.load(std::memory_order_relaxed) + 1;
+    _head.store(h, std::memory_order_release);
+    const uint32_t used = h - _tail.load(std::memory_order_acquire);
+    if (used > _highWater.load(std::memory_order_relaxed))
+      _highWater.store(used, std::memory_order_relaxed);
+  }
+
+  // ---- consumer ----
+  T *acquireRead()
+  {
+    const uint32_t t = _tail.load(std::memory_order_relaxed);
+    if (_head.load(std::memory_order_acquire) == t)
+      return nullptr; // empty
+    return &_buf[t & (N - 1)];
+  }
+
+  void releaseRead()
+  {
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // ---- either side (snapshot) ----
+  size_t size() const
+  {
+    const uint32_t t = _tail.load(std::memory_order_acquire); // tail first: never ahead of head
+    return _head.load(std::memory_order_acquire) - t;
+  }
+  bool empty() const { return size() == 0; }
+  size_t highWater() const { return _highWater.load(std::memory_order_relaxed); }
+
+private:
+  T _buf[N];
+  std::atomic<uint32_t> _head{0};
+  std::atomic<uint32_t> _tail{0};
+  std::atomic<uint32_t> _highWater{0};
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+// Short-time spectrum (spectrogram / waterfall) of a recording, one frame at
+// a time: frames of n samples every `hop` samples (hop > n skips the samples
+// in between), mean removed, windowed, real FFT (fft_f32.h), magnitude in
+// dB quantised to uint8 or uint16 cells. Only the frame being filled, the
+// FFT scratch, the window and one output row are held, so memory does not
+// depend on the file length.
+//
+// Wire format of /api/stft (little endian, no padding):
+//   StftHdr | frames rows of `bins` cells (uint8 or uint16)
+// Cell v of row f, column k: dB = db_lo + v * db_step (v = 0 is "at or
+// below db_lo"), frequency k * rate_hz / n, frame centre
+// (f * hop + n / 2) / rate_hz seconds. dB is re 1 g peak: the amplitude a
+// sine centred on the bin would have. frames is the planned count; a file
+// that ends early (corrupt V4 block) sends fewer rows.
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "welch_psd.h"
+
+static const char STFT_MAGIC[4] = {'S', 'T', 'F', 'T'};
+
+#pragma pack(push, 1)
+struct StftHdr
+{
+  char magic[4];      // STFT_MAGIC
+  uint16_t hdr_bytes; // sizeof(StftHdr): readers skip what they do not know
+  uint8_t cell_bytes; // 1 = uint8, 2 = uint16
+  uint8_t window;     // FftWindow
+  uint16_t n;         // frame length (power of two)
+  uint16_t bins;      // cells per row: bins 0 .. bins-1
+  uint32_t hop;       // samples between frame starts
+  uint32_t frames;    // rows that follow
+  float rate_hz;
+  float db_lo;
+  float db_step;
+  char axis; // 'x' 'y' 'z' or 'm' (|a|)
+  uint8_t reserved[3];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(StftHdr) == 36, "wire format");
+
+// Frames a file of `samples` gives.
+inline uint32_t stftFrames(uint32_t samples, uint32_t n, uint32_t hop)
+{
+  return (samples < n || !hop) ? 0 : (samples - n) / hop + 1;
+}
+
+class StftFrames
+{
+public:
+  StftFrames() = default;
+  StftFrames(const StftFrames &) = delete;
+  StftFrames &operator=(const StftFrames &) = delete;
+  ~StftFrames() { end(); }
+
+  // n: power of two, 16 .. FFT_MAX_N; bins <= n/2 + 1; cellBytes 1 or 2.
+  // Cells cover [dbLo, dbHi].
+  bool begin(uint32_t n, uint32_t hop, FftWindow win, uint32_t bins, uint8_t cellBytes, float dbLo, float dbHi)
+  {
+    end();
+    if (n < 16 || !fftSizeOk(n) || !hop || !bins || bins > n / 2 + 1 || (cellBytes != 1 && cellBytes != 2) ||
+        !(dbHi > dbLo))
+      return false;
+    _n = n;
+    _hop = hop;
+    _bins = bins;
+    _cell = cellBytes;
+    _dbLo = dbLo;
+    _dbStep = (dbHi - dbLo) / (cellBytes == 1 ? 255.0f : 65535.0f);
+    _seg = (float *)malloc(n * sizeof(float));
+    _work = (float *)malloc(n * sizeof(float));
+    _w = (float *)malloc(n * sizeof(float));
+    _row = (uint8_t *)malloc((size_t)bins * cellBytes);
+    if (!_seg || !_work || !_w || !_row)
+    {
+      end();
+      return false;
+    }
+    double s1 = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+      _w[i] = fftWindowAt(win, i, n);
+      s1 += _w[i];
+    }
+    // |X[k]|^2 -> (peak amplitude)^2 of a sine on bin k
+    _powToAmp2 = (float)(4.0 / (s1 * s1));
+    _fill = 0;
+    _skip = 0;
+    _ready = false;
+    _frames = 0;
+    return true;
+  }
+
+  void end()
+  {
+    free(_seg);
+    free(_work);
+    free(_w);
+    free(_row);
+    _seg = _work = _w = nullptr;
+    _row = nullptr;
+    _n = 0;
+  }
+
+  // Consumes samples until a frame completes (frameReady()) or x runs out;
+  // returns how many were taken. Feed the rest after reading row().
+  size_t push(const float *x, size_t k)
+  {
+    if (!_n)
+      return 0;
+    _ready = false;
+    size_t used = 0;
+    if (_skip)
+    {
+      used = _skip < k ? _skip : k;
+      _skip -= used;
+    }
+    size_t take = _n - _fill;
+    if (take > k - used)
+      take = k - used;
+    memcpy(_seg + _fill, x + used, take * sizeof(float));
+    _fill += take;
+    used += take;
+    if (_fill == _n)
+    {
+      frame();
+      _ready = true;
+      _frames++;
+      if (_hop < _n)
+      {
+        memmove(_seg, _seg + _hop, (_n - _hop) * sizeof(float));
+        _fill = _n - _hop;
+      }
+      else
+      {
+        _fill = 0;
+        _skip = _hop - _n;
+      }
+    }
+    return used;
+  }
+
+  bool frameReady() const { return _ready; }
+  // bins() cells of the last frame, little endian.
+  const uint8_t *row() const { return _row; }
+  size_t rowBytes() const { return (size_t)_bins * _cell; }
+  uint32_t frames() const { return _frames; }
+  uint32_t bins() const { return _bins; }
+  float dbLo() const { return _dbLo; }
+  float dbStep() const { return _dbStep; }
+
+private:
+  void frame()
+  {
+    float mean = 0;
+    for (uint32_t i = 0; i < _n; i++)
+      mean += _seg[i];
+    mean /= (float)_n;
+    for (uint32_t i = 0; i < _n; i++)
+      _work[i] = (_seg[i] - mean) * _w[i];
+    fftReal(_work, _n);
+    const float maxCell = _cell == 1 ? 255.0f : 65535.0f;
+    for (uint32_t k = 0; k < _bins; k++)
+    {
+      float p;
+      if (k == 0)
+        p = _work[0] * _work[0] * 0.25f; // one-sided: DC and Nyquist are not doubled
+      else if (k == _n / 2)
+        p = _work[1] * _work[1] * 0.25f;
+      else
+        p = _work[2 * k] * _work[2 * k] + _work[2 * k + 1] * _work[2 * k + 1];
+      float v = 0;
+      if (p > 0)
+      {
+        v = (10.0f * log10f(p * _powToAmp2) - _dbLo) / _dbStep + 0.5f;
+        if (v < 0)
+          v = 0;
+        if (v > maxCell)
+          v = maxCell;
+      }
+      const uint16_t q = (uint16_t)v;
+      if (_cell == 1)
+        _row[k] = (uint8_t)q;
+      else
+      {
+        _row[2 * k] = (uint8_t)q;
+        _row[2 * k + 1] = (uint8_t)(q >> 8);
+      }
+    }
+  }
+
+  float *_seg = nullptr;
+  float *_work = nullptr;
+  float *_w = nullptr;
+  uint8_t *_row = nullptr;
+  uint32_t _n = 0;
+  uint32_t _hop = 0;
+  uint32_t _bins = 0;
+  uint32_t _fill = 0;
+  uint32_t _skip = 0; // hop > n: samples still to drop before the next frame
+  uint32_t _frames = 0;
+  uint8_t _cell = 1;
+  bool _ready = false;
+  float _dbLo = 0, _dbStep = 1;
+  float _powToAmp2 = 1;
+};
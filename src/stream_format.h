@@ -0,0 +1,35 @@
+#pragma once
+
+// Wire format of a live stream session (raw TCP, STREAM_PORT):
+//   StreamHello | StreamFrameHdr + Sample6 x n | StreamFrameHdr + ...
+// One frame per acquisition block, little endian, no padding. The hello
+// carries the same FileHeaderV3 a recording would get, so a receiver can
+// store the stream as a plain V3 .dat (tools/stream_recv.cpp).
+#include <stdint.h>
+
+#include "rec_format.h"
+
+static const uint16_t STREAM_PORT = 3333;
+static const uint16_t STREAM_SYNC = 0x5354; // "TS" on the wire
+
+#pragma pack(push, 1)
+struct StreamHello
+{
+  char magic[8]; // "LISSTRM1"
+  FileHeaderV3 hdr; // version 3, samples = 0 (open ended)
+};
+
+struct StreamFrameHdr
+{
+  uint16_t sync;    // STREAM_SYNC
+  uint16_t n;       // Sample6 that follow
+  uint32_t seq;     // frames produced, including dropped ones: a jump = lost frames
+  uint32_t first;   // capture index of the first sample: exact time base is first / rate_hz
+                    // (low 32 bits: wraps after 2^32 samples, ~31 days at 1600 Hz;
+                    // gaps are still first - expected in uint32 arithmetic)
+  uint32_t t_us;    // device clock (esp_timer, low 32 bits) when that sample was read
+  uint32_t dropped; // frames dropped on the device so far
+};
+#pragma pack(pop)
+
+static_assert(sizeof(StreamFrameHdr) == 20, "wire format");
@@ -0,0 +1,164 @@
+#include "stream_session.h"
+
+#include <WiFi.h>
+
+typedef SpscRing<RecBlock, STREAM_RING_BLOCKS> StreamRing;
+
+static WiFiServer s_server(STREAM_PORT);
+static bool s_listening = false;
+static WiFiClient s_client;
+static StreamRing s_ring;
+static TaskHandle_t s_task = nullptr;
+static SemaphoreHandle_t s_done = nullptr;
+static volatile bool s_producerDone = false;
+static volatile bool s_failed = false;
+static uint32_t s_t0 = 0;
+
+// Frame header + one full block: a single write() per frame.
+static uint8_t s_tx[sizeof(StreamFrameHdr) + REC_BLOCK_N * sizeof(Sample6)];
+
+// ======================= Sender task =======================
+static bool sendFrame(const RecBlock &b)
+{
+  StreamFrameHdr fh;
+  fh.sync = STREAM_SYNC;
+  fh.n = b.n;
+  fh.seq = (uint32_t)(b.first / REC_BLOCK_N); // blocks are full except the last one
+  fh.first = (uint32_t)b.first;                // low 32 bits, see stream_format.h
+  fh.t_us = b.t_us;
+  fh.dropped = g_stDropped;
+  const size_t len = sizeof(fh) + b.n * sizeof(Sample6);
+  memcpy(s_tx, &fh, sizeof(fh));
+  memcpy(s_tx + sizeof(fh), b.s, b.n * sizeof(Sample6));
+
+  uint32_t t0 = micros();
+  size_t wrote = s_client.write(s_tx, len); // blocks while the TCP window is full
+  uint32_t dt = micros() - t0;
+  if (dt > g_stSendMaxUs)
+    g_stSendMaxUs = dt;
+  if (dt > STREAM_SEND_STALL_US)
+    g_stStalls++;
+  if (wrote != len)
+    return false;
+
+  g_stFrames++;
+  g_stBytes += len;
+  uint32_t ms = millis() - s_t0;
+  if (ms)
+    g_stBps = (uint32_t)((uint64_t)g_stBytes * 1000ULL / ms);
+  return true;
+}
+
+static void streamTask(void * /*arg*/)
+{
+  for (;;)
+  {
+    RecBlock *b = s_ring.acquireRead();
+    if (!b)
+    {
+      if (s_producerDone && s_ring.empty())
+        break;
+      if (!s_client.connected())
+        s_failed = true; // noticed even while idle
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+      continue;
+    }
+    if (!s_failed && (!s_client.connected() || !sendFrame(*b)))
+      s_failed = true;
+    s_ring.releaseRead(); // keep draining after a failure, the producer must not block
+  }
+
+  s_client.stop();
+  s_task = nullptr; // before the give: the next open() checks it right after
+  xSemaphoreGive(s_done);
+  vTaskDelete(nullptr);
+}
+
+// ======================= Producer API =======================
+bool streamSessionOpen(const FileHeaderV3 &h)
+{
+  if (s_task)
+    return false;
+  if (!s_done)
+    s_done = xSemaphoreCreateBinary();
+  if (!s_done)
+    return false;
+  if (!s_listening)
+  {
+    s_server.begin();
+    s_listening = true;
+  }
+
+  uint32_t t0 = millis();
+  while (!(s_client = s_server.available()))
+  {
+    if (g_stopRequested || millis() - t0 > STREAM_ACCEPT_MS)
+      return false;
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+  s_client.setNoDelay(true); // frames are already large; no need to wait for more
+
+  StreamHello hello;
+  memcpy(hello.magic, "LISSTRM1", 8);
+  hello.hdr = h;
+  if (s_client.write((const uint8_t *)&hello, sizeof(hello)) != sizeof(hello))
+  {
+    s_client.stop();
+    return false;
+  }
+
+  s_ring.reset();
+  s_producerDone = false;
+  s_failed = false;
+  s_t0 = millis();
+  g_stFrames = 0;
+  g_stDropped = 0;
+  g_stBytes = 0;
+  g_stBps = 0;
+  g_stSendMaxUs = 0;
+  g_stStalls = 0;
+  g_stRingHighWater = 0;
+
+  if (xTaskCreatePinnedToCore(streamTask, "streamtx", 4096, nullptr, 1, &s_task, 0) != pdPASS)
+  {
+    s_client.stop();
+    return false;
+  }
+  return true;
+}
+
+RecBlock *streamAcquire()
+{
+  RecBlock *b = s_ring.acquireWrite();
+  if (b)
+    b->n = 0;
+  return b;
+}
+
+void streamCommit()
+{
+  s_ring.commitWrite();
+  g_stRingHighWater = s_ring.highWater();
+  if (s_task)
+    xTaskNotifyGive(s_task);
+}
+
+bool streamFailed() { return s_failed; }
+
+uint32_t streamSessionClose()
+{
+  s_producerDone = true;
+  if (s_task)
+    xTaskNotifyGive(s_task);
+  if (xSemaphoreTake(s_done, pdMS_TO_TICKS(10000)) != pdTRUE)
+  {
+    // sender stuck in write(): closing the socket makes it fail, then the
+    // task drains the ring and exits. The next open() resets the ring, so
+    // the task has to be gone before this returns.
+    Serial.println("[STREAM] sender stuck, closing the connection");
+    s_failed = true;
+    s_client.stop();
+    xSemaphoreTake(s_done, portMAX_DELAY);
+  }
+  return g_stFrames;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "rec_writer.h"
+#include "stream_format.h"
+
+// Live stream to one TCP client on STREAM_PORT, bypassing flash. Same split
+// as a recording: the acquisition job fills RecBlocks, a sender task (core 0)
+// pushes them out. A slow client only fills the ring; once it is full the
+// producer drops whole blocks (counted, visible as seq jumps) and the FIFO
+// never waits. Nothing is allocated while streaming.
+static const size_t STREAM_RING_BLOCKS = 8;      // ~1.3 s of headroom at 1600 Hz
+static const uint32_t STREAM_ACCEPT_MS = 15000;  // wait for a client after start
+static const uint32_t STREAM_SEND_STALL_US = 50000; // a send slower than this is a stall
+
+// Waits (service task) for a client, sends the hello and spawns the sender.
+// false: nobody connected in time or stop requested meanwhile.
+bool streamSessionOpen(const FileHeaderV3 &h);
+
+// ---- producer (acquisition job) ----
+RecBlock *streamAcquire();
+void streamCommit();
+// Client went away; acquisition should stop.
+bool streamFailed();
+// Drains the ring, closes the connection; returns frames sent.
+uint32_t streamSessionClose();
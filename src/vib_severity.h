@@ -0,0 +1,197 @@
+#pragma once
+
+// Vibration severity (ISO 10816 / 20816): band-limited velocity RMS and
+// displacement peak-to-peak, streamed sample by sample with fixed state
+// per axis, so a recording of any length needs no extra RAM.
+//
+// Filter chain per axis, the classic ISO 2954 meter in IIR form:
+//   a -> 2nd order high-pass at f_lo -> integrate -> 2nd order high-pass
+//     at f_lo -> velocity (4th order Butterworth overall: Q 0.54 and 1.31)
+//     -> integrate -> 2nd order high-pass at f_lo -> displacement
+// plus a 2nd order Butterworth low-pass at f_hi when f_hi < fs / 2.56;
+// above that the rate is the band limit. The integrators are Al-Alaoui
+// (7/8 rectangle + 1/8 trapezoid: within 2 % of 1/w up to fs / 4, where
+// the trapezoid is already 21 % low) and leak with a pole at f_lo / 5
+// (-0.17 dB at f_lo), so float round-off cannot make them drift; the high-pass
+// after each one removes its start-up offset. The first high-pass starts
+// in steady state for the first sample, so gravity does not ring; the
+// first 5 / f_lo seconds (at most a quarter of the data) are still
+// skipped before statistics are taken.
+#include <math.h>
+#include <stdint.h>
+
+#include "iir_svf.h"
+
+static const float VIB_G_MMPS2 = 9806.65f; // 1 g in mm/s^2
+
+// ---- ISO zone boundaries (velocity RMS, mm/s: A|B, B|C, C|D) ----
+struct IsoClass
+{
+  const char *name;
+  const char *desc;
+  float ab, bc, cd;
+};
+
+static const IsoClass ISO_CLASSES[] = {
+    {"I", "10816-1 class I: small machines < 15 kW", 0.71f, 1.8f, 4.5f},
+    {"II", "10816-1 class II: medium machines 15..75 kW", 1.12f, 2.8f, 7.1f},
+    {"III", "10816-1 class III: large machines, rigid foundation", 1.8f, 4.5f, 11.2f},
+    {"IV", "10816-1 class IV: large machines, soft foundation", 2.8f, 7.1f, 18.0f},
+    {"g1r", "20816-3 group 1 (> 300 kW), rigid", 2.3f, 4.5f, 7.1f},
+    {"g1f", "20816-3 group 1 (> 300 kW), flexible", 3.5f, 7.1f, 11.0f},
+    {"g2r", "20816-3 group 2 (15..300 kW), rigid", 1.4f, 2.8f, 4.5f},
+    {"g2f", "20816-3 group 2 (15..300 kW), flexible", 2.3f, 4.5f, 7.1f},
+};
+
+inline const IsoClass *isoClassFromName(const char *s)
+{
+  for (const IsoClass &c : ISO_CLASSES)
+  {
+    const char *a = c.name, *b = s;
+    while (*a && *a == *b)
+      a++, b++;
+    if (!*a && !*b)
+      return &c;
+  }
+  return nullptr;
+}
+
+inline char isoZone(const IsoClass &c, float velRmsMms)
+{
+  return velRmsMms < c.ab ? 'A' : velRmsMms < c.bc ? 'B' : velRmsMms < c.cd ? 'C' : 'D';
+}
+
+class VibSeverity
+{
+public:
+  // fLo: 10 (machines above 600 rpm) or 2 Hz; fHi: 1000 Hz, capped at
+  // fs / 2.56. false if the band does not fit the rate.
+  bool begin(float fs, float fLo = 10.0f, float fHi = 1000.0f)
+  {
+    _ok = false;
+    if (fs <= 0 || fLo <= 0 || fLo * 4.0f > fs)
+      return false;
+    _dt = 1.0f / fs;
+    _fLo = fLo;
+    _lp = fHi < fs / 2.56f;
+    _fHi = _lp ? fHi : fs / 2.56f;
+    _leak = expf(-2.0f * (float)M_PI * (fLo / 5.0f) / fs);
+    for (Axis &a : _ax)
+    {
+      a.ahp.setup(true, fLo, fs, 0.5411961f);
+      a.vhp.setup(true, fLo, fs, 1.3065630f);
+      a.dhp.setup(true, fLo, fs, 0.7071068f);
+      a.lp.setup(false, _lp ? fHi : 0.25f * fs, fs, 0.7071068f);
+    }
+    _settle = (uint32_t)(5.0f * fs / fLo);
+    _n = 0;
+    _used = 0;
+    _ok = true;
+    return true;
+  }
+
+  bool ok() const { return _ok; }
+  float fLo() const { return _fLo; }
+  float fHi() const { return _fHi; }
+
+  // One sample per axis, in g.
+  void push(const float g[3])
+  {
+    if (!_ok)
+      return;
+    if (!_n)
+    {
+      for (uint8_t i = 0; i < 3; i++)
+      {
+        Axis &a = _ax[i];
+        a.ahp.prime(g[i] * VIB_G_MMPS2);
+        a.vhp.prime(0);
+        a.dhp.prime(0);
+        a.lp.prime(0);
+        a.accPrev = a.vi = a.velPrev = a.di = 0;
+        a.ss = 0;
+        a.dMin = INFINITY;
+        a.dMax = -INFINITY;
+      }
+    }
+    const bool take = _n >= _settle;
+    const float k7 = 0.875f * _dt, k1 = 0.125f * _dt;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      Axis &a = _ax[i];
+      float acc = a.ahp.run(g[i] * VIB_G_MMPS2);
+      if (_lp)
+        acc = a.lp.run(acc);
+      a.vi = _leak * a.vi + k7 * acc + k1 * a.accPrev;
+      a.accPrev = acc;
+      const float vel = a.vhp.run(a.vi);
+      a.di = _leak * a.di + k7 * vel + k1 * a.velPrev;
+      a.velPrev = vel;
+      const float d = a.dhp.run(a.di);
+      if (take)
+      {
+        a.ss += (double)vel * vel;
+        if (d < a.dMin)
+          a.dMin = d;
+        if (d > a.dMax)
+          a.dMax = d;
+      }
+    }
+    _n++;
+    if (take)
+      _used++;
+  }
+
+  // Call before the data ends if the total is known and short: keeps the
+  // skipped start to at most a quarter of it.
+  void expect(uint32_t samples)
+  {
+    if (_settle > samples / 4)
+      _settle = samples / 4;
+  }
+
+  // Rolling windows: statistics restart, the filters keep running.
+  void clearStats()
+  {
+    for (Axis &a : _ax)
+    {
+      a.ss = 0;
+      a.dMin = INFINITY;
+      a.dMax = -INFINITY;
+    }
+    _used = 0;
+  }
+
+  uint32_t used() const { return _used; }
+  double velSumSq(uint8_t axis) const { return _ax[axis].ss; }
+  float dispMinUm(uint8_t axis) const { return _ax[axis].dMin * 1000.0f; }
+  float dispMaxUm(uint8_t axis) const { return _ax[axis].dMax * 1000.0f; }
+  float velRmsMms(uint8_t axis) const { return _used ? (float)sqrt(_ax[axis].ss / _used) : 0.0f; }
+  float dispPpUm(uint8_t axis) const { return _used ? (_ax[axis].dMax - _ax[axis].dMin) * 1000.0f : 0.0f; }
+  // Overall value: the largest axis (ISO rates the worst measurement direction).
+  float velRmsMaxMms() const
+  {
+    float m = 0;
+    for (uint8_t i = 0; i < 3; i++)
+      if (velRmsMms(i) > m)
+        m = velRmsMms(i);
+    return m;
+  }
+
+private:
+  struct Axis
+  {
+    SvfSection ahp, vhp, dhp, lp;
+    float accPrev = 0, vi = 0, velPrev = 0, di = 0; // integrator states
+    double ss = 0;
+    float dMin = 0, dMax = 0;
+  };
+
+  Axis _ax[3];
+  float _dt = 0, _fLo = 10, _fHi = 1000, _leak = 1;
+  bool _lp = false;
+  bool _ok = false;
+  uint32_t _settle = 0;
+  uint32_t _n = 0;
+  uint32_t _used = 0;
+};
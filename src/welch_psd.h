@@ -0,0 +1,258 @@
+#pragma once
+
+// Welch averaged spectrum, fed sample by sample so a whole recording streams
+// through one segment buffer: segments of n samples overlapping by
+// `overlap`, mean removed (gravity would otherwise leak through the window
+// sidelobes), windowed, real FFT (fft_f32.h), |X|^2 accumulated.
+// Up to WELCH_MAX_CHANNELS channels (e.g. X, Y, Z, |a|) advance together
+// and share the window table and the FFT scratch, so one pass over a file
+// gives every spectrum. Channels go through the FFT two at a time: a + i b
+// in one n-point complex FFT, separated by symmetry afterwards.
+// Memory: n floats per channel + n/2+1 sums per channel + window + work
+// (n floats, 2n with more than one channel).
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fft_f32.h"
+
+enum class FftWindow : uint8_t
+{
+  Rect,
+  Hann,
+  Hamming,
+  Blackman,
+  FlatTop, // amplitude-accurate peaks
+};
+
+inline const char *fftWindowName(FftWindow w)
+{
+  switch (w)
+  {
+  case FftWindow::Rect:
+    return "rect";
+  case FftWindow::Hamming:
+    return "hamming";
+  case FftWindow::Blackman:
+    return "blackman";
+  case FftWindow::FlatTop:
+    return "flattop";
+  default:
+    return "hann";
+  }
+}
+
+inline bool fftWindowFromName(const char *s, FftWindow &out)
+{
+  static const FftWindow all[] = {FftWindow::Rect, FftWindow::Hann, FftWindow::Hamming, FftWindow::Blackman,
+                                  FftWindow::FlatTop};
+  for (FftWindow w : all)
+    if (strcmp(s, fftWindowName(w)) == 0)
+    {
+      out = w;
+      return true;
+    }
+  return false;
+}
+
+// w[i] of an n-point periodic window (n power of two <= FFT_MAX_N)
+inline float fftWindowAt(FftWindow w, uint32_t i, uint32_t n)
+{
+  if (w == FftWindow::Rect)
+    return 1.0f;
+  const uint32_t k = i * (FFT_MAX_N / n); // angle 2*pi*i/n in table steps
+  float c1, c2, c3, c4, s;
+  fftTwiddle(k, c1, s);
+  switch (w)
+  {
+  case FftWindow::Hamming:
+    return 0.54f - 0.46f * c1;
+  case FftWindow::Blackman:
+    fftTwiddle((2 * k) % FFT_MAX_N, c2, s);
+    return 0.42f - 0.5f * c1 + 0.08f * c2;
+  case FftWindow::FlatTop:
+    fftTwiddle((2 * k) % FFT_MAX_N, c2, s);
+    fftTwiddle((3 * k) % FFT_MAX_N, c3, s);
+    fftTwiddle((4 * k) % FFT_MAX_N, c4, s);
+    return 0.21557895f - 0.41663158f * c1 + 0.277263158f * c2 - 0.083578947f * c3 + 0.006947368f * c4;
+  default:
+    return 0.5f - 0.5f * c1;
+  }
+}
+
+static const uint8_t WELCH_MAX_CHANNELS = 4;
+
+inline size_t welchBytes(uint32_t n, uint8_t channels)
+{
+  return ((size_t)channels * (n + n / 2 + 1) + (channels > 1 ? 3 : 2) * (size_t)n) * sizeof(float);
+}
+
+class WelchPsd
+{
+public:
+  WelchPsd() = default;
+  WelchPsd(const WelchPsd &) = delete;
+  WelchPsd &operator=(const WelchPsd &) = delete;
+  ~WelchPsd() { end(); }
+
+  // n: power of two, 16 .. FFT_MAX_N; overlap < n.
+  bool begin(uint32_t n, FftWindow win, uint32_t overlap, uint8_t channels = 1)
+  {
+    end();
+    if (n < 16 || !fftSizeOk(n) || overlap >= n || channels < 1 || channels > WELCH_MAX_CHANNELS)
+      return false;
+    _n = n;
+    _hop = n - overlap;
+    _ch = channels;
+    _win = win;
+    _seg = (float *)malloc((size_t)channels * n * sizeof(float));
+    _acc = (float *)calloc((size_t)channels * (n / 2 + 1), sizeof(float));
+    _work = (float *)malloc((channels > 1 ? 2 : 1) * n * sizeof(float));
+    _w = (float *)malloc(n * sizeof(float));
+    if (!_seg || !_acc || !_work || !_w)
+    {
+      end();
+      return false;
+    }
+    _s1 = _s2 = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+      _w[i] = fftWindowAt(win, i, n);
+      _s1 += _w[i];
+      _s2 += (double)_w[i] * _w[i];
+    }
+    _fill = 0;
+    _segments = 0;
+    return true;
+  }
+
+  void end()
+  {
+    free(_seg);
+    free(_acc);
+    free(_work);
+    free(_w);
+    _seg = _acc = _work = _w = nullptr;
+    _n = 0;
+  }
+
+  // Single channel.
+  void push(const float *x, size_t k) { push(&x, k); }
+
+  // x[c]: k samples of channel c, for every channel.
+  void push(const float *const *x, size_t k)
+  {
+    size_t off = 0;
+    while (k)
+    {
+      size_t take = _n - _fill;
+      if (take > k)
+        take = k;
+      for (uint8_t c = 0; c < _ch; c++)
+        memcpy(_seg + c * _n + _fill, x[c] + off, take * sizeof(float));
+      _fill += take;
+      off += take;
+      k -= take;
+      if (_fill == _n)
+      {
+        uint8_t c = 0;
+        for (; c + 1 < _ch; c += 2)
+          segmentPair(c);
+        if (c < _ch)
+          segment(c);
+        for (c = 0; c < _ch; c++)
+          memmove(_seg + c * _n, _seg + c * _n + _hop, (_n - _hop) * sizeof(float));
+        _segments++;
+        _fill = _n - _hop;
+      }
+    }
+  }
+
+  uint32_t n() const { return _n; }
+  uint32_t bins() const { return _n / 2 + 1; }
+  uint8_t channels() const { return _ch; }
+  uint32_t segments() const { return _segments; }
+  FftWindow window() const { return _win; }
+  // equivalent noise bandwidth in bins
+  float enbw() const { return _s1 > 0 ? (float)(_n * _s2 / (_s1 * _s1)) : 0.0f; }
+
+  // One-sided PSD of bin k (0 .. n/2), units^2/Hz.
+  float psdAt(uint32_t k, float fs, uint8_t ch = 0) const
+  {
+    if (!_segments || fs <= 0)
+      return 0.0f;
+    const double side = (k == 0 || k == _n / 2) ? 1.0 : 2.0;
+    return (float)(_acc[ch * bins() + k] * side / ((double)_segments * fs * _s2));
+  }
+
+  // Peak amplitude a sine centred on bin k would have (RMS-averaged over
+  // segments), units.
+  float amplitudeAt(uint32_t k, uint8_t ch = 0) const
+  {
+    if (!_segments)
+      return 0.0f;
+    const double side = (k == 0 || k == _n / 2) ? 1.0 : 2.0;
+    return (float)(sqrt(_acc[ch * bins() + k] / (double)_segments) * side / _s1);
+  }
+
+private:
+  float mean(uint8_t c) const
+  {
+    const float *seg = _seg + c * _n;
+    float m = 0;
+    for (uint32_t i = 0; i < _n; i++)
+      m += seg[i];
+    return m / (float)_n;
+  }
+
+  void segment(uint8_t c)
+  {
+    const float *seg = _seg + c * _n;
+    float *acc = _acc + c * bins();
+    const float mean = this->mean(c);
+    for (uint32_t i = 0; i < _n; i++)
+      _work[i] = (seg[i] - mean) * _w[i];
+    fftReal(_work, _n);
+    acc[0] += _work[0] * _work[0];
+    acc[_n / 2] += _work[1] * _work[1];
+    for (uint32_t i = 1; i < _n / 2; i++)
+      acc[i] += _work[2 * i] * _work[2 * i] + _work[2 * i + 1] * _work[2 * i + 1];
+  }
+
+  // Channels c, c+1 as Z = FFT(a + i b):
+  // A[k] = (Z[k] + conj Z[n-k]) / 2, B[k] = (Z[k] - conj Z[n-k]) / 2i
+  void segmentPair(uint8_t c)
+  {
+    const float *sa = _seg + c * _n, *sb = sa + _n;
+    float *accA = _acc + c * bins(), *accB = accA + bins();
+    const float ma = mean(c), mb = mean(c + 1);
+    for (uint32_t i = 0; i < _n; i++)
+    {
+      _work[2 * i] = (sa[i] - ma) * _w[i];
+      _work[2 * i + 1] = (sb[i] - mb) * _w[i];
+    }
+    fftComplex(_work, _n);
+    accA[0] += _work[0] * _work[0];
+    accB[0] += _work[1] * _work[1];
+    for (uint32_t k = 1; k <= _n / 2; k++)
+    {
+      const float *p = _work + 2 * k, *q = _work + 2 * (_n - k);
+      const float ar = p[0] + q[0], ai = p[1] - q[1];
+      const float br = p[1] + q[1], bi = p[0] - q[0];
+      accA[k] += 0.25f * (ar * ar + ai * ai);
+      accB[k] += 0.25f * (br * br + bi * bi);
+    }
+  }
+
+  float *_seg = nullptr;  // _ch rows of _n
+  float *_acc = nullptr;  // _ch rows of bins()
+  float *_work = nullptr; // FFT scratch, shared by the channels (n complex when pairing)
+  float *_w = nullptr;    // window, shared by the channels
+  uint32_t _n = 0;
+  uint32_t _hop = 0;
+  uint32_t _fill = 0;
+  uint32_t _segments = 0;
+  uint8_t _ch = 1;
+  FftWindow _win = FftWindow::Hann;
+  double _s1 = 0, _s2 = 0;
+};
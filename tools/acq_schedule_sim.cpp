@@ -0,0 +1,203 @@
+// Host check for src/acq_schedule.h: the capture loop's drain / sleep
+// decision (AcqPacer) against a simulated edge source, with the LIS2DW12
+// mock bus as the FIFO. Every source runs at several ODRs with all edges,
+// with every 5th edge lost and with a dead INT1 pin; the timeout guard has
+// to keep the FIFO from overrunning and no sample may be lost. With every
+// edge delivered, no wait may end in a timeout.
+//
+//   g++ -O2 -std=c++17 -Isrc -Ilib/LIS2DW12_ESP32/src tools/acq_schedule_sim.cpp lib/LIS2DW12_ESP32/src/LIS2DW12_ESP32.cpp -o acq_schedule_sim && ./acq_schedule_sim
+//
+// Time model: 1 ms RTOS tick (a timed-out wait ends on a tick boundary),
+// I2C at 1 MHz (~60 us per FIFO sample, 100 us per transaction), 30 us
+// from notification to running task.
+#include <cstdio>
+
+#include "LIS2DW12_ESP32.h"
+#include "acq_schedule.h"
+
+static const int64_t TICK_US = 1000;
+static const int64_t TX_US = 100;
+static const int64_t SAMPLE_US = 60;
+static const int64_t WAKE_US = 30;
+
+struct Result
+{
+  uint64_t samples = 0, lost = 0;
+  uint32_t overruns = 0, wakeups = 0, timeouts = 0, jitterMaxUs = 0;
+  uint8_t maxLevel = 0;
+};
+
+class EdgeSim
+{
+public:
+  EdgeSim(AcqSource src, uint16_t hz, const AcqSchedule &sch, uint32_t missEvery, bool deadPin)
+      : _src(src), _hz(hz), _sch(sch), _missEvery(missEvery), _deadPin(deadPin)
+  {
+    _lis.begin();
+    _lis.setFifo(LIS2DW12Base::FifoMode::Bypass);
+    _lis.setFifo(LIS2DW12Base::FifoMode::Continuous, sch.wtm);
+    _nextTimerUs = sch.periodUs;
+  }
+
+  Result run(int64_t durationUs)
+  {
+    AcqPacer pacer(_sch);
+    Result r;
+    int16_t buf[LIS2DW12Base::FIFO_DEPTH][3];
+    while (_now < durationUs)
+    {
+      // ---- drain, as captureBlocks does ----
+      LIS2DW12Base::FifoStatus st;
+      _lis.readFifoStatus(st);
+      advance(_now + TX_US);
+      if (st.overrun)
+        r.overruns++;
+      if (st.level > r.maxLevel)
+        r.maxLevel = st.level;
+      if (st.level)
+      {
+        _lis.readFifoBurst(buf, st.level);
+        refreshPin();
+        for (uint8_t i = 0; i < st.level; i++)
+        {
+          if (buf[i][0] != (int16_t)(_readSeq % 8192))
+          {
+            // continuous FIFO dropped the oldest ones: resync on the data
+            r.lost += (uint16_t)((buf[i][0] - _readSeq % 8192 + 8192) % 8192);
+            _readSeq += (uint16_t)((buf[i][0] - _readSeq % 8192 + 8192) % 8192);
+          }
+          _readSeq++;
+        }
+        r.samples += st.level;
+        advance(_now + TX_US + st.level * SAMPLE_US);
+      }
+
+      // ---- sleep decision ----
+      if (!pacer.shouldWait(st.level))
+        continue;
+      const bool woke = wait();
+      uint32_t jitterUs;
+      if (pacer.waited(woke, _now, jitterUs) && jitterUs > r.jitterMaxUs)
+        r.jitterMaxUs = jitterUs;
+    }
+    r.wakeups = pacer.wakeups();
+    r.timeouts = pacer.timeouts();
+    return r;
+  }
+
+private:
+  AcqSource _src;
+  uint16_t _hz;
+  AcqSchedule _sch;
+  uint32_t _missEvery;
+  bool _deadPin;
+  LIS2DW12_Host _lis;
+  int64_t _now = 0;
+  uint64_t _nextSample = 1; // sample k is taken at k / hz
+  int64_t _nextTimerUs;
+  uint32_t _writeSeq = 0, _readSeq = 0;
+  uint32_t _edges = 0, _edgesLost = 0;
+  bool _pin = false;     // INT1 level for the FTH source
+  bool _pending = false; // task notification
+
+  int64_t sampleUs(uint64_t k) const { return (int64_t)(k * 1000000ULL / _hz); }
+
+  void edge()
+  {
+    _edges++;
+    if (_deadPin && acqSourceNeedsInt1(_src))
+      _edgesLost++;
+    else if (_missEvery && _edges % _missEvery == 0)
+      _edgesLost++;
+    else
+      _pending = true;
+  }
+
+  void refreshPin() { _pin = _lis.bus().fifoLevel() >= _sch.wtm; }
+
+  // Sensor samples and timer ticks up to t.
+  void advance(int64_t t)
+  {
+    for (;;)
+    {
+      const int64_t ts = sampleUs(_nextSample);
+      const bool timer = _src == AcqSource::Timer || _src == AcqSource::Sim;
+      if (ts <= t && (!timer || ts <= _nextTimerUs))
+      {
+        const int16_t v = (int16_t)(_writeSeq++ % 8192);
+        _lis.bus().pushSample((int16_t)(v * 4), 0, 0);
+        _nextSample++;
+        if (_src == AcqSource::Int1Drdy)
+          edge();
+        else if (_src == AcqSource::Int1Fifo && !_pin && _lis.bus().fifoLevel() >= _sch.wtm)
+        {
+          _pin = true;
+          edge();
+        }
+      }
+      else if (timer && _nextTimerUs <= t)
+      {
+        edge();
+        _nextTimerUs += _sch.periodUs;
+      }
+      else
+        break;
+    }
+    _now = t;
+  }
+
+  // ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs))
+  bool wait()
+  {
+    const int64_t deadline = (_now + _sch.timeoutMs * 1000 + TICK_US - 1) / TICK_US * TICK_US;
+    while (!_pending)
+    {
+      int64_t next = sampleUs(_nextSample);
+      if ((_src == AcqSource::Timer || _src == AcqSource::Sim) && _nextTimerUs < next)
+        next = _nextTimerUs;
+      if (next >= deadline)
+      {
+        advance(deadline);
+        return false;
+      }
+      advance(next);
+    }
+    _pending = false;
+    advance(_now + WAKE_US);
+    return true;
+  }
+};
+
+int main()
+{
+  const AcqSource srcs[] = {AcqSource::Timer, AcqSource::Int1Fifo, AcqSource::Int1Drdy, AcqSource::Sim};
+  const char *names[] = {"timer", "int1_fifo", "int1_drdy", "sim"};
+  const uint16_t rates[] = {12, 100, 400, 800, 1600};
+  struct Mode
+  {
+    const char *name;
+    uint32_t missEvery;
+    bool deadPin;
+  } modes[] = {{"all edges", 0, false}, {"1/5 lost", 5, false}, {"dead pin", 0, true}};
+
+  int fails = 0;
+  printf("%-10s %5s %-10s %9s %5s %7s %8s %8s %6s %8s\n", "source", "hz", "edges", "samples", "lost", "ovr",
+         "wakeups", "timeouts", "maxlvl", "jitter");
+  for (int s = 0; s < 4; s++)
+    for (uint16_t hz : rates)
+      for (const Mode &m : modes)
+      {
+        if (m.deadPin && !acqSourceNeedsInt1(srcs[s]))
+          continue;
+        const AcqSchedule sch = acqScheduleFor(srcs[s], hz, LIS2DW12Base::FIFO_DEPTH);
+        EdgeSim sim(srcs[s], hz, sch, m.missEvery, m.deadPin);
+        const Result r = sim.run(hz < 100 ? 60000000 : 10000000);
+        const bool ok = !r.lost && !r.overruns && r.samples > 0 && (m.missEvery || m.deadPin || !r.timeouts);
+        fails += !ok;
+        printf("%-10s %5u %-10s %9llu %5llu %7u %8u %8u %6u %6u us%s\n", names[s], hz, m.name,
+               (unsigned long long)r.samples, (unsigned long long)r.lost, r.overruns, r.wakeups, r.timeouts, r.maxLevel,
+               r.jitterMaxUs, ok ? "" : "  FAIL");
+      }
+  printf("%s (%d failed)\n", fails ? "FAILED" : "all passed", fails);
+  return fails;
+}
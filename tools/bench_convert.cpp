@@ -0,0 +1,117 @@
+// Host micro-benchmark: per-sample raw->g (switch + divide + cal per value,
+// as analyze/FFT used to do) vs the batch kernel in src/sample_convert.h.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/bench_convert.cpp -o bench_convert && ./bench_convert
+//
+// Host numbers only show the relative cost; on the ESP32 the batch kernel
+// additionally maps to one madd.s per value on the Xtensa FPU.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "sample_convert.h"
+
+// ---- reference: the old per-sample path ----
+static float mgPerLsbRef(uint8_t res_bits, uint8_t fs_g)
+{
+  const bool is12 = (res_bits == 12);
+  switch (fs_g)
+  {
+  case 2:
+    return is12 ? 0.976f : 0.244f;
+  case 4:
+    return is12 ? 1.952f : 0.488f;
+  case 8:
+    return is12 ? 3.904f : 0.976f;
+  case 16:
+    return is12 ? 7.808f : 1.952f;
+  default:
+    return is12 ? 0.976f : 0.244f;
+  }
+}
+
+__attribute__((noinline)) static float rawAlignedToGRef(int16_t raw, uint8_t res_bits, uint8_t fs_g)
+{
+  float mg = mgPerLsbRef(res_bits, fs_g);
+  return (float)raw * (mg / 1000.0f);
+}
+
+__attribute__((noinline)) static float applyCal1Ref(float g, float offset, float scale)
+{
+  return (g - offset) * scale;
+}
+
+static void convertRef(const Sample6 *in, size_t n, const FileHeaderV3 &h, float *x, float *y, float *z)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    x[i] = applyCal1Ref(rawAlignedToGRef(in[i].ax, h.res_bits, h.fs_g), h.cal_offset_g[0], h.cal_scale[0]);
+    y[i] = applyCal1Ref(rawAlignedToGRef(in[i].ay, h.res_bits, h.fs_g), h.cal_offset_g[1], h.cal_scale[1]);
+    z[i] = applyCal1Ref(rawAlignedToGRef(in[i].az, h.res_bits, h.fs_g), h.cal_offset_g[2], h.cal_scale[2]);
+  }
+}
+
+template <class Fn>
+static double samplesPerSec(Fn fn, size_t n, int reps)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; r++)
+    fn();
+  auto t1 = std::chrono::steady_clock::now();
+  double s = std::chrono::duration<double>(t1 - t0).count();
+  return (double)n * reps / s;
+}
+
+int main()
+{
+  const size_t N = 256; // same block size as ANALYZE_BLOCK
+  const int REPS = 200000;
+
+  FileHeaderV3 h{};
+  h.res_bits = 14;
+  h.fs_g = 4;
+  h.cal_offset_g[0] = 0.012f;
+  h.cal_offset_g[1] = -0.020f;
+  h.cal_offset_g[2] = 0.031f;
+  h.cal_scale[0] = 1.003f;
+  h.cal_scale[1] = 0.997f;
+  h.cal_scale[2] = 1.010f;
+
+  std::vector<Sample6> in(N);
+  srand(1);
+  for (auto &s : in)
+  {
+    s.ax = (int16_t)((rand() & 0x3FFF) - 0x2000);
+    s.ay = (int16_t)((rand() & 0x3FFF) - 0x2000);
+    s.az = (int16_t)((rand() & 0x3FFF) - 0x2000);
+  }
+
+  std::vector<float> rx(N), ry(N), rz(N), bx(N), by(N), bz(N);
+  const ConvCoeffs cc = convCoeffsFromHeader(h);
+
+  // correctness first
+  convertRef(in.data(), N, h, rx.data(), ry.data(), rz.data());
+  convertSamples(in.data(), N, h.res_bits, h.fs_g, cc, bx.data(), by.data(), bz.data());
+  double maxErr = 0;
+  for (size_t i = 0; i < N; i++)
+  {
+    maxErr = std::fmax(maxErr, std::fabs(rx[i] - bx[i]));
+    maxErr = std::fmax(maxErr, std::fabs(ry[i] - by[i]));
+    maxErr = std::fmax(maxErr, std::fabs(rz[i] - bz[i]));
+  }
+
+  volatile float sink = 0;
+  double ref = samplesPerSec([&]
+                             { convertRef(in.data(), N, h, rx.data(), ry.data(), rz.data()); sink = sink + rx[N - 1]; },
+                             N, REPS);
+  double bat = samplesPerSec([&]
+                             { convertSamples(in.data(), N, h.res_bits, h.fs_g, cc, bx.data(), by.data(), bz.data()); sink = sink + bx[N - 1]; },
+                             N, REPS);
+
+  printf("max |ref - batch| = %.3g g\n", maxErr);
+  printf("per-sample : %8.1f Msamples/s\n", ref / 1e6);
+  printf("batch      : %8.1f Msamples/s  (x%.2f)\n", bat / 1e6, bat / ref);
+  return maxErr < 1e-5 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// Host check + micro-benchmark of the decimation stage (src/decimator.h):
+// fixed-point output against a double-precision reference of the same
+// filter, DC / passband / stopband gain, time alignment and output counts
+// for every factor, and CPU cost per input sample (all three axes).
+//
+//   g++ -O2 -std=c++17 -Isrc tools/bench_decim.cpp -o bench_decim && ./bench_decim
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "decimator.h"
+
+static const size_t N = 1 << 15;
+
+static std::vector<Sample6> sine(double cyclesPerSample, double amp, int16_t dc)
+{
+  std::vector<Sample6> s(N);
+  for (size_t i = 0; i < N; i++)
+  {
+    const double v = amp * sin(2 * M_PI * cyclesPerSample * i);
+    s[i].ax = (int16_t)lround(v + dc);
+    s[i].ay = (int16_t)lround(-v);
+    s[i].az = dc;
+  }
+  return s;
+}
+
+static std::vector<Sample6> run(uint8_t M, const std::vector<Sample6> &in, size_t chunk)
+{
+  RecDecimator d;
+  d.begin(M);
+  std::vector<Sample6> out(in.size() / M + DECIM_DELAY_OUT + 2);
+  size_t k = 0;
+  for (size_t i = 0; i < in.size(); i += chunk)
+    k += d.push(&in[i], std::min(chunk, in.size() - i), &out[k]);
+  k += d.flush(&out[k]);
+  out.resize(k);
+  return out;
+}
+
+// same filter, same priming / alignment, in double
+static std::vector<double> reference(uint8_t M, const std::vector<Sample6> &in)
+{
+  uint16_t L;
+  const int16_t *h = decimTaps(M, L);
+  std::vector<double> out;
+  auto x = [&](long i) { return (double)in[i < 0 ? 0 : (i >= (long)in.size() ? in.size() - 1 : i)].ax; };
+  for (size_t m = 0; m * M < in.size(); m++)
+  {
+    const long j = (long)((m + DECIM_DELAY_OUT) * M); // input index that completes output m
+    double acc = 0;
+    for (uint16_t t = 0; t < L; t++)
+      acc += h[t] / 32768.0 * x(j - t);
+    out.push_back(acc);
+  }
+  return out;
+}
+
+// steady state only: skips start-up and the flushed tail (held last sample)
+static double rms(const std::vector<Sample6> &s, int16_t Sample6::*axis, double dc)
+{
+  const size_t from = 40, to = s.size() - 40;
+  double acc = 0;
+  for (size_t i = from; i < to; i++)
+    acc += (s[i].*axis - dc) * (s[i].*axis - dc);
+  return sqrt(acc / (double)(to - from));
+}
+
+int main()
+{
+  int failures = 0;
+  auto check = [&](bool ok, const char *what, uint8_t M, double v) {
+    if (!ok)
+    {
+      printf("FAIL /%u %s: %g\n", M, what, v);
+      failures++;
+    }
+  };
+
+  for (uint8_t M : DECIM_FACTORS)
+  {
+    uint16_t L;
+    const int16_t *h = decimTaps(M, L);
+    int32_t sum = 0, sumAbs = 0;
+    bool sym = true;
+    for (uint16_t i = 0; i < L; i++)
+    {
+      sum += h[i];
+      sumAbs += h[i] < 0 ? -h[i] : h[i];
+      sym = sym && h[i] == h[L - 1 - i];
+    }
+    check(sum == 32768, "DC gain (tap sum)", M, sum);
+    check(sym, "taps symmetric", M, 0);
+    check((int64_t)sumAbs * 32768 < INT32_MAX, "accumulator headroom", M, sumAbs);
+
+    // DC (gravity) passes exactly, including the first outputs (priming)
+    std::vector<Sample6> out = run(M, std::vector<Sample6>(N, Sample6{4096, -4096, 8191}), 256);
+    check(out.size() == (N + M - 1) / M, "output count", M, (double)out.size());
+    bool dcOk = true;
+    for (const Sample6 &s : out)
+      dcOk = dcOk && s.ax == 4096 && s.ay == -4096 && s.az == 8191;
+    check(dcOk, "DC exact", M, 0);
+
+    // odd chunk sizes give the same stream as whole blocks
+    const std::vector<Sample6> in = sine(0.3 / M, 6000, 1000);
+    std::vector<Sample6> a = run(M, in, 256), b = run(M, in, 7);
+    bool same = a.size() == b.size();
+    for (size_t i = 0; same && i < a.size(); i++)
+      same = a[i].ax == b[i].ax && a[i].ay == b[i].ay && a[i].az == b[i].az;
+    check(same, "chunking independent", M, 0);
+
+    // fixed point vs double reference
+    std::vector<double> ref = reference(M, in);
+    double maxErr = 0;
+    for (size_t i = 0; i < a.size() && i < ref.size(); i++)
+      maxErr = std::max(maxErr, fabs(a[i].ax - ref[i]));
+    check(ref.size() == a.size() && maxErr <= 1.0, "max |fixed - double| (LSB)", M, maxErr);
+
+    // alignment: output m ~ input m*M + 0.5 for a passband sine
+    double alignErr = 0;
+    for (size_t m = 40; m + 40 < a.size(); m++)
+    {
+      const double t = m * M + 0.5;
+      alignErr = std::max(alignErr, fabs(a[m].ax - (6000 * sin(2 * M_PI * 0.3 / M * t) + 1000)));
+    }
+    check(alignErr < 6000 * 0.002 + 2, "alignment error (LSB)", M, alignErr);
+
+    // passband gain 0.3 fs_out, stopband 0.65 fs_out (aliases onto 0.35)
+    const double gPass = 20 * log10(rms(a, &Sample6::ax, 1000) / (6000 / sqrt(2.0)));
+    std::vector<Sample6> stop = run(M, sine(0.65 / M, 16000, 0), 256);
+    const double gStop = 20 * log10(rms(stop, &Sample6::ax, 0) / (16000 / sqrt(2.0)) + 1e-12);
+    check(fabs(gPass) < 0.05, "passband gain dB", M, gPass);
+    check(gStop < -55, "stopband gain dB", M, gStop);
+
+    // cost per input sample, 3 axes
+    RecDecimator d;
+    d.begin(M);
+    std::vector<Sample6> sink(REC_V4_BLOCK_MAX / M + 1);
+    const size_t reps = 200;
+    volatile int16_t keep = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < reps; r++)
+      for (size_t i = 0; i < N; i += REC_V4_BLOCK_MAX)
+      {
+        d.push(&in[i], REC_V4_BLOCK_MAX, sink.data());
+        keep = sink[0].ax;
+      }
+    auto t1 = std::chrono::steady_clock::now();
+    (void)keep;
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)(reps * N);
+
+    printf("/%-2u L=%3u: %.2f ns/input sample (%u MAC/sample/axis), max err %.2f LSB, "
+           "pass %+.3f dB, stop %.1f dB, align %.1f LSB\n",
+           M, L, ns, L / M, maxErr, gPass, gStop, alignErr);
+  }
+
+  printf(failures ? "decimator: FAILED\n" : "decimator: ok\n");
+  return failures ? 1 : 0;
+}
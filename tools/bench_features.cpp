@@ -0,0 +1,158 @@
+// Host check + micro-benchmark of the recording features (src/rec_features.h):
+//  - block-merged moments against a two-pass double reference on a long
+//    signal with a large offset (gravity), a sine and noise, fed in blocks
+//    of uneven size
+//  - kurtosis of a sine (1.5), Gaussian noise (3) and sparse impacts (> 3)
+//  - clipping at the code limits, with and without q_bits quantisation
+//  - histogram counts add up, calibrated stats match the raw ones
+//  - cost per sample (3 axes)
+//
+//   g++ -O2 -std=c++17 -Isrc tools/bench_features.cpp -o bench_features && ./bench_features
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "rec_features.h"
+
+static void feed(RecFeatures &f, const std::vector<Sample6> &s, std::mt19937 &rng)
+{
+  std::uniform_int_distribution<int> len(1, 256);
+  for (size_t i = 0; i < s.size();)
+  {
+    const size_t n = std::min<size_t>(len(rng), s.size() - i);
+    recFeaturesAdd(f, &s[i], n);
+    i += n;
+  }
+}
+
+static bool close(double a, double b, double tol) { return fabs(a - b) <= tol * (fabs(b) + 1e-12); }
+
+int main()
+{
+  int failures = 0;
+  std::mt19937 rng(11);
+  std::normal_distribution<double> gauss(0.0, 1.0);
+
+  // ---- moments vs two-pass ----
+  {
+    const uint32_t total = 1600 * 600; // 10 min at 1600 Hz
+    std::vector<Sample6> s(total);
+    for (uint32_t i = 0; i < total; i++)
+    {
+      const double t = i / 1600.0;
+      s[i].ax = (int16_t)lround(300 * sin(2 * M_PI * 49.3 * t) + 20 * gauss(rng));
+      s[i].ay = (int16_t)lround(-120 + 40 * gauss(rng) + (i % 997 == 0 ? 3000 : 0));
+      s[i].az = (int16_t)lround(4096 + 8 * gauss(rng)); // 1 g at 14 bit / 2 g
+    }
+    RecFeatures f;
+    recFeaturesBegin(f, 14, 0);
+    feed(f, s, rng);
+
+    bool ok = f.n == total;
+    for (int a = 0; a < 3; a++)
+    {
+      double mean = 0;
+      for (const Sample6 &x : s)
+        mean += (&x.ax)[a];
+      mean /= total;
+      double m2 = 0, m3 = 0, m4 = 0;
+      for (const Sample6 &x : s)
+      {
+        const double d = (&x.ax)[a] - mean;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+      }
+      const RecFeatureAxis &r = f.axis[a];
+      const double skewRef = m3 / total / pow(m2 / total, 1.5), kurtRef = m4 / total / pow(m2 / total, 2);
+      const RecFeatureStats st = recFeatureStats(f, a, 1.0f, 0.0f);
+      const bool axOk = close(r.mean, mean, 1e-9) && close(r.m2, m2, 1e-6) && close(r.m4, m4, 1e-5) &&
+                        fabs(st.skew - skewRef) < 1e-3 && close(st.kurt, kurtRef, 1e-4);
+      ok = ok && axOk;
+      printf("axis %d: mean %.4f (ref %.4f), std %.3f, skew %.4f (ref %.4f), kurt %.4f (ref %.4f)%s\n", a,
+             r.mean, mean, sqrt(m2 / total), st.skew, skewRef, st.kurt, kurtRef, axOk ? "" : "  FAIL");
+    }
+    // the three shapes: sine + a little noise ~1.5, noise 3, impacts far above
+    const float kx = recFeatureStats(f, 0, 1, 0).kurt, ky = recFeatureStats(f, 1, 1, 0).kurt,
+                kz = recFeatureStats(f, 2, 1, 0).kurt;
+    ok = ok && fabs(kx - 1.5f) < 0.1f && fabs(kz - 3.0f) < 0.1f && ky > 10;
+    uint32_t histSum = 0;
+    for (uint32_t c : f.axis[2].hist)
+      histSum += c;
+    ok = ok && histSum == total && f.axis[2].hist[(4096 + 8192) >> 9] > total / 2;
+    if (!ok)
+      failures++;
+    printf("kurtosis sine %.2f, noise %.2f, impacts %.1f; histogram %u of %u%s\n", kx, kz, ky, histSum, total,
+           ok ? "" : "  FAIL");
+  }
+
+  // ---- calibrated stats ----
+  {
+    std::vector<Sample6> s(10000);
+    for (size_t i = 0; i < s.size(); i++)
+      s[i] = {(int16_t)lround(500 * sin(i * 0.1)), 0, 4000};
+    RecFeatures f;
+    recFeaturesBegin(f, 14, 0);
+    feed(f, s, rng);
+    const float k = 0.000244f * 1.01f, b = -0.02f;
+    const RecFeatureStats st = recFeatureStats(f, 0, k, b), sz = recFeatureStats(f, 2, k, b);
+    const bool ok = close(st.std, 500 * k / sqrt(2.0), 2e-3) && close(st.crest, sqrt(2.0), 2e-3) &&
+                    close(st.pp, 1000 * k, 1e-3) && close(sz.rms, 4000 * k + b, 1e-5) && sz.std == 0 &&
+                    sz.kurt == 0 && close(st.peak, 500 * k - b, 1e-3);
+    if (!ok)
+      failures++;
+    printf("calibrated sine: std %.5f g, crest %.3f, p-p %.5f g, peak %.5f g; dc axis rms %.5f g%s\n", st.std,
+           st.crest, st.pp, st.peak, sz.rms, ok ? "" : "  FAIL");
+  }
+
+  // ---- clipping ----
+  {
+    bool ok = true;
+    for (uint8_t shift : {0, 2})
+    {
+      const int16_t mask = (int16_t)(0xFFFF << shift);
+      std::vector<Sample6> s(4096);
+      uint32_t hi = 0, lo = 0;
+      for (size_t i = 0; i < s.size(); i++)
+      {
+        long v = lround(9000 * sin(i * 0.01)); // beyond 14-bit full scale
+        v = v > 8191 ? 8191 : v < -8192 ? -8192 : v;
+        s[i] = {(int16_t)(v & mask), 0, 0};
+        // stored at a limit code: quantisation folds the last 2^shift codes in
+        hi += v >= (8191 & mask);
+        lo += (v & mask) == -8192;
+      }
+      RecFeatures f;
+      recFeaturesBegin(f, 14, shift);
+      feed(f, s, rng);
+      const bool sOk = f.axis[0].clipHi == hi && f.axis[0].clipLo == lo && hi > 0 && lo > 0 &&
+                       f.axis[1].clipLo + f.axis[1].clipHi == 0;
+      ok = ok && sOk;
+      printf("clipping, %u bit quantisation: %u high / %u low (expect %u / %u)%s\n", 14 - shift,
+             f.axis[0].clipHi, f.axis[0].clipLo, hi, lo, sOk ? "" : "  FAIL");
+    }
+    if (!ok)
+      failures++;
+  }
+
+  // ---- cost ----
+  {
+    std::vector<Sample6> s(256);
+    for (size_t i = 0; i < s.size(); i++)
+      s[i] = {(int16_t)(i * 7), (int16_t)(-i * 3), (int16_t)(4096 + i)};
+    RecFeatures f;
+    recFeaturesBegin(f, 14, 0);
+    const uint32_t blocks = 20000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t b = 0; b < blocks; b++)
+      recFeaturesAdd(f, s.data(), s.size());
+    auto t1 = std::chrono::steady_clock::now();
+    printf("%.2f ns per sample (3 axes), %zu B chunk\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / (blocks * 256.0), sizeof(RecFeatures));
+  }
+
+  printf(failures ? "features: FAILED\n" : "features: ok\n");
+  return failures ? 1 : 0;
+}
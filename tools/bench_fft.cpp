@@ -0,0 +1,370 @@
+// Host check + benchmark of the float32 FFT (src/fft_f32.h) and the Welch
+// estimator (src/welch_psd.h):
+//  - fftReal against a long double DFT (relative error) for N = 16 .. 4096
+//  - time per N-point real transform next to arduinoFFT 1.6's double
+//    Compute() + ComplexToMagnitude() (transcribed below, the library itself
+//    is only fetched by PlatformIO) for N = 512 .. 4096. On the host double
+//    is hardware; on the ESP32 it is emulated, so the device gap is larger.
+//  - Welch: sine amplitude and white-noise PSD level per window
+//  - STFT frames (src/stft.h): a chirp's ridge follows the sweep, tone level
+//    in dB, frame count for hop below / above n, memory per frame
+//  - /api/fft work for a V4 recording: three single-axis passes (decode,
+//    convert, Welch) against one axis=all pass (x + i y in one complex FFT),
+//    with and without |a|. The FFTs are per channel, so one pass only saves
+//    the repeated decode / convert: expect (read + 3 fft) / 3 (read + fft),
+//    not 1/3.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/bench_fft.cpp -o bench_fft && ./bench_fft
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "rec_codec.h"
+#include "sample_convert.h"
+#include "stft.h"
+#include "welch_psd.h"
+
+// ---- arduinoFFT 1.6 (Compute forward + ComplexToMagnitude) ----
+static void arduinoFftCompute(double *vReal, double *vImag, uint16_t samples)
+{
+  uint8_t power = 0;
+  while ((1u << power) < samples)
+    power++;
+  uint16_t j = 0;
+  for (uint16_t i = 0; i < (samples - 1); i++)
+  {
+    if (i < j)
+    {
+      double t = vReal[i];
+      vReal[i] = vReal[j];
+      vReal[j] = t;
+    }
+    uint16_t k = (samples >> 1);
+    while (k <= j)
+    {
+      j -= k;
+      k >>= 1;
+    }
+    j += k;
+  }
+  double c1 = -1.0, c2 = 0.0;
+  uint16_t l2 = 1;
+  for (uint8_t l = 0; l < power; l++)
+  {
+    uint16_t l1 = l2;
+    l2 <<= 1;
+    double u1 = 1.0, u2 = 0.0;
+    for (j = 0; j < l1; j++)
+    {
+      for (uint16_t i = j; i < samples; i += l2)
+      {
+        uint16_t i1 = i + l1;
+        double t1 = u1 * vReal[i1] - u2 * vImag[i1];
+        double t2 = u1 * vImag[i1] + u2 * vReal[i1];
+        vReal[i1] = vReal[i] - t1;
+        vImag[i1] = vImag[i] - t2;
+        vReal[i] += t1;
+        vImag[i] += t2;
+      }
+      double z = u1 * c1 - u2 * c2;
+      u2 = u1 * c2 + u2 * c1;
+      u1 = z;
+    }
+    c2 = -sqrt((1.0 - c1) / 2.0);
+    c1 = sqrt((1.0 + c1) / 2.0);
+  }
+  for (uint16_t i = 0; i < samples; i++)
+    vReal[i] = sqrt(vReal[i] * vReal[i] + vImag[i] * vImag[i]);
+}
+
+template <class F>
+static double usPer(F f, int reps)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; r++)
+    f();
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(t1 - t0).count() / reps;
+}
+
+// best of reps: the figures below are ratios, scheduler noise hurts them most
+template <class F>
+static double usMin(F f, int reps)
+{
+  double best = 1e300;
+  for (int r = 0; r < reps; r++)
+  {
+    const double t = usPer(f, 1);
+    if (t < best)
+      best = t;
+  }
+  return best;
+}
+
+int main()
+{
+  int failures = 0;
+  std::mt19937 rng(1);
+  std::normal_distribution<double> gauss(0.0, 1.0);
+
+  // ---- accuracy ----
+  for (uint32_t n = 16; n <= FFT_MAX_N; n *= 2)
+  {
+    std::vector<double> xd(n);
+    std::vector<float> x(n);
+    for (uint32_t i = 0; i < n; i++)
+      x[i] = (float)(xd[i] = gauss(rng));
+    fftReal(x.data(), n);
+    double errSq = 0, refSq = 0;
+    for (uint32_t k = 0; k <= n / 2; k++)
+    {
+      std::complex<long double> s = 0;
+      for (uint32_t i = 0; i < n; i++)
+        s += (long double)xd[i] * std::polar(1.0L, -2.0L * 3.14159265358979323846L * (long double)((uint64_t)k * i % n) / n);
+      const std::complex<double> got = k == 0 ? std::complex<double>(x[0], 0)
+                                       : k == n / 2 ? std::complex<double>(x[1], 0)
+                                                    : std::complex<double>(x[2 * k], x[2 * k + 1]);
+      errSq += std::norm(got - std::complex<double>((double)s.real(), (double)s.imag()));
+      refSq += std::norm(std::complex<double>((double)s.real(), (double)s.imag()));
+    }
+    const double rel = sqrt(errSq / refSq);
+    if (rel > 1e-6)
+    {
+      printf("FAIL fftReal n=%u rel err %g\n", n, rel);
+      failures++;
+    }
+    if (n >= 512)
+      printf("n=%4u: rms rel err vs long double DFT %.2e\n", n, rel);
+  }
+
+  // ---- speed ----
+  for (uint32_t n = 512; n <= FFT_MAX_N; n *= 2)
+  {
+    std::vector<float> src(n), x(n);
+    std::vector<double> re(n), im(n);
+    for (uint32_t i = 0; i < n; i++)
+      src[i] = (float)gauss(rng);
+    volatile float keepF = 0;
+    volatile double keepD = 0;
+    const int reps = 4000000 / n;
+    const double tOurs = usPer([&] {
+      x = src;
+      fftReal(x.data(), n);
+      keepF = x[3];
+    }, reps);
+    const double tArd = usPer([&] {
+      for (uint32_t i = 0; i < n; i++)
+      {
+        re[i] = src[i];
+        im[i] = 0;
+      }
+      arduinoFftCompute(re.data(), im.data(), (uint16_t)n);
+      keepD = re[3];
+    }, reps);
+    (void)keepF;
+    (void)keepD;
+    printf("n=%4u: float32 real FFT %7.2f us, arduinoFFT double %7.2f us (x%.1f)\n", n, tOurs, tArd, tArd / tOurs);
+  }
+
+  // ---- Welch ----
+  const float fs = 1600;
+  const uint32_t total = 1600 * 60;
+  std::vector<float> sig(total);
+  const double amp = 0.25, fSine = 123.4375, sigma = 0.01; // fSine on a bin for n = 1024..4096
+  for (uint32_t i = 0; i < total; i++)
+    sig[i] = (float)(1.0 + amp * sin(2 * M_PI * fSine * i / fs) + sigma * gauss(rng));
+
+  const FftWindow wins[] = {FftWindow::Rect, FftWindow::Hann, FftWindow::Hamming, FftWindow::Blackman,
+                            FftWindow::FlatTop};
+  for (FftWindow w : wins)
+  {
+    WelchPsd p;
+    const uint32_t n = 2048;
+    p.begin(n, w, n / 2);
+    const double us = usPer([&] {
+      p.begin(n, w, n / 2);
+      for (uint32_t i = 0; i < total; i += 256)
+        p.push(&sig[i], 256);
+    }, 3);
+    std::vector<float> a(p.bins()), d(p.bins());
+    for (uint32_t k = 0; k < p.bins(); k++)
+    {
+      a[k] = p.amplitudeAt(k);
+      d[k] = p.psdAt(k, fs);
+    }
+    const uint32_t kSine = (uint32_t)lround(fSine * n / fs);
+    // noise floor: median-free average away from the tone and DC
+    double floor = 0;
+    uint32_t cnt = 0;
+    for (uint32_t k = 400; k < p.bins() - 10; k++, cnt++)
+      floor += d[k];
+    floor /= cnt;
+    const double floorExpect = sigma * sigma * 2 / fs;
+    const bool ok = fabs(a[kSine] - amp) < amp * 0.01 && fabs(floor / floorExpect - 1) < 0.05;
+    if (!ok)
+      failures++;
+    printf("welch %-8s n=%u: %u segments, tone %.4f (expect %.4f), floor %.3e (expect %.3e), enbw %.2f bins, "
+           "60 s @1600 Hz in %.1f ms%s\n",
+           fftWindowName(w), n, p.segments(), a[kSine], amp, floor, floorExpect, p.enbw(), us / 1000,
+           ok ? "" : "  FAIL");
+  }
+
+  // ---- STFT ----
+  {
+    // linear chirp 20 -> 620 Hz over 60 s, 0.1 g (-20 dB)
+    const uint32_t n = 512;
+    std::vector<float> chirp(total);
+    for (uint32_t i = 0; i < total; i++)
+    {
+      const double t = i / fs;
+      chirp[i] = (float)(1.0 + 0.1 * sin(2 * M_PI * (20 * t + 5 * t * t)) + 1e-4 * gauss(rng));
+    }
+    for (uint8_t cell : {1, 2})
+      for (uint32_t hop : {n / 4, 3 * n})
+      {
+        StftFrames st;
+        st.begin(n, hop, FftWindow::Hann, n / 2 + 1, cell, -100, 0);
+        uint32_t rows = 0, worstBin = 0;
+        double worstDb = 0;
+        const double us = usPer([&] {
+          st.begin(n, hop, FftWindow::Hann, n / 2 + 1, cell, -100, 0);
+          rows = 0;
+          worstBin = 0;
+          worstDb = 0;
+          for (uint32_t i = 0; i < total; i += 256)
+            for (uint32_t off = 0; off < 256;)
+            {
+              off += (uint32_t)st.push(&chirp[i + off], 256 - off);
+              if (!st.frameReady())
+                continue;
+              // ridge: loudest cell vs the instantaneous frequency at the centre
+              const uint8_t *r = st.row();
+              uint32_t best = 1, bestV = 0;
+              for (uint32_t k = 1; k < st.bins(); k++)
+              {
+                const uint32_t v = cell == 1 ? r[k] : (uint32_t)(r[2 * k] | r[2 * k + 1] << 8);
+                if (v > bestV)
+                {
+                  bestV = v;
+                  best = k;
+                }
+              }
+              const double tc = (rows * hop + n / 2) / fs;
+              const uint32_t expect = (uint32_t)lround((20 + 10 * tc) * n / fs);
+              const uint32_t dBin = best > expect ? best - expect : expect - best;
+              if (dBin > worstBin)
+                worstBin = dBin;
+              // a sweeping tone loses a little to the window edges, scalloping up to 1.4 dB
+              const double db = st.dbLo() + bestV * st.dbStep();
+              if (fabs(db + 20) > fabs(worstDb))
+                worstDb = db + 20;
+              rows++;
+            }
+        }, 1);
+        const bool ok = rows == stftFrames(total, n, hop) && worstBin <= 1 && fabs(worstDb) < 2.0;
+        if (!ok)
+          failures++;
+        printf("stft u%u n=%u hop=%4u: %u frames, ridge within %u bin, peak %+.2f dB off -20, "
+               "60 s in %.1f ms, %zu B state%s\n",
+               cell * 8, n, hop, rows, worstBin, worstDb, us / 1000,
+               3 * n * sizeof(float) + (n / 2 + 1) * cell, ok ? "" : "  FAIL");
+      }
+  }
+
+  // ---- one pass vs three (what axis=all saves) ----
+  {
+    const uint32_t n = 1024, blockN = 256, seconds = 180;
+    const uint32_t samples = 1600 * seconds;
+    std::vector<uint8_t> file;
+    std::vector<Sample6> blk(blockN);
+    std::vector<uint8_t> enc(recV4MaxBlockBytes(blockN));
+    for (uint32_t i = 0; i < samples; i += blockN)
+    {
+      for (uint32_t k = 0; k < blockN; k++)
+      {
+        const double t = (i + k) / 1600.0;
+        blk[k].ax = (int16_t)(2000 * sin(2 * M_PI * 50 * t) + 40 * gauss(rng));
+        blk[k].ay = (int16_t)(1000 * sin(2 * M_PI * 120 * t) + 40 * gauss(rng));
+        blk[k].az = (int16_t)(4096 + 40 * gauss(rng));
+      }
+      const size_t len = recEncodeBlockV4(blk.data(), blockN, enc.data());
+      file.insert(file.end(), enc.begin(), enc.begin() + len);
+    }
+    float off[3] = {0, 0, 0}, scale[3] = {1, 1, 1};
+    const ConvCoeffs cc = convCoeffs(14, 2, off, scale);
+    std::vector<float> gx(blockN), gy(blockN), gz(blockN), gm(blockN);
+
+    // walks the encoded blocks like RecReader, decode + convert per block
+    // axis 0..2 single, -1 x/y/z, -2 x/y/z/|a|; welch=false: read only
+    auto pass = [&](int axis, WelchPsd &w, bool welch) {
+      size_t pos = 0;
+      while (pos < file.size())
+      {
+        RecBlockHdrV4 bh;
+        memcpy(&bh, &file[pos], sizeof(bh));
+        recDecodeBlockV4(&file[pos + sizeof(bh)], bh.bytes, bh.n, blk.data());
+        pos += sizeof(bh) + bh.bytes;
+        if (axis < 0)
+        {
+          convertSamples(blk.data(), bh.n, 14, 2, cc, gx.data(), gy.data(), gz.data());
+          if (axis == -2)
+            for (uint32_t k = 0; k < bh.n; k++)
+              gm[k] = sqrtf(gx[k] * gx[k] + gy[k] * gy[k] + gz[k] * gz[k]);
+          const float *ch[4] = {gx.data(), gy.data(), gz.data(), gm.data()};
+          w.push(ch, bh.n);
+        }
+        else
+        {
+          convertSamples(blk.data(), bh.n, 14, 2, cc, axis == 0 ? gx.data() : nullptr,
+                         axis == 1 ? gx.data() : nullptr, axis == 2 ? gx.data() : nullptr);
+          if (welch)
+            w.push(gx.data(), bh.n);
+        }
+      }
+    };
+    // decode + convert alone: the part a single pass saves twice
+    WelchPsd w1, w3, w4;
+    const double tRead = usMin([&] { pass(0, w1, false); }, 7);
+    const double tThree = usMin([&] {
+      for (int a = 0; a < 3; a++)
+      {
+        w1.begin(n, FftWindow::Hann, n / 2);
+        pass(a, w1, true);
+      }
+    }, 7);
+    const double tAll = usMin([&] {
+      w3.begin(n, FftWindow::Hann, n / 2, 3);
+      pass(-1, w3, true);
+    }, 7);
+    const double tAllMag = usMin([&] {
+      w4.begin(n, FftWindow::Hann, n / 2, 4);
+      pass(-2, w4, true);
+    }, 7);
+    // paired channels (x + i y) must match the single-axis spectra
+    bool same = true;
+    for (int a = 0; a < 3; a++)
+    {
+      w1.begin(n, FftWindow::Hann, n / 2);
+      pass(a, w1, true);
+      for (uint32_t k = 0; k < w1.bins(); k++)
+      {
+        const float ref = w1.amplitudeAt(k);
+        same &= fabsf(w3.amplitudeAt(k, a) - ref) <= 1e-4f * ref + 1e-7f &&
+                fabsf(w4.amplitudeAt(k, a) - ref) <= 1e-4f * ref + 1e-7f;
+      }
+    }
+    if (!same)
+      failures++;
+    printf("%u s @1600 Hz, n=%u: decode+convert %.1f ms/pass; 3 x single axis %.1f ms, axis=all %.1f ms (%.0f%%), "
+           "with |a| %.1f ms (%.0f%%); RAM %zu / %zu / %zu B%s\n",
+           seconds, n, tRead / 1000, tThree / 1000, tAll / 1000, 100 * tAll / tThree, tAllMag / 1000,
+           100 * tAllMag / tThree, welchBytes(n, 1), welchBytes(n, 3), welchBytes(n, 4),
+           same ? "" : "  FAIL (spectra differ)");
+  }
+
+  printf(failures ? "fft: FAILED\n" : "fft: ok\n");
+  return failures ? 1 : 0;
+}
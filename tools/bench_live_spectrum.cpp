@@ -0,0 +1,166 @@
+// Host check + micro-benchmark of the live spectrum (src/live_spectrum.h):
+//  - a sine centred on a bin reads its peak amplitude (Hann, flat top)
+//  - exponential / linear averaging: noise floor spread shrinks with k,
+//    linear stops after k frames, none follows the last frame
+//  - peak hold keeps a burst that the average forgets
+//  - dB quantisation round trip
+//  - cost per frame
+//
+//   g++ -O2 -std=c++17 -Isrc tools/bench_live_spectrum.cpp -o bench_live_spectrum && ./bench_live_spectrum
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "live_spectrum.h"
+
+static const float FS = 800.0f;
+
+// one frame of a sine at bin `bin` (amplitude a) plus noise (sigma)
+static void fill(LiveSpectrum &s, uint32_t frame, float bin, float a, float sigma, std::mt19937 &rng)
+{
+  std::normal_distribution<float> gauss(0.0f, 1.0f);
+  const uint32_t n = s.n();
+  float *x = s.input();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    const double t = (double)(frame * n / 2 + i);
+    x[i] = 1.0f + a * (float)sin(2 * M_PI * bin * t / n) + sigma * gauss(rng);
+  }
+}
+
+// spread (dB, max - min) of the noise floor away from the tone
+static float floorSpread(const LiveSpectrum &s, uint32_t tone)
+{
+  float lo = 1e9f, hi = -1e9f;
+  for (uint32_t k = 4; k < s.bins(); k++)
+  {
+    if (k + 8 > tone && k < tone + 8)
+      continue;
+    const float db = 20 * log10f(s.amplitudeAt(k));
+    lo = std::min(lo, db);
+    hi = std::max(hi, db);
+  }
+  return hi - lo;
+}
+
+int main()
+{
+  int failures = 0;
+  std::mt19937 rng(5);
+
+  // ---- amplitude ----
+  {
+    bool ok = true;
+    for (FftWindow w : {FftWindow::Hann, FftWindow::FlatTop})
+    {
+      LiveSpectrum s;
+      s.begin(512, w, LiveAvg::None, 1);
+      fill(s, 0, 64, 0.25f, 0, rng);
+      s.frame();
+      const float a = s.amplitudeAt(64);
+      const bool wOk = fabsf(a - 0.25f) < 0.25f * 1e-3f && s.amplitudeAt(0) < 1e-4f;
+      ok = ok && wOk;
+      printf("%-8s sine 0.25 g on bin 64: %.5f g (%.1f Hz)%s\n", fftWindowName(w), a, 64 * FS / 512,
+             wOk ? "" : "  FAIL");
+    }
+    if (!ok)
+      failures++;
+  }
+
+  // ---- averaging ----
+  {
+    LiveSpectrum s;
+    s.begin(512, FftWindow::Hann, LiveAvg::None, 1);
+    fill(s, 0, 100, 0.1f, 0.01f, rng);
+    s.frame();
+    const float spread1 = floorSpread(s, 100);
+
+    s.begin(512, FftWindow::Hann, LiveAvg::Exp, 16);
+    for (uint32_t f = 0; f < 200; f++)
+    {
+      fill(s, f, 100, 0.1f, 0.01f, rng);
+      s.frame();
+    }
+    const float spreadExp = floorSpread(s, 100);
+    const float toneExp = s.amplitudeAt(100);
+
+    s.begin(512, FftWindow::Hann, LiveAvg::Linear, 32);
+    for (uint32_t f = 0; f < 40; f++)
+    {
+      fill(s, f, 100, 0.1f, 0.01f, rng);
+      s.frame();
+    }
+    const float spreadLin = floorSpread(s, 100);
+    const bool ok = spreadExp < spread1 / 2 && spreadLin < spread1 / 2 && s.done() && s.frames() == 32 &&
+                    fabsf(toneExp - 0.1f) < 2e-3f;
+    if (!ok)
+      failures++;
+    printf("floor spread: single %.1f dB, exp k16 %.1f dB, linear k32 %.1f dB (%u frames, done %d); tone %.4f g%s\n",
+           spread1, spreadExp, spreadLin, s.frames(), s.done(), toneExp, ok ? "" : "  FAIL");
+  }
+
+  // ---- peak hold ----
+  {
+    LiveSpectrum s;
+    s.begin(256, FftWindow::Hann, LiveAvg::Exp, 4);
+    for (uint32_t f = 0; f < 60; f++)
+    {
+      fill(s, f, 40, f == 10 ? 0.5f : 0.0f, 0.001f, rng); // one burst early on
+      s.frame();
+    }
+    const bool ok = fabsf(s.peakAt(40) - 0.5f) < 0.01f && s.amplitudeAt(40) < 0.01f;
+    bool ge = true;
+    for (uint32_t k = 0; k < s.bins(); k++)
+      ge = ge && s.peakAt(k) >= s.amplitudeAt(k) * 0.999f;
+    if (!ok || !ge)
+      failures++;
+    printf("peak hold: burst 0.5 g kept at %.4f g, average now %.5f g, peak >= average %d%s\n", s.peakAt(40),
+           s.amplitudeAt(40), ge, ok && ge ? "" : "  FAIL");
+    s.reset();
+    if (s.peakAt(40) != 0 || s.frames())
+    {
+      failures++;
+      printf("reset: FAIL\n");
+    }
+  }
+
+  // ---- quantisation ----
+  {
+    LiveSpectrum s;
+    s.begin(256, FftWindow::Hann, LiveAvg::None, 1);
+    fill(s, 0, 20, 0.01f, 0, rng); // -40 dB
+    s.frame();
+    std::vector<uint8_t> c8(s.bins()), c16(2 * s.bins());
+    const float lo = -100, step8 = 100 / 255.0f, step16 = 100 / 65535.0f;
+    s.quantise(c8.data(), s.bins(), false, 1, lo, step8);
+    s.quantise(c16.data(), s.bins(), false, 2, lo, step16);
+    const float db8 = lo + c8[20] * step8, db16 = lo + (c16[40] | c16[41] << 8) * step16;
+    const bool ok = fabsf(db8 + 40) <= step8 && fabsf(db16 + 40) < 0.01f && sizeof(LiveFftHdr) == 40;
+    if (!ok)
+      failures++;
+    printf("quantised -40 dB tone: u8 %.2f dB, u16 %.3f dB%s\n", db8, db16, ok ? "" : "  FAIL");
+  }
+
+  // ---- cost ----
+  for (uint32_t n : {256u, 512u, 1024u})
+  {
+    LiveSpectrum s;
+    s.begin(n, FftWindow::Hann, LiveAvg::Exp, 8);
+    const uint32_t frames = 4000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t f = 0; f < frames; f++)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        s.input()[i] = (float)((i * 37 + f) % 101);
+      s.frame();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    printf("N %4u: %.2f us per frame (fill + window + FFT + average)\n", n,
+           std::chrono::duration<double, std::micro>(t1 - t0).count() / frames);
+  }
+
+  printf(failures ? "live spectrum: FAILED\n" : "live spectrum: ok\n");
+  return failures ? 1 : 0;
+}
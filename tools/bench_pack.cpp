@@ -0,0 +1,106 @@
+// Host check + micro-benchmark of the V4 packed codecs (src/rec_pack.h):
+// round trip of quantised random blocks for every res/q combination the
+// device can produce, bytes per sample, and pack/unpack speed next to the
+// Rice codec on the same data.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/bench_pack.cpp -o bench_pack && ./bench_pack
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "rec_pack.h"
+
+static const size_t N = REC_V4_BLOCK_MAX;
+
+// random walk + noise at res bits, then quantised the way captureBlocks does
+static void makeBlock(Sample6 *s, size_t n, uint8_t res, uint8_t shift, uint32_t &seed)
+{
+  const int lim = (1 << (res - 1)) - 1;
+  static int v[3] = {0, 0, 0};
+  for (size_t i = 0; i < n; i++)
+  {
+    int16_t out[3];
+    for (int a = 0; a < 3; a++)
+    {
+      seed = seed * 1664525u + 1013904223u;
+      v[a] += (int)((seed >> 16) % 129) - 64;
+      if (v[a] > lim)
+        v[a] = lim;
+      if (v[a] < -lim - 1)
+        v[a] = -lim - 1;
+      out[a] = (int16_t)(v[a] & ~((1 << shift) - 1));
+    }
+    s[i].ax = out[0];
+    s[i].ay = out[1];
+    s[i].az = out[2];
+  }
+}
+
+template <class F>
+static double nsPerSample(F f, size_t reps)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < reps; r++)
+    f();
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)(reps * N);
+}
+
+int main()
+{
+  struct Case
+  {
+    uint8_t codec, res, q;
+  } cases[] = {
+      {REC_CODEC_PACK12, 14, 12},
+      {REC_CODEC_PACK12, 12, 12},
+      {REC_CODEC_PACK10, 14, 10},
+      {REC_CODEC_PACK10, 12, 10},
+  };
+
+  uint32_t seed = 12345;
+  int failures = 0;
+  std::vector<uint8_t> enc(recV4MaxBlockBytes(N));
+  Sample6 in[N], out[N];
+
+  for (const Case &c : cases)
+  {
+    FileHeaderV3 h{};
+    h.res_bits = c.res;
+    h.q_bits = c.q;
+    const uint8_t shift = recQuantShift(h);
+
+    // every length 1..N (odd PACK12 tails), many blocks
+    for (size_t n = 1; n <= N; n++)
+    {
+      makeBlock(in, n, c.res, shift, seed);
+      size_t len = recEncodeBlock(c.codec, shift, in, n, enc.data());
+      bool ok = len == sizeof(RecBlockHdrV4) + recPackedBytes(c.codec, n) &&
+                recDecodeBlock(c.codec, shift, enc.data() + sizeof(RecBlockHdrV4), len - sizeof(RecBlockHdrV4), n, out);
+      for (size_t i = 0; ok && i < n; i++)
+        ok = in[i].ax == out[i].ax && in[i].ay == out[i].ay && in[i].az == out[i].az;
+      if (!ok)
+      {
+        printf("FAIL codec=%u res=%u q=%u n=%zu\n", c.codec, c.res, c.q, n);
+        failures++;
+        break;
+      }
+    }
+
+    makeBlock(in, N, c.res, shift, seed);
+    size_t packed = 0, rice = 0;
+    const double tPack = nsPerSample([&] { packed = recEncodeBlock(c.codec, shift, in, N, enc.data()); }, 20000);
+    const double tUnpack = nsPerSample([&] { recDecodeBlock(c.codec, shift, enc.data() + 6, packed - 6, N, out); }, 20000);
+    std::vector<uint8_t> encR(recV4MaxBlockBytes(N));
+    const double tRice = nsPerSample([&] { rice = recEncodeBlockV4(in, N, encR.data()); }, 2000);
+    const double tRiceDec = nsPerSample([&] { recDecodeBlockV4(encR.data() + 6, rice - 6, N, out); }, 2000);
+
+    printf("codec=%u res=%u q=%u: %.2f B/sample (raw 6, rice %.2f)  pack %.2f ns  unpack %.2f ns  "
+           "(rice enc %.1f ns, dec %.1f ns per sample)\n",
+           c.codec, c.res, c.q, (double)packed / N, (double)rice / N, tPack, tUnpack, tRice, tRiceDec);
+  }
+
+  printf(failures ? "round trip: FAILED\n" : "round trip: ok\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+// Host check + micro-benchmark of the vibration severity chain
+// (src/vib_severity.h): velocity RMS and displacement p-p of sines against
+// the analytic values across the band, band-edge gains, no drift on an
+// hour of gravity + noise, ISO zone lookup, and cost per sample (3 axes).
+//
+//   g++ -O2 -std=c++17 -Isrc tools/bench_severity.cpp -o bench_severity && ./bench_severity
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "vib_severity.h"
+
+// sine of ampG (g) at f on X, gravity on Z; returns X and Z results
+static void runSine(float fs, float fLo, double f, double ampG, uint32_t samples, float &velX, float &ppX,
+                    float &velZ)
+{
+  VibSeverity v;
+  v.begin(fs, fLo);
+  v.expect(samples);
+  for (uint32_t i = 0; i < samples; i++)
+  {
+    const float g[3] = {(float)(ampG * sin(2 * M_PI * f * i / fs)), 0.0f, 1.0f};
+    v.push(g);
+  }
+  velX = v.velRmsMms(0);
+  ppX = v.dispPpUm(0);
+  velZ = v.velRmsMms(2);
+}
+
+int main()
+{
+  int failures = 0;
+  const float fs = 1600;
+
+  // passband: within 2 % (3 % above fs / 5, integrator error) of
+  // A / (2 pi f) / sqrt 2 and 2 A / (2 pi f)^2
+  // (no exact fs/4: 4 samples per cycle at a fixed phase can miss the peaks)
+  for (float fLo : {10.0f, 2.0f})
+    for (double f : {5.0, 12.5, 25.0, 50.0, 100.0, 200.0, 390.0, 550.0})
+    {
+      if (f < 2.5 * fLo)
+        continue;
+      const double a = 0.5 * 9806.65; // 0.5 g in mm/s^2
+      const double w = 2 * M_PI * f;
+      float vel, pp, velZ;
+      runSine(fs, fLo, f, 0.5, (uint32_t)(fs * 20), vel, pp, velZ);
+      const double velExp = a / w / sqrt(2.0), ppExp = 2 * a / (w * w) * 1000;
+      // near f_lo the displacement high-pass costs a little more
+      const double tolV = f > fs / 5 ? 0.03 : 0.02, tolD = f < 4 * fLo ? 0.08 : f > fs / 5 ? 0.05 : 0.03;
+      const bool ok = fabs(vel / velExp - 1) < tolV && fabs(pp / ppExp - 1) < tolD && velZ < 1e-3;
+      if (!ok)
+        failures++;
+      printf("f_lo %4.1f, %5.1f Hz 0.5 g: vel %8.3f mm/s (exp %8.3f), disp p-p %9.2f um (exp %9.2f), "
+             "gravity axis %.1e mm/s%s\n",
+             fLo, f, vel, velExp, pp, ppExp, velZ, ok ? "" : "  FAIL");
+    }
+
+  // band edges: Butterworth -3 dB at f_lo, stopband well below it
+  {
+    float velEdge, velStop, pp, z;
+    const double a = 0.5 * 9806.65;
+    runSine(fs, 10, 10, 0.5, (uint32_t)(fs * 30), velEdge, pp, z);
+    runSine(fs, 10, 2.5, 0.5, (uint32_t)(fs * 60), velStop, pp, z);
+    const double gEdge = 20 * log10(velEdge / (a / (2 * M_PI * 10) / sqrt(2.0)));
+    const double gStop = 20 * log10(velStop / (a / (2 * M_PI * 2.5) / sqrt(2.0)));
+    const bool ok = fabs(gEdge + 3.0) < 0.5 && gStop < -40;
+    if (!ok)
+      failures++;
+    printf("f_lo 10: gain at 10 Hz %+.2f dB, at 2.5 Hz %+.1f dB%s\n", gEdge, gStop, ok ? "" : "  FAIL");
+  }
+
+  // drift: an hour of 1 g + 2 mg noise on every axis stays at the noise level
+  {
+    std::mt19937 rng(3);
+    std::normal_distribution<float> gauss(0.0f, 0.002f);
+    VibSeverity v;
+    v.begin(fs, 2);
+    const uint32_t samples = (uint32_t)fs * 3600;
+    for (uint32_t i = 0; i < samples; i++)
+    {
+      const float g[3] = {1.0f + gauss(rng), gauss(rng), -1.0f + gauss(rng)};
+      v.push(g);
+    }
+    // white noise integrated over the 2 .. fs/2.56 band
+    double expSq = 0;
+    const double psd = 0.002 * 9806.65 * 0.002 * 9806.65 / (fs / 2);
+    for (double f = 2; f < fs / 2.56; f += 0.01)
+      expSq += psd / ((2 * M_PI * f) * (2 * M_PI * f)) * 0.01;
+    const double velExp = sqrt(expSq);
+    bool ok = true;
+    for (uint8_t a = 0; a < 3; a++)
+      ok = ok && fabs(v.velRmsMms(a) / velExp - 1) < 0.25 && v.dispPpUm(a) < 50;
+    if (!ok)
+      failures++;
+    printf("1 h of gravity + 2 mg noise: vel %.4f %.4f %.4f mm/s (white-noise estimate %.4f), "
+           "disp p-p %.2f %.2f %.2f um%s\n",
+           v.velRmsMms(0), v.velRmsMms(1), v.velRmsMms(2), velExp, v.dispPpUm(0), v.dispPpUm(1), v.dispPpUm(2),
+           ok ? "" : "  FAIL");
+  }
+
+  // zones
+  {
+    const IsoClass *c = isoClassFromName("g2r");
+    const bool ok = c && isoZone(*c, 1.0f) == 'A' && isoZone(*c, 2.0f) == 'B' && isoZone(*c, 4.0f) == 'C' &&
+                    isoZone(*c, 9.0f) == 'D' && !isoClassFromName("V");
+    if (!ok)
+      failures++;
+    printf("iso zones g2r: %s\n", ok ? "ok" : "FAIL");
+  }
+
+  // cost
+  {
+    VibSeverity v;
+    v.begin(fs, 10);
+    const uint32_t samples = 4000000;
+    float g[3] = {0.1f, 0.0f, 1.0f};
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < samples; i++)
+    {
+      g[0] = -g[0];
+      v.push(g);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    printf("%.1f ns per sample (3 axes), %zu B state\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / samples, sizeof(VibSeverity));
+  }
+
+  printf(failures ? "severity: FAILED\n" : "severity: ok\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+// Generates src/decim_taps.h: Kaiser-windowed sinc anti-alias filters for
+// the decimation stage (src/decimator.h), quantised to Q15, and reports the
+// response of the quantised taps.
+//
+//   g++ -O2 -std=c++17 tools/fir_design.cpp -o fir_design && ./fir_design > src/decim_taps.h
+//
+// Per factor M: L = DECIM_TAPS_PER_PHASE * M taps, passband to 0.4 fs_out,
+// stopband from 0.6 fs_out (nothing aliases below the passband edge).
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static const int TAPS_PER_PHASE = 20;
+static const double BETA = 6.2; // Kaiser beta: >= 60 dB stopband at 20 taps per phase
+
+static double besselI0(double x)
+{
+  double sum = 1, term = 1;
+  for (int k = 1; k < 50; k++)
+  {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+static std::vector<int> design(int M)
+{
+  const int L = TAPS_PER_PHASE * M;
+  const double fc = 0.5 / M; // cycles per input sample
+  std::vector<double> h(L);
+  double sum = 0;
+  for (int n = 0; n < L; n++)
+  {
+    const double t = n - (L - 1) / 2.0;
+    const double sinc = (t == 0) ? 2 * fc : sin(2 * M_PI * fc * t) / (M_PI * t);
+    const double r = 2.0 * n / (L - 1) - 1.0;
+    h[n] = sinc * besselI0(BETA * sqrt(1 - r * r)) / besselI0(BETA);
+    sum += h[n];
+  }
+  std::vector<int> q(L);
+  int qsum = 0;
+  for (int n = 0; n < L; n++)
+  {
+    q[n] = (int)lround(h[n] / sum * 32768.0);
+    qsum += q[n];
+  }
+  // exact unity DC gain: fix the rounding on the two centre taps
+  int err = 32768 - qsum;
+  q[L / 2 - 1] += err / 2;
+  q[L / 2] += err - err / 2;
+  return q;
+}
+
+static double gainDb(const std::vector<int> &q, double f)
+{
+  double re = 0, im = 0;
+  for (size_t n = 0; n < q.size(); n++)
+  {
+    re += q[n] * cos(2 * M_PI * f * n);
+    im -= q[n] * sin(2 * M_PI * f * n);
+  }
+  return 20 * log10(sqrt(re * re + im * im) / 32768.0 + 1e-12);
+}
+
+int main()
+{
+  printf("#pragma once\n\n");
+  printf("// Generated by tools/fir_design.cpp - do not edit by hand.\n");
+  printf("// Q15 anti-alias FIR taps for the decimation stage, DC gain exactly 1.\n");
+  printf("// Kaiser beta %.2f, %d taps per phase; passband 0.4 fs_out, stopband 0.6 fs_out.\n", BETA, TAPS_PER_PHASE);
+  printf("#include <stdint.h>\n\n");
+  printf("static const uint16_t DECIM_TAPS_PER_PHASE = %d;\n", TAPS_PER_PHASE);
+
+  const int factors[] = {2, 4, 8, 16};
+  for (int M : factors)
+  {
+    std::vector<int> q = design(M);
+    double ripple = 0, stop = -1000;
+    for (int i = 0; i <= 1000; i++)
+    {
+      const double fp = 0.4 / M * i / 1000.0;
+      double g = gainDb(q, fp);
+      if (fabs(g) > ripple)
+        ripple = fabs(g);
+      const double fs = 0.6 / M + (0.5 - 0.6 / M) * i / 1000.0;
+      g = gainDb(q, fs);
+      if (g > stop)
+        stop = g;
+    }
+    fprintf(stderr, "M=%2d L=%3d passband ripple %.3f dB, stopband %.1f dB\n", M, (int)q.size(), ripple, stop);
+
+    printf("\n// /%d: passband ripple %.3f dB, stopband %.1f dB\n", M, ripple, stop);
+    printf("static const int16_t DECIM_TAPS_%d[%zu] = {", M, q.size());
+    for (size_t n = 0; n < q.size(); n++)
+      printf("%s%s%d", n ? "," : "", (n % 12) ? " " : "\n    ", q[n]);
+    printf("};\n");
+  }
+  return 0;
+}
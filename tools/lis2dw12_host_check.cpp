@@ -0,0 +1,179 @@
+// Host check for lib/LIS2DW12_ESP32: drives LIS2DW12_Host (driver over the
+// in-memory register file) through FIFO bursts, the CTRL shadow cache, bus
+// errors and the calibration math. Exit code = number of failed checks.
+//
+//   g++ -O2 -std=c++17 -Ilib/LIS2DW12_ESP32/src tools/lis2dw12_host_check.cpp lib/LIS2DW12_ESP32/src/LIS2DW12_ESP32.cpp -o lis2dw12_host_check && ./lis2dw12_host_check
+#include <cmath>
+#include <cstdio>
+
+#include "LIS2DW12_ESP32.h"
+
+static int s_fail = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s  %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok)
+    s_fail++;
+}
+
+static bool near(float a, float b, float tol) { return fabsf(a - b) <= tol; }
+
+// Sample i of a test sequence, 14-bit aligned values.
+static void seq(uint32_t i, int16_t out[3])
+{
+  out[0] = (int16_t)(i * 7 - 100);
+  out[1] = (int16_t)(-(int32_t)i * 3);
+  out[2] = (int16_t)(4096 + i);
+}
+
+// The sensor outputs 14-bit data left-justified in 16 bits.
+static void push(LIS2DW12_Host &lis, uint32_t i)
+{
+  int16_t s[3];
+  seq(i, s);
+  lis.bus().pushSample((int16_t)(s[0] * 4), (int16_t)(s[1] * 4), (int16_t)(s[2] * 4));
+}
+
+static void testShadow()
+{
+  LIS2DW12_Host lis;
+  check(lis.begin(), "begin / WHO_AM_I");
+
+  LIS2DW12Base::Config cfg;
+  cfg.odr = LIS2DW12Base::Odr::Hz1600_or_200;
+  cfg.fs = LIS2DW12Base::FullScale::G4;
+  const uint32_t w0 = lis.bus().writes;
+  check(lis.applyConfig(cfg), "applyConfig");
+  check(lis.bus().writes - w0 == 1, "applyConfig: one burst write for the changed span");
+  check(lis.bus().regs[0x20] == 0x95 && (lis.bus().regs[0x25] & 0x30) == 0x10, "applyConfig: CTRL1 / CTRL6 contents");
+
+  const uint32_t tx0 = lis.busTransactions(), r0 = lis.bus().reads, w1 = lis.bus().writes;
+  check(lis.applyConfig(cfg), "applyConfig again");
+  check(lis.setBDU(true) && lis.setAutoIncrement(true), "BDU / IF_ADD_INC again");
+  check(lis.busTransactions() == tx0 && lis.bus().reads == r0 && lis.bus().writes == w1,
+        "unchanged CTRL writes never reach the bus");
+
+  // a failed write must not leave a stale shadow behind
+  lis.bus().failNext = 1;
+  check(!lis.setRateHz(100), "bus error reported");
+  check(lis.setRateHz(100) && (lis.bus().regs[0x20] >> 4) == 0b0101, "write after error reaches the device");
+}
+
+static void testFifo()
+{
+  LIS2DW12_Host lis;
+  lis.begin();
+  check(lis.setFifo(LIS2DW12Base::FifoMode::Continuous, 16), "FIFO continuous, FTH 16");
+
+  LIS2DW12Base::FifoStatus st;
+  for (uint32_t i = 0; i < 20; i++)
+    push(lis, i);
+  check(lis.readFifoStatus(st) && st.level == 20 && st.watermark && !st.overrun, "level 20, watermark, no overrun");
+
+  int16_t got[LIS2DW12Base::FIFO_DEPTH][3];
+  const uint32_t r0 = lis.bus().reads;
+  check(lis.readFifoBurst(got, 20), "burst of 20");
+  check(lis.bus().reads - r0 == 1, "20 samples in one bus read");
+  bool same = true;
+  for (uint32_t i = 0; i < 20; i++)
+  {
+    int16_t e[3];
+    seq(i, e);
+    same &= got[i][0] == e[0] && got[i][1] == e[1] && got[i][2] == e[2];
+  }
+  check(same, "burst data in order, aligned");
+  check(lis.readFifoStatus(st) && st.level == 0, "FIFO empty after drain");
+
+  // continuous: the 33rd sample overwrites the oldest one
+  for (uint32_t i = 100; i < 100 + LIS2DW12Base::FIFO_DEPTH + 1; i++)
+    push(lis, i);
+  check(lis.readFifoStatus(st) && st.level == LIS2DW12Base::FIFO_DEPTH && st.overrun, "overrun flagged");
+  check(lis.readFifoBurst(got, LIS2DW12Base::FIFO_DEPTH), "burst of 32");
+  int16_t e[3];
+  seq(101, e);
+  check(got[0][0] == e[0] && got[0][2] == e[2], "oldest sample dropped on overrun");
+
+  // raw (unaligned) burst keeps the left-justified words
+  push(lis, 5);
+  check(lis.readFifoBurst(got, 1, false), "raw burst");
+  seq(5, e);
+  check(got[0][0] == e[0] * 4 && got[0][1] == e[1] * 4, "raw burst is left-justified");
+
+  // FIFO mode stops when full instead of overwriting
+  check(lis.setFifo(LIS2DW12Base::FifoMode::Bypass) && lis.setFifo(LIS2DW12Base::FifoMode::Fifo), "FIFO mode (stop when full)");
+  for (uint32_t i = 200; i < 240; i++)
+    push(lis, i);
+  check(lis.readFifoBurst(got, LIS2DW12Base::FIFO_DEPTH), "burst of 32 in FIFO mode");
+  seq(200 + LIS2DW12Base::FIFO_DEPTH - 1, e);
+  check(got[LIS2DW12Base::FIFO_DEPTH - 1][0] == e[0], "FIFO mode keeps the first 32 samples");
+
+  lis.bus().failNext = 1;
+  check(!lis.readFifoBurst(got, 4), "burst reports bus error");
+}
+
+static void testCalibration()
+{
+  // static: device at rest, Z up, with an offset on every axis
+  LIS2DW12_Host lis;
+  lis.begin();
+  LIS2DW12Base::Config cfg; // 2 g, high performance: 0.244 mg/LSB
+  lis.applyConfig(cfg);
+  const int16_t ax = 205, ay = -123, az = 4098 + 82; // +0.050, -0.030, 1.020 g
+  lis.bus().pushSample(ax * 4, ay * 4, az * 4);
+  check(lis.calibrateStatic(20, 0, 1.0f), "calibrateStatic");
+  const LIS2DW12Base::Calibration c = lis.getCalibration();
+  check(c.enabled && near(c.offset_g[0], 0.050f, 1e-3f) && near(c.offset_g[1], -0.030f, 1e-3f) &&
+            near(c.offset_g[2], 0.020f, 1e-3f),
+        "static offsets");
+  float g[3];
+  check(lis.readG(g) && near(g[0], 0, 1e-4f) && near(g[1], 0, 1e-4f) && near(g[2], 1.0f, 1e-4f), "calibrated reading");
+
+  // 6-position: offset 0.1 / gain 0.9 on X, similar on Y, Z
+  const float off[3] = {0.1f, -0.05f, 0.02f}, gain[3] = {0.9f, 1.05f, 1.0f};
+  float meas[6][3] = {};
+  for (int axis = 0; axis < 3; axis++)
+  {
+    meas[axis * 2][axis] = off[axis] + gain[axis];
+    meas[axis * 2 + 1][axis] = off[axis] - gain[axis];
+  }
+  check(lis.calibrate6PositionFromAverages(meas), "calibrate6PositionFromAverages");
+  const LIS2DW12Base::Calibration c6 = lis.getCalibration();
+  bool ok = true;
+  for (int axis = 0; axis < 3; axis++)
+    ok &= near(c6.offset_g[axis], off[axis], 1e-5f) && near(c6.scale[axis], 1.0f / gain[axis], 1e-5f);
+  check(ok, "6-position offsets / scales");
+
+  meas[0][0] = meas[1][0] + 0.3f; // +X pose not reached: rejected, calibration kept
+  check(!lis.calibrate6PositionFromAverages(meas) && lis.getCalibration().scale[0] == c6.scale[0], "degenerate poses rejected");
+
+  lis.setAxisScaleFromMeasured(2, 0.98f, 1.0f);
+  check(near(lis.getCalibration().scale[2], 1.0f / 0.98f, 1e-5f), "setAxisScaleFromMeasured");
+
+  // output quantisation left over from a q=12 recording: floors the
+  // samples but must not change the scale
+  lis.clearCalibration();
+  lis.setOutputQuantization(12);
+  lis.bus().pushSample(0, 0, 4098 * 4); // 1.000 g on Z
+  check(lis.readG(g) && near(g[2], 1.0f, 2e-3f), "q=12: Z reads 1 g");
+  check(lis.calibrateStatic(20, 0, 1.0f) && near(lis.getCalibration().offset_g[2], 0, 2e-3f),
+        "q=12: calibrateStatic finds no Z offset");
+  lis.setOutputQuantization(0);
+
+  // 12-bit low-power: other alignment and sensitivity
+  cfg.mode = LIS2DW12Base::Mode::LowPower;
+  cfg.lpMode = LIS2DW12Base::LowPowerMode::LP1_12bit;
+  lis.applyConfig(cfg);
+  lis.clearCalibration();
+  lis.bus().pushSample(1024 * 16, 0, 0); // 1024 LSB * 0.976 mg
+  check(lis.readG(g) && near(g[0], 0.999424f, 1e-5f), "12-bit conversion");
+}
+
+int main()
+{
+  testShadow();
+  testFifo();
+  testCalibration();
+  printf("%s (%d failed)\n", s_fail ? "FAILED" : "all passed", s_fail);
+  return s_fail;
+}
@@ -0,0 +1,199 @@
+// Host decoder for recordings pulled off the device (/download).
+// Reads V3 (raw) or V4 (Rice / bit-packed) .dat and writes either the device's CSV
+// layout or a plain V3 .dat, chosen by the output extension.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/rec_decode.cpp -o rec_decode
+//   ./rec_decode accel250101120000.dat out.csv
+//   ./rec_decode accel250101120000.dat out_v3.dat
+//   ./rec_decode accel250101120000.dat            (header + ratio only)
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "rec_features.h"
+#include "rec_pack.h"
+#include "rec_index.h"
+#include "rec_trailer.h"
+#include "sample_convert.h"
+
+static bool endsWith(const std::string &s, const char *suf)
+{
+  size_t n = strlen(suf);
+  return s.size() >= n && s.compare(s.size() - n, n, suf) == 0;
+}
+
+static bool readAt(FILE *f, uint32_t off, void *dst, size_t len)
+{
+  return fseek(f, (long)off, SEEK_SET) == 0 && fread(dst, 1, len, f) == len;
+}
+
+// Trailing block index, if present: entries CRC checked.
+static bool readIndex(FILE *f, const RecIndexFooter &ft, std::vector<RecIndexEntry> &idx)
+{
+  idx.resize(ft.entries);
+  fseek(f, ft.indexOffset, SEEK_SET);
+  if (fread(idx.data(), sizeof(RecIndexEntry), ft.entries, f) != ft.entries)
+    return false;
+  return recCrc32(0, idx.data(), idx.size() * sizeof(RecIndexEntry)) == ft.crc;
+}
+
+// Whole file -> samples. Stops quietly at a torn last block.
+static bool decodeFile(FILE *f, FileHeaderV4 &h, std::vector<Sample6> &out, long &fileBytes, long &dataEnd)
+{
+  fseek(f, 0, SEEK_END);
+  fileBytes = ftell(f);
+  dataEnd = fileBytes;
+
+  // header version is needed to know where data starts; peek at it first
+  FileHeaderV3 peek;
+  if (fileBytes < (long)sizeof(peek) || !readAt(f, 0, &peek, sizeof(peek)) || !recHeaderOk(peek))
+    return false;
+  const RecTrailer tr = recScanTrailer((uint32_t)fileBytes, recHeaderBytes(peek.version),
+                                       [f](uint32_t off, void *dst, size_t len) { return readAt(f, off, dst, len); });
+  dataEnd = tr.dataEnd;
+  std::vector<RecIndexEntry> idx;
+  if (tr.indexed)
+    fprintf(stderr, "index: %u entries x %u samples, %u samples total%s\n", tr.index.entries, tr.index.blockN,
+            tr.index.samples, readIndex(f, tr.index, idx) ? "" : " (entries CRC mismatch)");
+  const int hi = tr.find("HLTH");
+  RecHealth hl;
+  if (hi >= 0 && tr.chunk[hi].bytes == sizeof(hl) && readAt(f, tr.chunk[hi].offset, &hl, sizeof(hl)) &&
+      recCrc32(0, &hl, sizeof(hl)) == tr.chunk[hi].crc)
+  {
+    fprintf(stderr, "health: i2c=%u skipped=%u dup=%u overrun=%u dropped=%u jitter max=%u us over %u wake-ups (period %u us)\n",
+            hl.i2cErrors, hl.skippedTicks, hl.duplicates, hl.fifoOverruns, hl.ringDropped, hl.jitterMaxUs,
+            hl.wakeups, hl.periodUs);
+    fprintf(stderr, "jitter hist (us):");
+    for (size_t i = 0; i < REC_JITTER_BINS; i++)
+      if (hl.jitter[i] && i + 1 < REC_JITTER_BINS)
+        fprintf(stderr, " <%u:%u", 1u << i, hl.jitter[i]);
+      else if (hl.jitter[i])
+        fprintf(stderr, " >=%u:%u", 1u << (i - 1), hl.jitter[i]);
+    fprintf(stderr, "\n");
+  }
+  const int fi = tr.find("FEAT");
+  RecFeatures ft;
+  if (fi >= 0 && tr.chunk[fi].bytes == sizeof(ft) && readAt(f, tr.chunk[fi].offset, &ft, sizeof(ft)) &&
+      recCrc32(0, &ft, sizeof(ft)) == tr.chunk[fi].crc)
+  {
+    const ConvCoeffs cc = convCoeffsFromHeader(peek);
+    for (int a = 0; a < 3; a++)
+    {
+      const RecFeatureStats st = recFeatureStats(ft, a, cc.k[a], cc.b[a]);
+      fprintf(stderr, "features %c: mean=%.4f rms=%.4f std=%.4f p-p=%.4f g crest=%.2f skew=%.2f kurt=%.2f clip=%u\n",
+              'x' + a, st.mean, st.rms, st.std, st.pp, st.crest, st.skew, st.kurt, st.clip);
+    }
+  }
+  fseek(f, 0, SEEK_SET);
+
+  memset(&h, 0, sizeof(h));
+  if (fread(&h.v3, sizeof(FileHeaderV3), 1, f) != 1 || !recHeaderOk(h.v3))
+    return false;
+
+  if (h.v3.version == 3)
+  {
+    Sample6 s;
+    while (ftell(f) + (long)sizeof(s) <= dataEnd && fread(&s, sizeof(s), 1, f) == 1)
+      out.push_back(s);
+    if (h.v3.samples && out.size() > h.v3.samples)
+      out.resize(h.v3.samples);
+    return true;
+  }
+
+  const size_t tail = sizeof(FileHeaderV4) - sizeof(FileHeaderV3);
+  if (fread((uint8_t *)&h + sizeof(FileHeaderV3), tail, 1, f) != 1 || !recCodecOk(h.codec))
+    return false;
+
+  std::vector<uint8_t> enc(recV4MaxBlockBytes(REC_V4_BLOCK_MAX));
+  Sample6 blk[REC_V4_BLOCK_MAX];
+  RecBlockHdrV4 bh;
+  while (ftell(f) + (long)sizeof(bh) <= dataEnd && fread(&bh, sizeof(bh), 1, f) == 1)
+  {
+    if (bh.sync != REC_V4_SYNC || bh.n == 0 || bh.n > REC_V4_BLOCK_MAX || bh.bytes > enc.size())
+    {
+      fprintf(stderr, "bad block header at %ld, stopping\n", ftell(f) - (long)sizeof(bh));
+      break;
+    }
+    if (fread(enc.data(), 1, bh.bytes, f) != bh.bytes)
+      break; // torn tail (power cut)
+    if (!recDecodeBlock(h.codec, recQuantShift(h.v3), enc.data(), bh.bytes, bh.n, blk))
+    {
+      fprintf(stderr, "corrupt block at sample %zu, stopping\n", out.size());
+      break;
+    }
+    out.insert(out.end(), blk, blk + bh.n);
+  }
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s in.dat [out.csv | out.dat]\n", argv[0]);
+    return 2;
+  }
+
+  FILE *in = fopen(argv[1], "rb");
+  if (!in)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  FileHeaderV4 h;
+  std::vector<Sample6> samples;
+  long fileBytes = 0, dataEnd = 0;
+  bool ok = decodeFile(in, h, samples, fileBytes, dataEnd);
+  fclose(in);
+  if (!ok)
+  {
+    fprintf(stderr, "%s: not a V3/V4 LIS2DW12 recording\n", argv[1]);
+    return 1;
+  }
+
+  const long hdrBytes = recHeaderBytes(h.v3.version);
+  const double ratio = (dataEnd > hdrBytes) ? (double)samples.size() * sizeof(Sample6) / (double)(dataEnd - hdrBytes) : 1.0;
+  fprintf(stderr, "V%u codec=%u rate_hz=%u fs_g=%u res_bits=%u q_bits=%u samples(header)=%u decoded=%zu bytes=%ld ratio=%.2f\n",
+          h.v3.version, h.v3.version == 4 ? h.codec : 0, h.v3.rate_hz, h.v3.fs_g, h.v3.res_bits, h.v3.q_bits,
+          h.v3.samples, samples.size(), fileBytes, ratio);
+
+  if (argc < 3)
+    return 0;
+
+  std::string outPath = argv[2];
+  FILE *out = fopen(outPath.c_str(), "wb");
+  if (!out)
+  {
+    perror(argv[2]);
+    return 1;
+  }
+
+  if (endsWith(outPath, ".dat"))
+  {
+    FileHeaderV3 v3 = h.v3;
+    v3.version = 3;
+    v3.samples = (uint32_t)samples.size();
+    fwrite(&v3, sizeof(v3), 1, out);
+    fwrite(samples.data(), sizeof(Sample6), samples.size(), out);
+  }
+  else
+  {
+    // same columns as /download_csv
+    const unsigned dt_ms = h.v3.rate_hz ? 1000u / h.v3.rate_hz : 0;
+    fprintf(out, "# rate_hz=%u\n# record_s=%u\n# samples=%zu\n# fs_g=%u\n# res_bits=%u\n# q_bits=%u\n# version=%u\n",
+            h.v3.rate_hz, h.v3.record_s, samples.size(), h.v3.fs_g, h.v3.res_bits, h.v3.q_bits, h.v3.version);
+    fprintf(out, "# cal_offset_g=%.6f,%.6f,%.6f\n# cal_scale=%.6f,%.6f,%.6f\n",
+            h.v3.cal_offset_g[0], h.v3.cal_offset_g[1], h.v3.cal_offset_g[2],
+            h.v3.cal_scale[0], h.v3.cal_scale[1], h.v3.cal_scale[2]);
+    fprintf(out, "t_ms,ax_raw,ay_raw,az_raw\n");
+    unsigned long t = 0;
+    for (const Sample6 &s : samples)
+    {
+      fprintf(out, "%lu,%d,%d,%d\n", t, s.ax, s.ay, s.az);
+      t += dt_ms;
+    }
+  }
+  fclose(out);
+  return 0;
+}
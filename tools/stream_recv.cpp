@@ -0,0 +1,164 @@
+// Host receiver for /api/stream: connects to the device's TCP stream and
+// stores it as a plain V3 .dat (same header as a recording), so streamed
+// captures can be diffed / analysed like downloaded ones.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/stream_recv.cpp -o stream_recv
+//   curl "http://<ip>/api/stream?hz=1600&fs=2"
+//   ./stream_recv <ip> out.dat [seconds] [-z]
+//
+// Lost frames (device dropped them, seq jumps) are reported; with -z they
+// are zero-filled so the file keeps the device time base (index / rate_hz).
+// Exit status 3 when anything was lost.
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "stream_format.h"
+
+static bool readAll(int fd, void *dst, size_t len)
+{
+  uint8_t *p = (uint8_t *)dst;
+  while (len)
+  {
+    ssize_t r = recv(fd, p, len, 0);
+    if (r <= 0)
+      return false;
+    p += r;
+    len -= (size_t)r;
+  }
+  return true;
+}
+
+static int connectTo(const char *host, uint16_t port)
+{
+  addrinfo hints{}, *res = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char portStr[8];
+  snprintf(portStr, sizeof(portStr), "%u", port);
+  if (getaddrinfo(host, portStr, &hints, &res) != 0 || !res)
+    return -1;
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0)
+  {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "usage: %s host out.dat [seconds] [-z]\n", argv[0]);
+    return 2;
+  }
+  const char *host = argv[1];
+  const char *outPath = argv[2];
+  double seconds = 0;
+  bool zeroFill = false;
+  for (int i = 3; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-z") == 0)
+      zeroFill = true;
+    else
+      seconds = atof(argv[i]);
+  }
+
+  int fd = connectTo(host, STREAM_PORT);
+  if (fd < 0)
+  {
+    fprintf(stderr, "connect %s:%u failed\n", host, STREAM_PORT);
+    return 1;
+  }
+
+  StreamHello hello;
+  if (!readAll(fd, &hello, sizeof(hello)) || memcmp(hello.magic, "LISSTRM1", 8) != 0 || !recHeaderOk(hello.hdr))
+  {
+    fprintf(stderr, "not a LIS2DW12 stream\n");
+    close(fd);
+    return 1;
+  }
+  FileHeaderV3 h = hello.hdr;
+  fprintf(stderr, "stream: rate_hz=%u fs_g=%u res_bits=%u\n", h.rate_hz, h.fs_g, h.res_bits);
+
+  FILE *out = fopen(outPath, "wb");
+  if (!out)
+  {
+    perror(outPath);
+    close(fd);
+    return 1;
+  }
+  fwrite(&h, sizeof(h), 1, out); // samples patched at the end
+
+  const auto t0 = std::chrono::steady_clock::now();
+  std::vector<Sample6> buf(REC_V4_BLOCK_MAX);
+  const std::vector<Sample6> zeros(REC_V4_BLOCK_MAX);
+  uint64_t bytes = sizeof(hello);
+  uint32_t frames = 0, lostFrames = 0, lostSamples = 0, devDropped = 0;
+  uint32_t expectFirst = 0, expectSeq = 0, samples = 0;
+  bool firstFrame = true;
+
+  StreamFrameHdr fh;
+  while (readAll(fd, &fh, sizeof(fh)))
+  {
+    if (fh.sync != STREAM_SYNC || fh.n == 0 || fh.n > REC_V4_BLOCK_MAX)
+    {
+      fprintf(stderr, "bad frame header after %u frames, stopping\n", frames);
+      break;
+    }
+    if (!readAll(fd, buf.data(), fh.n * sizeof(Sample6)))
+      break;
+    bytes += sizeof(fh) + fh.n * sizeof(Sample6);
+
+    if (!firstFrame && fh.first != expectFirst)
+    {
+      const uint32_t gap = fh.first - expectFirst;
+      lostFrames += fh.seq - expectSeq;
+      lostSamples += gap;
+      fprintf(stderr, "gap: seq %u -> %u, %u samples\n", expectSeq, fh.seq, gap);
+      for (uint32_t left = gap; zeroFill && left;)
+      {
+        uint32_t n = left < zeros.size() ? left : (uint32_t)zeros.size();
+        fwrite(zeros.data(), sizeof(Sample6), n, out);
+        samples += n;
+        left -= n;
+      }
+    }
+    firstFrame = false;
+    expectFirst = fh.first + fh.n;
+    expectSeq = fh.seq + 1;
+    devDropped = fh.dropped;
+
+    fwrite(buf.data(), sizeof(Sample6), fh.n, out);
+    samples += fh.n;
+    frames++;
+
+    const double el = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (seconds > 0 && el >= seconds)
+      break;
+  }
+  close(fd);
+
+  const double el = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  h.samples = samples;
+  h.record_s = h.rate_hz ? (uint16_t)(samples / h.rate_hz) : 0;
+  fseek(out, 0, SEEK_SET);
+  fwrite(&h, sizeof(h), 1, out);
+  fclose(out);
+
+  fprintf(stderr, "%u frames, %u samples in %.1f s: %.1f kB/s, %.0f samples/s\n", frames, samples, el,
+          el > 0 ? bytes / 1024.0 / el : 0.0, el > 0 ? samples / el : 0.0);
+  fprintf(stderr, "lost: %u frames / %u samples (device dropped %u)%s\n", lostFrames, lostSamples, devDropped,
+          zeroFill && lostSamples ? ", zero-filled" : "");
+  return lostSamples ? 3 : 0;
+}